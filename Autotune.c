@@ -0,0 +1,207 @@
+/*
+ * Autotune.c
+ *
+ *  Relay feedback autotuning of PI regulators
+ *
+ *  The experiment runs against the real plant (e.g. closed test lung) in three phases:
+ *  - settle: the output is held at the bias, the actual value is averaged (operating point)
+ *  - step:   the output is held at bias+amplitude, the actual value is averaged (static gain K)
+ *  - relay:  the output toggles between both values around the middle of both operating points,
+ *            the resulting limit cycle gives the ultimate gain Ku and period Tu
+ *
+ *  K, Ku and Tu identify a first order plus dead time model, the PI gains are then calculated
+ *  with the SIMC or IMC rule in the fixed point format of the PID engine (1 ms tick).
+ *  The identification is calculated once in floating point, the per tick part is integer only.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Autotune.h"
+#include <math.h>
+
+	#define AUTOTUNE_SKIP_PERIODS		2		// relay periods until the limit cycle is settled
+	#define AUTOTUNE_EVAL_PERIODS		4		// evaluated relay periods
+	#define AUTOTUNE_RELAY_TIMEOUT		30000	// [ms]
+	#define AUTOTUNE_MIN_TIME_CONSTANT	5.0f	// [ms] min. closed loop time constant
+
+	void autotune_identify(Autotune *at, uint32_t time);
+
+/* start the experiment at the actual operating point (the plant has to be settled at the bias output) */
+bool autotune_start(Autotune *at, int32_t bias, int32_t amplitude, int32_t hysteresis, uint16_t settleTime, uint8_t rule, uint8_t pShift, uint8_t iShift)
+{
+	if ((amplitude <= 0) || (hysteresis < 0) || (settleTime < 2) || (rule > AUTOTUNE_RULE_IMC))
+		return false;
+
+	at->rule = rule;
+	at->pShift = pShift;
+	at->iShift = iShift;
+	at->bias = bias;
+	at->amplitude = amplitude;
+	at->hysteresis = hysteresis;
+	at->settleTime = settleTime;
+	at->output = bias;
+	at->timer = 0;
+	at->actualSum = 0;
+	at->state = AUTOTUNE_STATE_SETTLE;
+
+	return true;
+}
+
+void autotune_abort(Autotune *at)
+{
+	if (autotune_isActive(at))
+		at->state = AUTOTUNE_STATE_FAILED;
+}
+
+bool autotune_isActive(Autotune *at)
+{
+	return (at->state == AUTOTUNE_STATE_SETTLE) || (at->state == AUTOTUNE_STATE_STEP) || (at->state == AUTOTUNE_STATE_RELAY);
+}
+
+/* process one tick (1 ms) of the experiment, returns the output for the plant */
+int32_t autotune_process(Autotune *at, int32_t actual)
+{
+	at->timer++;
+
+	switch(at->state)
+	{
+		case AUTOTUNE_STATE_SETTLE:
+		case AUTOTUNE_STATE_STEP:
+			// average the second half of the settle time
+			if (at->timer > at->settleTime/2)
+				at->actualSum += actual;
+
+			if (at->timer >= at->settleTime)
+			{
+				int32_t average = at->actualSum / (at->settleTime - at->settleTime/2);
+				at->actualSum = 0;
+				at->timer = 0;
+
+				if (at->state == AUTOTUNE_STATE_SETTLE)
+				{
+					at->operatingPoint = average;
+					at->output = at->bias + at->amplitude;
+					at->state = AUTOTUNE_STATE_STEP;
+				}
+				else
+				{
+					at->stepPoint = average;
+					if (at->stepPoint - at->operatingPoint <= 2*at->hysteresis)
+					{
+						// step response too small (or wrong direction) for a relay around the middle
+						at->output = at->bias;
+						at->state = AUTOTUNE_STATE_FAILED;
+					}
+					else
+					{
+						at->output = at->bias;
+						at->periods = 0;
+						at->state = AUTOTUNE_STATE_RELAY;
+					}
+				}
+			}
+			break;
+		case AUTOTUNE_STATE_RELAY:
+			{
+				// relay with hysteresis, each switch to the upper output starts a period
+				int32_t center = (at->operatingPoint + at->stepPoint) / 2;
+
+				if ((at->output == at->bias) && (actual < center - at->hysteresis))
+				{
+					at->output = at->bias + at->amplitude;
+					at->periods++;
+
+					if (at->periods == AUTOTUNE_SKIP_PERIODS+1)
+					{
+						at->periodStart = at->timer;
+						at->actualMax = actual;
+						at->actualMin = actual;
+					}
+					else if (at->periods == AUTOTUNE_SKIP_PERIODS+AUTOTUNE_EVAL_PERIODS+1)
+					{
+						at->output = at->bias;
+						autotune_identify(at, at->timer - at->periodStart);
+						break;
+					}
+				}
+				else if ((at->output != at->bias) && (actual > center + at->hysteresis))
+				{
+					at->output = at->bias;
+				}
+
+				if (at->periods > AUTOTUNE_SKIP_PERIODS)
+				{
+					if (actual > at->actualMax)
+						at->actualMax = actual;
+					if (actual < at->actualMin)
+						at->actualMin = actual;
+				}
+
+				if (at->timer >= AUTOTUNE_RELAY_TIMEOUT)
+				{
+					at->output = at->bias;
+					at->state = AUTOTUNE_STATE_FAILED;
+				}
+			}
+			break;
+		default:
+			break;
+	}
+
+	return at->output;
+}
+
+/* identify the FOPDT model from static gain and limit cycle and calculate the PI gains */
+void autotune_identify(Autotune *at, uint32_t time)
+{
+	float tu = (float) time / AUTOTUNE_EVAL_PERIODS;
+	float a = (at->actualMax - at->actualMin) / 2.0f;
+	float k = (float)(at->stepPoint - at->operatingPoint) / at->amplitude;
+
+	at->ultimatePeriod = tu;
+	at->ultimateAmplitude = at->actualMax - at->actualMin;
+	at->plantGain = k * 1000.0f;
+
+	// ultimate gain of the relay (amplitude/2) describing function
+	float ku = (2.0f * at->amplitude) / (M_PI * a);
+	if ((a <= 0.0f) || (k * ku <= 1.0f))
+	{
+		at->state = AUTOTUNE_STATE_FAILED;
+		return;
+	}
+
+	// |G(jw)| = 1/Ku and arg G(jw) = -pi + asin(h/a) at the oscillation frequency
+	float w = 2.0f * M_PI / tu;
+	float tau = sqrtf(k * ku * k * ku - 1.0f) / w;
+	float hysteresisPhase = (at->hysteresis < a) ? asinf(at->hysteresis / a) : (M_PI / 2.0f);
+	float theta = (M_PI - hysteresisPhase - atanf(tau * w)) / w;
+	if (theta < 1.0f)
+		theta = 1.0f;	// at least one regulation tick
+
+	at->timeConstant = tau;
+	at->deadTime = theta;
+
+	float kc, ti;
+	if (at->rule == AUTOTUNE_RULE_SIMC)
+	{
+		// Skogestad: closed loop time constant = dead time
+		float tc = (theta > AUTOTUNE_MIN_TIME_CONSTANT) ? theta : AUTOTUNE_MIN_TIME_CONSTANT;
+		kc = tau / (k * (tc + theta));
+		ti = (tau < 4.0f * (tc + theta)) ? tau : (4.0f * (tc + theta));
+	}
+	else
+	{
+		// IMC PI with lambda = 1.7 dead time
+		float lambda = (1.7f * theta > AUTOTUNE_MIN_TIME_CONSTANT) ? (1.7f * theta) : AUTOTUNE_MIN_TIME_CONSTANT;
+		kc = (2.0f * tau + theta) / (2.0f * k * lambda);
+		ti = tau + theta / 2.0f;
+	}
+
+	// PID engine: P = Kc * 2^pShift, I per 1 ms tick = Kc/Ti * 2^iShift
+	float p = kc * (float)(1 << at->pShift) + 0.5f;
+	float i = (ti > 0.0f) ? (kc / ti * (float)(1 << at->iShift) + 0.5f) : 0.0f;
+
+	at->pParam = (p > 32767.0f) ? 32767 : p;
+	at->iParam = (i > 32767.0f) ? 32767 : i;
+	at->state = AUTOTUNE_STATE_DONE;
+}
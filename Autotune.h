@@ -0,0 +1,61 @@
+/*
+ * Autotune.h
+ *
+ *  Relay feedback autotuning of PI regulators
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+	#include "TMC-API/tmc/helpers/API_Header.h"
+
+	// autotune states
+	#define AUTOTUNE_STATE_IDLE			0
+	#define AUTOTUNE_STATE_SETTLE		1	// hold the output, measure the operating point
+	#define AUTOTUNE_STATE_STEP			2	// output step, measure the static gain
+	#define AUTOTUNE_STATE_RELAY		3	// relay oscillation between both operating points
+	#define AUTOTUNE_STATE_DONE			4	// model and gains identified
+	#define AUTOTUNE_STATE_FAILED		5
+
+	// tuning rules
+	#define AUTOTUNE_RULE_SIMC			0
+	#define AUTOTUNE_RULE_IMC			1
+
+	typedef struct
+	{
+		uint8_t state;
+		uint8_t rule;
+		uint8_t pShift;				// fixed point format of the tuned PID
+		uint8_t iShift;
+		int32_t bias;				// output at the operating point
+		int32_t amplitude;			// output step and relay amplitude (peak to peak)
+		int32_t hysteresis;
+		uint16_t settleTime;		// [ms] per operating point
+		int32_t output;
+		uint32_t timer;
+		uint32_t periodStart;
+		uint8_t periods;			// relay periods since start
+		int64_t actualSum;
+		int32_t actualMax;			// peaks over the evaluated periods
+		int32_t actualMin;
+		int32_t operatingPoint;		// actual value at the bias output
+		int32_t stepPoint;			// actual value at bias+amplitude output
+
+		// results
+		int32_t ultimatePeriod;		// [ms]
+		int32_t ultimateAmplitude;	// [input units] (peak to peak)
+		int32_t plantGain;			// [1/1000 input units per output unit]
+		int32_t timeConstant;		// [ms]
+		int32_t deadTime;			// [ms]
+		uint16_t pParam;
+		uint16_t iParam;
+	} Autotune;
+
+	bool autotune_start(Autotune *at, int32_t bias, int32_t amplitude, int32_t hysteresis, uint16_t settleTime, uint8_t rule, uint8_t pShift, uint8_t iShift);
+	void autotune_abort(Autotune *at);
+	bool autotune_isActive(Autotune *at);
+	int32_t autotune_process(Autotune *at, int32_t actual);
+
+#endif
@@ -9,48 +9,144 @@
 #include "hal/system/SysTick.h"
 #include "hal/system/SystemInfo.h"
 #include "hal/system/Debug.h"
+#include "hal/system/Recorder.h"
 #include "hal/comm/I2C.h"
+#include "Calibration.h"
+#include "Conversion.h"
+#include "PID.h"
+#include "Estimator.h"
 #include <math.h>
 
 	// === private variables ===
 
 	// general information
-	int16_t gActualMotorTemperature = 0;				// actual motor temperature
-	int16_t	gActualSupplyVoltage = 0;					// actual supply voltage
+	INSTANCE_STATE int16_t gActualMotorTemperature = 0;	// actual motor temperature
+	INSTANCE_STATE int16_t gActualSupplyVoltage = 0;	// actual supply voltage
+
+	// regulators
+	#define PRESSURE_PID_P_SHIFT	8		// P/D divisor 256
+	#define PRESSURE_PID_I_SHIFT	16		// I divisor 65536
+	#define GAIN_SCHEDULE_SHIFT		16		// blended gains q16
+	#define VOLUME_PID_P_SHIFT		4		// P/D divisor 16
+	#define VOLUME_PID_I_SHIFT		12		// I divisor 4096
+	#define FLOW_PID_P_SHIFT		12		// P/D divisor 4096
+	#define FLOW_PID_I_SHIFT		20		// I divisor 1048576
+	#define PID_D_FILTER_SHIFT		3		// D part PT1 filter over 8 ms
+	#define PID_TRACKING_GAIN		128		// anti windup back calculation 0.5
+
+	// pressure sensor calibration
+	#define PRESSURE_ZERO_SAMPLES_SHIFT		8		// average 256 ms for auto zero
+	#define PRESSURE_ZERO_MAX_VELOCITY		100		// [rpm] blower is considered as stopped below
+
+	// one patient circuit: the ventilator state machine drives this axis, the other axes follow its breath phases
+	#define TOSV_AXIS		0
+
+	// sensor bindings: pressure sensor (ADC pin) of each axis, the flow sensor is shared
+	#ifndef PRESSURE_SENSOR_PINS
+		#define PRESSURE_SENSOR_PINS	{ PRESSURE_SENSOR_PIN }
+	#endif
+	const uint8_t pressureSensorPin[NUMBER_OF_MOTORS] = PRESSURE_SENSOR_PINS;
+
+	// context of one axis (blower)
+	typedef struct
+	{
+		// torque regulation
+		int64_t akkuActualTorqueFlux;
+		int32_t actualTorquePT1;
+		int32_t targetTorque;
+		int32_t targetFlux;
+
+		// velocity regulation
+		int32_t	desiredVelocity;			// requested target velocity
+		int32_t actualVelocity;
+		int32_t targetSpeed;
+
+		// pressure regulation
+		int64_t akkuActualPressure;
+		int32_t	desiredPressure;			// requested target pressure
+		int32_t actualPressure;
+		int32_t actualPressurePT1;
+		int32_t targetPressure;
+		PIDControl pressurePID;
+		int32_t pressureFeedForward;		// torque feed forward [mA]
+		int32_t lastTargetPressure;
+		bool isPressureRamp;				// desired pressure is a point of a planner ramp
+		bool wasPressureRamp;				// last target pressure was a point of a planner ramp
+
+		// pressure regulator gain scheduling
+		uint8_t gainScheduleState;			// TOSV state of the selected gain set
+		int32_t gainScheduleP;				// blended P/I gains
+		int32_t gainScheduleI;
+		int32_t gainScheduleStepP;			// gain change per ms
+		int32_t gainScheduleStepI;
+		uint16_t gainScheduleTimer;			// remaining blend time [ms]
+
+		// pressure sensor calibration
+		int32_t pressureCalSlope[PRESSURE_CAL_POINTS-1];	// q16 [Pa per ADC count]
+		uint16_t pressureAdcValue;			// oversampled ADC value
+		uint16_t pressureZeroCounter;		// remaining auto zero samples
+		int64_t pressureZeroSum;
+
+		// volume regulation
+		int32_t	desiredVolume;				// requested target volume
+		int32_t actualVolume;
+		PIDControl volumePID;
+
+		// flow regulation
+		int32_t	desiredFlow;				// requested target flow [ml/min]
+		PIDControl flowPID;
+
+		// state estimation
+		AlphaBetaFilter pressureEstimator;
+		AlphaBetaFilter flowEstimator;
+		int64_t blowerPressureFactor;		// q40 [Pa per rpm^2] (fan law)
+		int64_t lastVelocitySquare;
+
+		// regulator autotuning
+		Autotune autotune;
+		uint8_t autotuneLoop;				// regulator under test
+
+		// cached reciprocals of the motor configuration
+		Reciprocal polePairsReciprocal;
+		Reciprocal dualShuntFactorReciprocal;
+
+		// commutation mode
+		uint8_t	lastSetCommutationMode;		// actual regulation mode
+
+		// motion mode
+		uint32_t motionMode;
+	} BLDC_Axis;
+
+	INSTANCE_STATE BLDC_Axis bldcAxis[NUMBER_OF_MOTORS];
 
-	// torque regulation
-	int64_t akkuActualTorqueFlux[NUMBER_OF_MOTORS];
-	int32_t actualTorquePT1[NUMBER_OF_MOTORS];
-	int32_t gTargetTorque[NUMBER_OF_MOTORS];
-	int32_t gTargetFlux[NUMBER_OF_MOTORS];
+	// general information
+	void bldc_checkSupplyVoltage();
+	void bldc_checkMotorTemperature();
 
-	// velocity regulation
-	int32_t	gDesiredVelocity[NUMBER_OF_MOTORS];			// requested target velocity
-	int32_t gActualVelocity[NUMBER_OF_MOTORS];
-	int32_t gTargetSpeed[NUMBER_OF_MOTORS];
+	// regulation stages of one axis
+	void bldc_updateActualValues(uint8_t motor, bool isFlowSampleValid, bool isPressureSampleValid);
+	void bldc_updateRegulation(uint8_t motor);
+	void bldc_updateOutputs(uint8_t motor);
 
 	// pressure regulation
-	int64_t akkuActualPressure[NUMBER_OF_MOTORS];
-	int32_t	gDesiredPressure[NUMBER_OF_MOTORS];			// requested target pressure
-	int32_t gActualPressure[NUMBER_OF_MOTORS];
-	int32_t actualPressurePT1[NUMBER_OF_MOTORS];
-	int32_t gTargetPressure[NUMBER_OF_MOTORS];
-	PIControl pressurePID[NUMBER_OF_MOTORS];
+	int32_t bldc_calculatePressureFeedForward(uint8_t motor, int32_t targetPressure);
+	uint8_t bldc_getRegulationMotionMode(uint8_t motor, uint32_t mode);
+	void bldc_handoverPressureRegulator(uint8_t motor, int32_t targetPressure);
+	void bldc_updatePressureGainSchedule(uint8_t motor);
 
-	// volume regulation
-	int32_t	gDesiredVolume[NUMBER_OF_MOTORS];			// requested target volume
-	int32_t gActualVolume[NUMBER_OF_MOTORS];
-	PIControl volumePID[NUMBER_OF_MOTORS];
+	// pressure sensor calibration
+	void bldc_updatePressureAutoZero(uint8_t motor, int32_t pressure);
 
-	// commutation mode
-	uint8_t	gLastSetCommutationMode[NUMBER_OF_MOTORS];	// actual regulation mode
+	// flow regulation
+	int32_t bldc_getFlowPressureLimit(uint8_t motor);
 
-	// motion mode
-	uint32_t gMotionMode[NUMBER_OF_MOTORS];
+	// state estimation
+	int32_t bldc_getFeedbackPressure(uint8_t motor);
+	int32_t bldc_getFeedbackFlow(uint8_t motor);
+	int32_t bldc_getFeedbackVolume(uint8_t motor);
 
-	// general information
-	void bldc_checkSupplyVoltage(uint8_t motor);
-	void bldc_checkMotorTemperature();
+	// regulator autotuning
+	void bldc_finishAutotune(uint8_t motor);
 
 
 	// === implementation ===
@@ -60,32 +156,56 @@ void bldc_init()
 	for (int i = 0; i < NUMBER_OF_MOTORS; i++)
 	{
 		// pid controller mode
-		gMotionMode[i] = STOP_MODE;
-		gLastSetCommutationMode[i] = 0xFF;
+		bldcAxis[i].motionMode = STOP_MODE;
+		bldcAxis[i].lastSetCommutationMode = 0xFF;
 
 		// torque mode
-		akkuActualTorqueFlux[i] = 0;
-		actualTorquePT1[i] = 0;
-		gTargetTorque[i] = 0;
-		gTargetFlux[i] = 0;
+		bldcAxis[i].akkuActualTorqueFlux = 0;
+		bldcAxis[i].actualTorquePT1 = 0;
+		bldcAxis[i].targetTorque = 0;
+		bldcAxis[i].targetFlux = 0;
 
 		// velocity mode
-		gDesiredVelocity[i] = 0;
-		gActualVelocity[i] = 0;
-		gTargetSpeed[i] = 0;
+		bldcAxis[i].desiredVelocity = 0;
+		bldcAxis[i].actualVelocity = 0;
+		bldcAxis[i].targetSpeed = 0;
 
 		// pressure mode
-		akkuActualPressure[i] = 0;
-		actualPressurePT1[i] = 0;
-		gDesiredPressure[i] = 0;
-		gActualPressure[i] = 0;
-		gTargetPressure[i] = 0;
-		pressurePID[i].errorSum = 0;
+		bldcAxis[i].akkuActualPressure = 0;
+		bldcAxis[i].actualPressurePT1 = 0;
+		bldcAxis[i].desiredPressure = 0;
+		bldcAxis[i].actualPressure = 0;
+		bldcAxis[i].targetPressure = 0;
+		pid_reset(&bldcAxis[i].pressurePID);
+		bldcAxis[i].pressureFeedForward = 0;
+		bldcAxis[i].lastTargetPressure = 0;
+		bldcAxis[i].isPressureRamp = false;
+		bldcAxis[i].wasPressureRamp = false;
+		bldcAxis[i].gainScheduleState = 0xFF;
+		bldcAxis[i].gainScheduleP = 0;
+		bldcAxis[i].gainScheduleI = 0;
+		bldcAxis[i].gainScheduleTimer = 0;
+		bldcAxis[i].pressureAdcValue = 0;
+		bldcAxis[i].pressureZeroCounter = 0;
+		bldcAxis[i].pressureZeroSum = 0;
 
 		// volume mode
-		gDesiredVolume[i] = 0;
-		gActualVolume[i] = 0;
-		volumePID[i].errorSum = 0;
+		bldcAxis[i].desiredVolume = 0;
+		bldcAxis[i].actualVolume = 0;
+		pid_reset(&bldcAxis[i].volumePID);
+
+		// flow mode
+		bldcAxis[i].desiredFlow = 0;
+		pid_reset(&bldcAxis[i].flowPID);
+
+		// state estimation
+		estimator_reset(&bldcAxis[i].pressureEstimator, 0);
+		estimator_reset(&bldcAxis[i].flowEstimator, 0);
+		bldcAxis[i].lastVelocitySquare = 0;
+
+		// autotuning
+		bldcAxis[i].autotune.state = AUTOTUNE_STATE_IDLE;
+		bldcAxis[i].autotuneLoop = AUTOTUNE_LOOP_PRESSURE;
 
 		// flags
 		flags_init(i);
@@ -94,47 +214,170 @@ void bldc_init()
 
 }
 
-int32_t bldc_getTargetPressureFromVolumePIRegulator(int32_t targetVolume, int32_t actualVolume, PIControl *pid, int32_t maxVolume, int32_t maxPressure, int32_t minPressure)
+/* update the cached reciprocals of pole pairs and dual shunt factor (call on every change) */
+void bldc_updateConversions(uint8_t motor)
 {
-	// limit the target volume
-	targetVolume = tmc_limitInt(targetVolume, 0, maxVolume);
+	conversion_setDivisor(&bldcAxis[motor].polePairsReciprocal, motorConfig[motor].motorPolePairs);
+	conversion_setDivisor(&bldcAxis[motor].dualShuntFactorReciprocal, motorConfig[motor].dualShuntFactor);
+}
 
-	pid->pParam = motorConfig->pidVolume_P_param;
-	pid->iParam = motorConfig->pidVolume_I_param;
+/* update the estimator gains (call on every change of the estimator settings) */
+void bldc_updateEstimatorSettings(uint8_t motor)
+{
+	estimator_setNoiseRatio(&bldcAxis[motor].pressureEstimator, motorConfig[motor].estPressureNoiseRatio);
+	estimator_setNoiseRatio(&bldcAxis[motor].flowEstimator, motorConfig[motor].estFlowNoiseRatio);
+
+	// blower pressure = estBlowerPressure * (velocity / 10000)^2
+	bldcAxis[motor].blowerPressureFactor = ((int64_t)motorConfig[motor].estBlowerPressure << 40) / 100000000;
+}
 
-	int32_t pDivisor = 16;
-	int64_t iDivisor = 4096;
+/* configuration and control state of the axes for the header of a recording */
+void bldc_visitState(Recorder_StateVisitor visit)
+{
+	visit(motorConfig, sizeof(motorConfig));
+	visit(tosvConfig, sizeof(tosvConfig));
+	visit(rampGenerator, sizeof(rampGenerator));
+	flags_visitState(visit);
+
+	visit(bldcAxis, sizeof(bldcAxis));
+	visit(&gActualMotorTemperature, sizeof(gActualMotorTemperature));
+	visit(&gActualSupplyVoltage, sizeof(gActualSupplyVoltage));
 
-	pid->error = targetVolume-actualVolume;
-	pid->errorSum += pid->error;
+	tosv_visitState(visit);
+}
+
+/* Update the regulator parameters (call on every change of the pressure/volume PID settings) */
+void bldc_updateRegulatorSettings(uint8_t motor)
+{
+	// pressure regulator (output: torque or velocity)
+	PIDControl *pid = &bldcAxis[motor].pressurePID;
+	if (motorConfig[motor].pressureCascade == PRESSURE_CASCADE_VELOCITY)
+	{
+		pid->pParam = motorConfig[motor].pidPressureVelocity_P_param;
+		pid->iParam = motorConfig[motor].pidPressureVelocity_I_param;
+	}
+	else if (motorConfig[motor].pidPressureScheduleEnable)
+	{
+		// P/I are blended by the gain scheduling, restart the blend from the actual gains
+		bldcAxis[motor].gainScheduleState = 0xFF;
+	}
+	else
+	{
+		pid->pParam = motorConfig[motor].pidPressure_P_param;
+		pid->iParam = motorConfig[motor].pidPressure_I_param;
+	}
+	bldcAxis[motor].gainScheduleP = (int32_t)pid->pParam << GAIN_SCHEDULE_SHIFT;
+	bldcAxis[motor].gainScheduleI = (int32_t)pid->iParam << GAIN_SCHEDULE_SHIFT;
+	pid->dParam = motorConfig[motor].pidPressure_D_param;
+	pid->pShift = PRESSURE_PID_P_SHIFT;
+	pid->iShift = PRESSURE_PID_I_SHIFT;
+	pid->dFilterShift = PID_D_FILTER_SHIFT;
+	pid->setpointWeight = motorConfig[motor].pidPressureSetpointWeight;
+	pid->trackingGain = PID_TRACKING_GAIN;
+	pid->maxOutputStep = (motorConfig[motor].pressureCascade == PRESSURE_CASCADE_VELOCITY) ? 0 : motorConfig[motor].maxTorqueStep;
+
+	// volume regulator (output: pressure)
+	pid = &bldcAxis[motor].volumePID;
+	pid->pParam = motorConfig[motor].pidVolume_P_param;
+	pid->iParam = motorConfig[motor].pidVolume_I_param;
+	pid->dParam = motorConfig[motor].pidVolume_D_param;
+	pid->pShift = VOLUME_PID_P_SHIFT;
+	pid->iShift = VOLUME_PID_I_SHIFT;
+	pid->dFilterShift = PID_D_FILTER_SHIFT;
+	pid->setpointWeight = motorConfig[motor].pidVolumeSetpointWeight;
+	pid->trackingGain = PID_TRACKING_GAIN;
+	pid->maxOutputStep = 0;
+
+	// flow regulator (output: pressure or torque)
+	pid = &bldcAxis[motor].flowPID;
+	pid->pParam = motorConfig[motor].pidFlow_P_param;
+	pid->iParam = motorConfig[motor].pidFlow_I_param;
+	pid->dParam = 0;
+	pid->pShift = FLOW_PID_P_SHIFT;
+	pid->iShift = FLOW_PID_I_SHIFT;
+	pid->dFilterShift = PID_D_FILTER_SHIFT;
+	pid->setpointWeight = 256;
+	pid->trackingGain = PID_TRACKING_GAIN;
+	pid->maxOutputStep = (motorConfig[motor].pidFlowOutput == FLOW_OUTPUT_TORQUE) ? motorConfig[motor].maxTorqueStep : 0;
+}
+
+/* Blend the pressure regulator P/I gains linearly to the gain set of the actual TOSV state.
+ * The I part is kept in output units by the PID engine, so only the P part changes with the gains.
+ * Only the ventilating axis, the other axes keep their fixed gains. */
+void bldc_updatePressureGainSchedule(uint8_t motor)
+{
+	if ((motor != TOSV_AXIS) || !motorConfig[motor].pidPressureScheduleEnable || (motorConfig[motor].pressureCascade == PRESSURE_CASCADE_VELOCITY))
+		return;
+
+	uint8_t state = tosvConfig[TOSV_AXIS].actualState;
+	if (state >= PRESSURE_GAIN_SETS)
+		state = TOSV_STATE_STOPPED;
+
+	int32_t targetP = (int32_t)motorConfig[motor].pidPressureSchedule_P_param[state] << GAIN_SCHEDULE_SHIFT;
+	int32_t targetI = (int32_t)motorConfig[motor].pidPressureSchedule_I_param[state] << GAIN_SCHEDULE_SHIFT;
+
+	if (state != bldcAxis[motor].gainScheduleState)
+	{
+		// state change: start a new blend from the actual gains
+		bldcAxis[motor].gainScheduleState = state;
+		bldcAxis[motor].gainScheduleTimer = (motorConfig[motor].pidPressureScheduleBlendTime > 0) ? motorConfig[motor].pidPressureScheduleBlendTime : 1;
+		bldcAxis[motor].gainScheduleStepP = (targetP - bldcAxis[motor].gainScheduleP) / bldcAxis[motor].gainScheduleTimer;
+		bldcAxis[motor].gainScheduleStepI = (targetI - bldcAxis[motor].gainScheduleI) / bldcAxis[motor].gainScheduleTimer;
+	}
+
+	if (bldcAxis[motor].gainScheduleTimer > 1)
+	{
+		bldcAxis[motor].gainScheduleTimer--;
+		bldcAxis[motor].gainScheduleP += bldcAxis[motor].gainScheduleStepP;
+		bldcAxis[motor].gainScheduleI += bldcAxis[motor].gainScheduleStepI;
+	}
+	else
+	{
+		// end of blend (or gain set changed): use the exact gain set
+		bldcAxis[motor].gainScheduleTimer = 0;
+		bldcAxis[motor].gainScheduleP = targetP;
+		bldcAxis[motor].gainScheduleI = targetI;
+	}
+
+	bldcAxis[motor].pressurePID.pParam = bldcAxis[motor].gainScheduleP >> GAIN_SCHEDULE_SHIFT;
+	bldcAxis[motor].pressurePID.iParam = bldcAxis[motor].gainScheduleI >> GAIN_SCHEDULE_SHIFT;
+}
+
+int32_t bldc_getTargetPressureFromVolumePIRegulator(int32_t targetVolume, int32_t actualVolume, PIDControl *pid, int32_t maxVolume, int32_t maxPressure, int32_t minPressure)
+{
+	// limit the target volume
+	targetVolume = tmc_limitInt(targetVolume, 0, maxVolume);
+
+	// limit the result to the pressure range between PEEP and max pressure
+	int32_t result = pid_process(pid, targetVolume, actualVolume, minPressure, maxPressure);
 
 	debug_setTestVar1(targetVolume);
 	debug_setTestVar2(maxPressure);
 	debug_setTestVar3(minPressure);
 
 	debug_setTestVar4(pid->error);
-	debug_setTestVar5(pid->errorSum);
-
-	// compute min/max possible errorSum to reach the max regulator output
-	int64_t maxPosErrorSum = (pid->iParam == 0) ? 0: ((int64_t)maxPressure * iDivisor) / (int64_t)pid->iParam;
+	debug_setTestVar5(pid_getIntegral(pid));
 
-	// limit error sum to prevent chasing and stay in positiv area
-	pid->errorSum = tmc_limitS64(pid->errorSum, 0, maxPosErrorSum);
+	return result;
+}
 
-	int pPart = (pid->pParam * pid->error) / pDivisor;
-	int iPart = ((int64_t)pid->iParam * pid->errorSum) / iDivisor;
-	pid->result = pPart + iPart;
+int32_t bldc_getVolumeErrorSum(uint8_t motor)
+{
+	return pid_getIntegral(&bldcAxis[motor].volumePID);
+}
 
-	// limit the result to max alowed torque only in positive direction
-	return tmc_limitInt(pid->result, minPressure, maxPressure);
+/* pressure limit of the flow regulation: the inspiratory pressure limit while ventilating (ventilating axis only) */
+int32_t bldc_getFlowPressureLimit(uint8_t motor)
+{
+	return ((motor == TOSV_AXIS) && tosv_isVentilatorEnabled(&tosvConfig[TOSV_AXIS])) ? (int32_t)tosvConfig[TOSV_AXIS].pLIMIT : motorConfig[motor].maxPressure;
 }
 
-int32_t bldc_getVolumeErrorSum(uint8_t motor)
+int32_t bldc_getFlowErrorSum(uint8_t motor)
 {
-	return volumePID[motor].errorSum;
+	return pid_getIntegral(&bldcAxis[motor].flowPID);
 }
 
-int32_t bldc_getTargetTorqueFromPressurePIRegulator(int32_t targetPressure, int32_t actualPressure, PIControl *pid, int32_t maxPressure, int32_t maxTorque, int32_t minTorque, int32_t actualVelocity)
+int32_t bldc_getTargetTorqueFromPressurePIRegulator(int32_t targetPressure, int32_t actualPressure, PIDControl *pid, int32_t maxPressure, int32_t maxTorque, int32_t minTorque, int32_t actualVelocity, int32_t feedForward)
 {
 	// limit the target pressure
 	targetPressure = tmc_limitInt(targetPressure, 0, maxPressure);
@@ -143,179 +386,380 @@ int32_t bldc_getTargetTorqueFromPressurePIRegulator(int32_t targetPressure, int3
 	if (actualVelocity < 0)
 		minTorque = 0;
 
-	pid->pParam = motorConfig->pidPressure_P_param;
-	pid->iParam = motorConfig->pidPressure_I_param;
+	// limit the result incl. feed forward to max alowed torque
+	return pid_process(pid, targetPressure, actualPressure, minTorque-feedForward, maxTorque-feedForward) + feedForward;
+}
+
+/* Predicted blower torque for the target pressure trajectory and the actual flow.
+ *
+ * Identified blower model: torque = kP * pressure + kSlope * dpressure/dt + kFlow * flow
+ * plus the breath to breath learned torque of the TOSV state machine. The learned torque and the flow
+ * part (the flow sensor measures the patient flow) belong to the ventilating axis only.
+ *
+ * The slope part only follows the ramps of the breath planner (bldc_setTargetPressureRamp()).
+ * Steps of the target pressure (setpoint changes, phase changes, output of the volume regulator)
+ * would kick the torque by kSlope * step for one tick.
+ */
+int32_t bldc_calculatePressureFeedForward(uint8_t motor, int32_t targetPressure)
+{
+	bool isPressureRamp = bldcAxis[motor].isPressureRamp && flags_isStatusFlagSet(motor, PRESSURE_MODE);
+	int32_t slope = (isPressureRamp && bldcAxis[motor].wasPressureRamp) ? targetPressure - bldcAxis[motor].lastTargetPressure : 0;	// [Pa/ms]
+	bldcAxis[motor].lastTargetPressure = targetPressure;
+	bldcAxis[motor].wasPressureRamp = isPressureRamp;
+
+	bool isTosvAxis = (motor == TOSV_AXIS);
+
+	// learned torque of the breath to breath learning
+	int64_t feedForward = isTosvAxis ? tosv_getLearnedTorque() : 0;
+
+	if (motorConfig[motor].ffEnable)
+	{
+		feedForward += ((int64_t)motorConfig[motor].ffPressureGain * targetPressure) >> 10;
+		feedForward += (int64_t)motorConfig[motor].ffSlopeGain * slope;
+		if (isTosvAxis)
+			feedForward += ((int64_t)motorConfig[motor].ffFlowGain * bldc_getFeedbackFlow(motor)) >> 10;
+	}
+
+	return tmc_limitS64(feedForward, -(int32_t)motorConfig[motor].absMaxNegativeCurrent, motorConfig[motor].absMaxPositiveCurrent);
+}
+
+/* continue the pressure regulation with the actual torque (or velocity) */
+void bldc_handoverPressureRegulator(uint8_t motor, int32_t targetPressure)
+{
+	bldcAxis[motor].lastTargetPressure = targetPressure;
+	bldcAxis[motor].wasPressureRamp = false;
 
-	int32_t pDivisor = 256;
-	int64_t iDivisor = 65536;
+	if (motorConfig[motor].pressureCascade == PRESSURE_CASCADE_VELOCITY)
+	{
+		bldcAxis[motor].pressureFeedForward = 0;
+		pid_handover(&bldcAxis[motor].pressurePID, targetPressure, bldc_getFeedbackPressure(motor), bldcAxis[motor].actualVelocity);
+	}
+	else
+	{
+		bldcAxis[motor].pressureFeedForward = bldc_calculatePressureFeedForward(motor, targetPressure);
+		pid_handover(&bldcAxis[motor].pressurePID, targetPressure, bldc_getFeedbackPressure(motor), bldcAxis[motor].actualTorquePT1-bldcAxis[motor].pressureFeedForward);
+	}
+}
 
-	pid->error = targetPressure-actualPressure;
-	pid->errorSum += pid->error;
+/* select the inner loop of the pressure regulator (not while the pressure regulator is running) */
+bool bldc_setPressureCascade(uint8_t motor, uint8_t cascade)
+{
+	if (((cascade != PRESSURE_CASCADE_TORQUE) && (cascade != PRESSURE_CASCADE_VELOCITY)) || bldc_isPressureRegulatorActive(motor))
+		return false;
+
+	motorConfig[motor].pressureCascade = cascade;
+	bldc_updateRegulatorSettings(motor);
+	return true;
+}
+
+int32_t bldc_getPressureFeedForward(uint8_t motor)
+{
+	return bldcAxis[motor].pressureFeedForward;
+}
+
+/* torque of the pressure PID without feed forward [mA] (none in the velocity cascade) */
+int32_t bldc_getPressureFeedbackTorque(uint8_t motor)
+{
+	return (bldc_isPressureRegulatorActive(motor) && (motorConfig[motor].pressureCascade == PRESSURE_CASCADE_TORQUE)) ? bldcAxis[motor].pressurePID.result : 0;
+}
 
-	// compute min/max possible errorSum to reach the max regulator output
-	int64_t maxPosErrorSum = (pid->iParam == 0) ? 0: ((int64_t)maxTorque * iDivisor) / (int64_t)pid->iParam;
-	int64_t maxNegErrorSum = (pid->iParam == 0) ? 0: ((int64_t)minTorque * iDivisor) / (int64_t)pid->iParam;
+/* pressure regulator running (pressure mode or below the volume/flow regulator) */
+bool bldc_isPressureRegulatorActive(uint8_t motor)
+{
+	return flags_isStatusFlagSet(motor, PRESSURE_MODE) || flags_isStatusFlagSet(motor, VOLUME_MODE)
+		|| (flags_isStatusFlagSet(motor, FLOW_MODE) && (motorConfig[motor].pidFlowOutput == FLOW_OUTPUT_PRESSURE));
+}
 
-	// limit error sum to prevent chasing and stay in positiv area
-	pid->errorSum = tmc_limitS64(pid->errorSum, maxNegErrorSum, maxPosErrorSum);
+/* TMC4671 motion mode of a regulation mode: the pressure regulator drives the torque or the velocity PI */
+uint8_t bldc_getRegulationMotionMode(uint8_t motor, uint32_t mode)
+{
+	switch(mode)
+	{
+		case STOP_MODE:
+			return TMC4671_MOTION_MODE_STOPPED;
+		case VELOCITY_MODE:
+			return TMC4671_MOTION_MODE_VELOCITY;
+		case FLOW_MODE:
+			// flow regulator onto the torque or onto the pressure regulator
+			if (motorConfig[motor].pidFlowOutput == FLOW_OUTPUT_TORQUE)
+				return TMC4671_MOTION_MODE_TORQUE;
+			return (motorConfig[motor].pressureCascade == PRESSURE_CASCADE_VELOCITY) ? TMC4671_MOTION_MODE_VELOCITY : TMC4671_MOTION_MODE_TORQUE;
+		case PRESSURE_MODE:
+		case VOLUME_MODE:
+			return (motorConfig[motor].pressureCascade == PRESSURE_CASCADE_VELOCITY) ? TMC4671_MOTION_MODE_VELOCITY : TMC4671_MOTION_MODE_TORQUE;
+		default:
+			return TMC4671_MOTION_MODE_TORQUE;
+	}
+}
 
-	int pPart = (pid->pParam * pid->error) / pDivisor;
-	int iPart = ((int64_t)pid->iParam * pid->errorSum) / iDivisor;
-	pid->result = pPart + iPart;
+/* actual (scheduled) pressure regulator gains */
+uint16_t bldc_getPressurePParam(uint8_t motor)
+{
+	return bldcAxis[motor].pressurePID.pParam;
+}
 
-	// limit the result to max alowed torque
-	return tmc_limitInt(pid->result, minTorque, maxTorque);
+uint16_t bldc_getPressureIParam(uint8_t motor)
+{
+	return bldcAxis[motor].pressurePID.iParam;
 }
 
 int32_t bldc_getPressureErrorSum(uint8_t motor)
 {
-	return pressurePID[motor].errorSum;
+	return pid_getIntegral(&bldcAxis[motor].pressurePID);
 }
 
 /* main regulation function */
 void bldc_processBLDC()
 {
-	static uint32_t lastMsCheckTime = 0;
+	static INSTANCE_STATE uint32_t lastMsCheckTime = 0;
 
 	uint32_t actualTime = systick_getTimer();
 
 	if (actualTime != lastMsCheckTime)
 	{
 		systemInfo_incVelocityLoopCounter();
+		systemInfo_startCycleMeasurement();
+		recorder_beginTick();
+
+		// do ventilator control
+		tosv_process(&tosvConfig[TOSV_AXIS]);
 
+		// shared sensors, sampled once per tick
+		bldc_checkSupplyVoltage();
+		bldc_checkMotorTemperature();
+		bool isFlowSampleValid = tosv_updateFlowSensor();
+		bool isPressureSampleValid = tmcm_getADCSampleReady();
+		if (isPressureSampleValid)
+			recorder_setTickFlag(RECORDER_TICK_PRESSURE_SAMPLE);
+
+		// all axes stage by stage: the regulators of a tick see the actual values of the same instant
 		for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
-		{
-			// do ventilator control
-			tosv_process(&tosvConfig[motor]);
+			bldc_updateActualValues(motor, isFlowSampleValid, isPressureSampleValid);
 
-			bldc_checkSupplyVoltage(motor);
-			bldc_checkMotorTemperature();
-			tosv_updateFlowSensor();
-			gActualVolume[motor] = tosv_updateVolume(motor);
-			bldc_checkCommutationMode(motor);
+		int32_t volume = tosv_updateVolume(TOSV_AXIS);
+		for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+			bldcAxis[motor].actualVolume = volume;
 
-			// always read actual velocity with shaft bit correction
-			int32_t shaftVelocityActual = tmc4671_readInt(motor, TMC4671_PID_VELOCITY_ACTUAL) / motorConfig[motor].motorPolePairs;
+		for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+			bldc_updateRegulation(motor);
+
+		for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+			bldc_updateOutputs(motor);
+
+		systemInfo_stopCycleMeasurement();
+		lastMsCheckTime = actualTime;
+	}
+}
+
+/* read and filter the actual values of one axis */
+void bldc_updateActualValues(uint8_t motor, bool isFlowSampleValid, bool isPressureSampleValid)
+{
+	BLDC_Axis *axis = &bldcAxis[motor];
+
+	estimator_update(&axis->flowEstimator, tosv_getActualFlowValue(), isFlowSampleValid, 0);
+	bldc_checkCommutationMode(motor);
+
+	// always read actual velocity with shaft bit correction
+	int32_t velocityActual = tmc4671_readInt(motor, TMC4671_PID_VELOCITY_ACTUAL);
+	recorder_addInput(RECORDER_INPUT_VELOCITY(motor), velocityActual);
+
+	int32_t shaftVelocityActual = conversion_divide(velocityActual, &axis->polePairsReciprocal);
+	if (motorConfig[motor].shaftBit == 0)
+		shaftVelocityActual = -shaftVelocityActual;
+
+	axis->actualVelocity = (motorConfig[motor].commutationMode == COMM_MODE_FOC_OPEN_LOOP) ? (rampGenerator[motor].rampVelocity) : shaftVelocityActual;
+
+	// always read actual torque+flux and filter
+	int32_t torqueFluxValue  = tmc4671_readInt(motor, TMC4671_PID_TORQUE_FLUX_ACTUAL);
+	int16_t actualFluxRaw    = (torqueFluxValue & 0xFFFF);
+	int16_t actualTorqueRaw  = ((torqueFluxValue >> 16) & 0xFFFF);
+	recorder_addInput(RECORDER_INPUT_TORQUE(motor), actualTorqueRaw);
+	recorder_addInput(RECORDER_INPUT_FLUX(motor), actualFluxRaw);
+
+	if ((actualTorqueRaw > -32000) && (actualTorqueRaw < 32000) && (actualFluxRaw > -32000) && (actualFluxRaw < 32000))
+	{
+		int32_t actualCurrent = (((int32_t)actualTorqueRaw+(int32_t)actualFluxRaw) * (int32_t)motorConfig[motor].dualShuntFactor) / 256;
+
+		if (motorConfig[motor].commutationMode != COMM_MODE_FOC_OPEN_LOOP)
+		{
+			// make shaft bit correction
 			if (motorConfig[motor].shaftBit == 0)
-				shaftVelocityActual = -shaftVelocityActual;
+				actualCurrent = -actualCurrent;
+		}
 
-			gActualVelocity[motor] = (motorConfig[motor].commutationMode == COMM_MODE_FOC_OPEN_LOOP) ? (rampGenerator[motor].rampVelocity) : shaftVelocityActual;
+		axis->actualTorquePT1 = tmc_filterPT1(&axis->akkuActualTorqueFlux, actualCurrent, axis->actualTorquePT1, 1/*4*/, 8);
+	}
 
-			// always read actual torque+flux and filter
-			int32_t torqueFluxValue  = tmc4671_readInt(motor, TMC4671_PID_TORQUE_FLUX_ACTUAL);
-			int16_t actualFluxRaw    = (torqueFluxValue & 0xFFFF);
-			int16_t actualTorqueRaw  = ((torqueFluxValue >> 16) & 0xFFFF);
+	// read actual pressure once per tick from the oversampled ADC value (16x 12 bit)
+	if (isPressureSampleValid)
+	{
+		axis->pressureAdcValue = tmcm_getModuleSpecificOversampledADCValue(pressureSensorPin[motor]);
+		recorder_addInput(RECORDER_INPUT_PRESSURE_ADC(motor), axis->pressureAdcValue);
 
-			if ((actualTorqueRaw > -32000) && (actualTorqueRaw < 32000) && (actualFluxRaw > -32000) && (actualFluxRaw < 32000))
-			{
-				int32_t actualCurrent = (((int32_t)actualTorqueRaw+(int32_t)actualFluxRaw) * (int32_t)motorConfig[motor].dualShuntFactor) / 256;
+		int32_t pressure = calibration_interpolate(axis->pressureAdcValue, motorConfig[motor].pressureCalAdc, motorConfig[motor].pressureCalPressure, axis->pressureCalSlope, PRESSURE_CAL_POINTS);
 
-				if (motorConfig[motor].commutationMode != COMM_MODE_FOC_OPEN_LOOP)
-				{
-					// make shaft bit correction
-					if (motorConfig[motor].shaftBit == 0)
-						actualCurrent = -actualCurrent;
-				}
+		bldc_updatePressureAutoZero(motor, pressure);
 
-				actualTorquePT1[motor] = tmc_filterPT1(&akkuActualTorqueFlux[motor], actualCurrent, actualTorquePT1[motor], 1/*4*/, 8);
-			}
+		pressure -= motorConfig[motor].pressureCalOffset;
+		axis->actualPressure = (pressure < 0) ? 0 : pressure;
+	}
 
-			// always read actual pressure
-			int32_t pressure = ((int32_t)tmcm_getModuleSpecificADCValue(PRESSURE_SENSOR_PIN)*25000)/517-20000; // todo: adjustable offset parameter needed (ED)
-			gActualPressure[motor] = (pressure < 0) ? 0 : pressure;
+	// use filtered value for user interface
+	axis->actualPressurePT1 = tmc_filterPT1(&axis->akkuActualPressure, axis->actualPressure, axis->actualPressurePT1, 2, 8);
 
-			// use filtered value for user interface
-			actualPressurePT1[motor] = tmc_filterPT1(&akkuActualPressure[motor], gActualPressure[motor], actualPressurePT1[motor], 2, 8);
+	// estimate the pressure with the blower pressure change by the speed change as model input
+	int64_t velocitySquare = (int64_t)axis->actualVelocity * axis->actualVelocity;
+	estimator_update(&axis->pressureEstimator, axis->actualPressure, isPressureSampleValid, ((velocitySquare - axis->lastVelocitySquare) * axis->blowerPressureFactor) >> 24);
+	axis->lastVelocitySquare = velocitySquare;
+}
 
-			// ramp handling
+/* ramp handling and regulators of one axis */
+void bldc_updateRegulation(uint8_t motor)
+{
+	BLDC_Axis *axis = &bldcAxis[motor];
 
-			if (flags_isStatusFlagSet(motor, VOLUME_MODE))
-			{
-				debug_setTestVar0(gDesiredVolume[motor]);
-				gDesiredPressure[motor] = bldc_getTargetPressureFromVolumePIRegulator(gDesiredVolume[motor], gActualVolume[motor], &volumePID[motor], tosvConfig[motor].volumeMax, motorConfig[motor].maxPressure, tosvConfig[motor].pPEEP);
-			}
+	if (flags_isStatusFlagSet(motor, VOLUME_MODE))
+	{
+		debug_setTestVar0(axis->desiredVolume);
+		if (autotune_isActive(&axis->autotune) && (axis->autotuneLoop == AUTOTUNE_LOOP_VOLUME))
+		{
+			// relay experiment on the volume regulator (pressure regulator stays closed)
+			axis->desiredPressure = tmc_limitInt(autotune_process(&axis->autotune, bldc_getFeedbackVolume(motor)), 0, motorConfig[motor].maxPressure);
+			if (!autotune_isActive(&axis->autotune))
+				bldc_finishAutotune(motor);
+		}
+		else
+		{
+			axis->desiredPressure = bldc_getTargetPressureFromVolumePIRegulator(axis->desiredVolume, bldc_getFeedbackVolume(motor), &axis->volumePID, tosvConfig[TOSV_AXIS].volumeMax, motorConfig[motor].maxPressure, tosvConfig[TOSV_AXIS].pPEEP);
+		}
+	}
 
-			if (flags_isStatusFlagSet(motor, PRESSURE_MODE) || flags_isStatusFlagSet(motor, VOLUME_MODE))
-			{
-				// no ramp for pressure up to now
-				gTargetPressure[motor] = gDesiredPressure[motor];
+	if (flags_isStatusFlagSet(motor, FLOW_MODE))
+	{
+		if (motorConfig[motor].pidFlowOutput == FLOW_OUTPUT_PRESSURE)
+		{
+			// flow pi regulation onto the pressure regulator
+			axis->desiredPressure = pid_process(&axis->flowPID, axis->desiredFlow, bldc_getFeedbackFlow(motor), 0, bldc_getFlowPressureLimit(motor));
+		}
+		else
+		{
+			// flow pi regulation onto the torque, no positive torque above the pressure limit
+			int32_t maxTorque = (axis->actualPressure < bldc_getFlowPressureLimit(motor)) ? motorConfig[motor].absMaxPositiveCurrent : 0;
+			int32_t minTorque = (axis->actualVelocity < 0) ? 0 : -(int32_t)motorConfig[motor].absMaxNegativeCurrent;
+			axis->targetTorque = pid_process(&axis->flowPID, axis->desiredFlow, bldc_getFeedbackFlow(motor), minTorque, maxTorque);
+
+			// update ramp generator for velocity control to keep actual velocity as ramp velocity
+			rampGenerator[motor].targetVelocity = axis->actualVelocity;
+			rampGenerator[motor].rampVelocity = axis->actualVelocity;
+			axis->targetSpeed = axis->actualVelocity;
+		}
+	}
 
-				// pressure pi regulation
-				gTargetTorque[motor] = bldc_getTargetTorqueFromPressurePIRegulator(gTargetPressure[motor], gActualPressure[motor], &pressurePID[motor], motorConfig[motor].maxPressure, motorConfig[motor].absMaxPositiveCurrent, -(int32_t)motorConfig[motor].absMaxNegativeCurrent, gActualVelocity[motor]);
+	if (bldc_isPressureRegulatorActive(motor))
+	{
+		// no ramp for pressure up to now
+		axis->targetPressure = axis->desiredPressure;
 
-				// update ramp generator for velocity control to keep actual velocity as ramp velocity
-				rampGenerator[motor].targetVelocity = gActualVelocity[motor];
-				rampGenerator[motor].rampVelocity = gActualVelocity[motor];
-				gTargetSpeed[motor] = gActualVelocity[motor];
-			}
+		if (autotune_isActive(&axis->autotune) && (axis->autotuneLoop == AUTOTUNE_LOOP_PRESSURE))
+		{
+			// relay experiment on the pressure regulator
+			axis->targetTorque = tmc_limitInt(autotune_process(&axis->autotune, bldc_getFeedbackPressure(motor)), -(int32_t)motorConfig[motor].absMaxNegativeCurrent, motorConfig[motor].absMaxPositiveCurrent);
+			if (axis->actualPressure > motorConfig[motor].maxPressure)
+				autotune_abort(&axis->autotune);
+			if (!autotune_isActive(&axis->autotune))
+				bldc_finishAutotune(motor);
+		}
+		else if (motorConfig[motor].pressureCascade == PRESSURE_CASCADE_VELOCITY)
+		{
+			// pressure pi regulation onto the velocity PI of the TMC4671 (blower inertia and load in the inner loop)
+			axis->targetSpeed = pid_process(&axis->pressurePID, tmc_limitInt(axis->targetPressure, 0, motorConfig[motor].maxPressure), bldc_getFeedbackPressure(motor), 0, motorConfig[motor].maxVelocity);
+		}
+		else
+		{
+			// pressure pi regulation
+			bldc_updatePressureGainSchedule(motor);
+			axis->pressureFeedForward = bldc_calculatePressureFeedForward(motor, axis->targetPressure);
+			axis->targetTorque = bldc_getTargetTorqueFromPressurePIRegulator(axis->targetPressure, bldc_getFeedbackPressure(motor), &axis->pressurePID, motorConfig[motor].maxPressure, motorConfig[motor].absMaxPositiveCurrent, -(int32_t)motorConfig[motor].absMaxNegativeCurrent, axis->actualVelocity, axis->pressureFeedForward);
+			axis->targetSpeed = axis->actualVelocity;
+		}
 
-			if (flags_isStatusFlagSet(motor, VELOCITY_MODE))
-			{
-				// ramp generator for velocity control
-				rampGenerator[motor].targetVelocity = gDesiredVelocity[motor];
-				tmc_linearRamp_computeRampVelocity(&rampGenerator[motor]);
-				gTargetSpeed[motor] = rampGenerator[motor].rampVelocity;
-			}
+		// update ramp generator for velocity control to keep the target velocity as ramp velocity
+		rampGenerator[motor].targetVelocity = axis->targetSpeed;
+		rampGenerator[motor].rampVelocity = axis->targetSpeed;
+	}
 
-			if (flags_isStatusFlagSet(motor, TORQUE_MODE))
-			{
-				// update ramp generator for velocity control to keep actual velocity as ramp velocity
-				rampGenerator[motor].targetVelocity = gActualVelocity[motor];
-				rampGenerator[motor].rampVelocity = gActualVelocity[motor];
-				gTargetSpeed[motor] = gActualVelocity[motor];
-			}
+	if (flags_isStatusFlagSet(motor, VELOCITY_MODE))
+	{
+		// ramp generator for velocity control
+		rampGenerator[motor].targetVelocity = axis->desiredVelocity;
+		tmc_linearRamp_computeRampVelocity(&rampGenerator[motor]);
+		axis->targetSpeed = rampGenerator[motor].rampVelocity;
+	}
 
-			if (flags_isStatusFlagSet(motor, STOP_MODE))
-			{
-				// nothing to do here
-			}
-			else
-			{
-				if (motorConfig[motor].commutationMode == COMM_MODE_FOC_OPEN_LOOP)
-				{
-					tmc4671_switchToMotionMode(motor, TMC4671_MOTION_MODE_TORQUE);
+	if (flags_isStatusFlagSet(motor, TORQUE_MODE))
+	{
+		// update ramp generator for velocity control to keep actual velocity as ramp velocity
+		rampGenerator[motor].targetVelocity = axis->actualVelocity;
+		rampGenerator[motor].rampVelocity = axis->actualVelocity;
+		axis->targetSpeed = axis->actualVelocity;
+	}
+}
+
+/* write the targets of one axis to the TMC4671 */
+void bldc_updateOutputs(uint8_t motor)
+{
+	BLDC_Axis *axis = &bldcAxis[motor];
+
+	if (flags_isStatusFlagSet(motor, STOP_MODE))
+	{
+		// nothing to do here
+	}
+	else
+	{
+		if (motorConfig[motor].commutationMode == COMM_MODE_FOC_OPEN_LOOP)
+		{
+			tmc4671_switchToMotionMode(motor, TMC4671_MOTION_MODE_TORQUE);
+
+			int32_t targetFlux = (axis->targetSpeed == 0) ? 0 : motorConfig[motor].openLoopCurrent;
 
-					int32_t targetFlux = (gTargetSpeed[motor] == 0) ? 0 : motorConfig[motor].openLoopCurrent;
+			// do not use shaft bit corrected here!
+			TMC4671_FIELD_UPDATE(motor, TMC4671_PID_TORQUE_FLUX_TARGET, TMC4671_PID_FLUX_TARGET_MASK, TMC4671_PID_FLUX_TARGET_SHIFT, conversion_divide(targetFlux * 256, &axis->dualShuntFactorReciprocal));
 
-					// do not use shaft bit corrected here!
-					TMC4671_FIELD_UPDATE(motor, TMC4671_PID_TORQUE_FLUX_TARGET, TMC4671_PID_FLUX_TARGET_MASK, TMC4671_PID_FLUX_TARGET_SHIFT, (targetFlux * 256) / (int32_t)motorConfig[motor].dualShuntFactor);
+			// and no target torque
+			TMC4671_FIELD_UPDATE(motor, TMC4671_PID_TORQUE_FLUX_TARGET, TMC4671_PID_TORQUE_TARGET_MASK, TMC4671_PID_TORQUE_TARGET_SHIFT, 0);
 
-					// and no target torque
-					TMC4671_FIELD_UPDATE(motor, TMC4671_PID_TORQUE_FLUX_TARGET, TMC4671_PID_TORQUE_TARGET_MASK, TMC4671_PID_TORQUE_TARGET_SHIFT, 0);
+			// update target velocity (shaft bit corrected)
+			int32_t shaftTargetVelocity = (motorConfig[motor].shaftBit == 0) ? -axis->targetSpeed : axis->targetSpeed;
+			tmc4671_writeInt(motor, TMC4671_OPENLOOP_VELOCITY_TARGET, shaftTargetVelocity);
+		}
+		else if (motorConfig[motor].commutationMode == COMM_MODE_FOC_DIGITAL_HALL)
+		{
+			if (flags_isStatusFlagSet(motor, MODULE_INITIALIZED))
+			{
+				uint8_t motionMode = bldc_getRegulationMotionMode(motor, axis->motionMode);
 
-					// update target velocity (shaft bit corrected)
-					int32_t shaftTargetVelocity = (motorConfig[motor].shaftBit == 0) ? -gTargetSpeed[motor] : gTargetSpeed[motor];
-					tmc4671_writeInt(motor, TMC4671_OPENLOOP_VELOCITY_TARGET, shaftTargetVelocity);
+				if (motionMode == TMC4671_MOTION_MODE_VELOCITY)
+				{
+					// set new target velocity (shaft bit corrected)
+					int32_t shaftTargetVelocity = (motorConfig[motor].shaftBit == 0) ? -axis->targetSpeed : axis->targetSpeed;
+					tmc4671_writeInt(motor, TMC4671_PID_VELOCITY_TARGET, shaftTargetVelocity * motorConfig[motor].motorPolePairs);
+
+					// update target flux (shaft bit corrected)
+					int32_t shaftTargetFlux   = (motorConfig[motor].shaftBit == 0) ? -axis->targetFlux : axis->targetFlux;
+					TMC4671_FIELD_UPDATE(motor, TMC4671_PID_TORQUE_FLUX_TARGET, TMC4671_PID_FLUX_TARGET_MASK, TMC4671_PID_FLUX_TARGET_SHIFT, conversion_divide(shaftTargetFlux * 256, &axis->dualShuntFactorReciprocal));
 				}
-				else if (motorConfig[motor].commutationMode == COMM_MODE_FOC_DIGITAL_HALL)
+				else if (motionMode == TMC4671_MOTION_MODE_TORQUE)
 				{
-					if (flags_isStatusFlagSet(motor, MODULE_INITIALIZED))
-					{
-						if (gMotionMode[motor] == VELOCITY_MODE)
-						{
-							// set new target velocity (shaft bit corrected)
-							int32_t shaftTargetVelocity = (motorConfig[motor].shaftBit == 0) ? -gTargetSpeed[motor] : gTargetSpeed[motor];
-							tmc4671_writeInt(motor, TMC4671_PID_VELOCITY_TARGET, shaftTargetVelocity * motorConfig[motor].motorPolePairs);
-
-							// update target flux (shaft bit corrected)
-							int32_t shaftTargetFlux   = (motorConfig[motor].shaftBit == 0) ? -gTargetFlux[motor] : gTargetFlux[motor];
-							TMC4671_FIELD_UPDATE(motor, TMC4671_PID_TORQUE_FLUX_TARGET, TMC4671_PID_FLUX_TARGET_MASK, TMC4671_PID_FLUX_TARGET_SHIFT, (shaftTargetFlux * 256) / (int32_t)motorConfig[motor].dualShuntFactor);
-						}
-						else if ((gMotionMode[motor] == TORQUE_MODE) || (gMotionMode[motor] == PRESSURE_MODE) || (gMotionMode[motor] == VOLUME_MODE))
-						{
-							// set new target torque (shaft bit corrected)
-							int32_t shaftTargetTorque = (motorConfig[motor].shaftBit == 0) ? -gTargetTorque[motor] : gTargetTorque[motor];
-							TMC4671_FIELD_UPDATE(motor, TMC4671_PID_TORQUE_FLUX_TARGET, TMC4671_PID_TORQUE_TARGET_MASK, TMC4671_PID_TORQUE_TARGET_SHIFT, (shaftTargetTorque* 256) / (int32_t)motorConfig[motor].dualShuntFactor);
-
-							// update target flux (shaft bit corrected)
-							int32_t shaftTargetFlux   = (motorConfig[motor].shaftBit == 0) ? -gTargetFlux[motor] : gTargetFlux[motor];
-							TMC4671_FIELD_UPDATE(motor, TMC4671_PID_TORQUE_FLUX_TARGET, TMC4671_PID_FLUX_TARGET_MASK, TMC4671_PID_FLUX_TARGET_SHIFT, (shaftTargetFlux * 256) / (int32_t)motorConfig[motor].dualShuntFactor);
-						}
-					}
+					// set new target torque (shaft bit corrected)
+					int32_t shaftTargetTorque = (motorConfig[motor].shaftBit == 0) ? -axis->targetTorque : axis->targetTorque;
+					TMC4671_FIELD_UPDATE(motor, TMC4671_PID_TORQUE_FLUX_TARGET, TMC4671_PID_TORQUE_TARGET_MASK, TMC4671_PID_TORQUE_TARGET_SHIFT, conversion_divide(shaftTargetTorque * 256, &axis->dualShuntFactorReciprocal));
+
+					// update target flux (shaft bit corrected)
+					int32_t shaftTargetFlux   = (motorConfig[motor].shaftBit == 0) ? -axis->targetFlux : axis->targetFlux;
+					TMC4671_FIELD_UPDATE(motor, TMC4671_PID_TORQUE_FLUX_TARGET, TMC4671_PID_FLUX_TARGET_MASK, TMC4671_PID_FLUX_TARGET_SHIFT, conversion_divide(shaftTargetFlux * 256, &axis->dualShuntFactorReciprocal));
 				}
 			}
 		}
-		lastMsCheckTime = actualTime;
 	}
 }
 
@@ -326,24 +770,30 @@ int16_t bldc_getSupplyVoltage()
 	return gActualSupplyVoltage;
 }
 
-/* observe over-/under-voltage and disable driver if necessary */
-void bldc_checkSupplyVoltage(uint8_t motor)
+/* observe over-/under-voltage and disable driver if necessary (shared supply of all axes) */
+void bldc_checkSupplyVoltage()
 {
-	gActualSupplyVoltage = (VOLTAGE_FAKTOR*tmcm_getModuleSpecificADCValue(ADC_VOLTAGE))/4095;
+	uint16_t supplyVoltageAdc = tmcm_getModuleSpecificADCValue(ADC_VOLTAGE);
+	recorder_addInput(RECORDER_INPUT_SUPPLY_ADC, supplyVoltageAdc);
 
-	if (gActualSupplyVoltage >= MAX_SUPPLY_VOLTAGE)
-	{
-		flags_setStatusFlag(motor, OVERVOLTAGE);
-	}
-	else if (gActualSupplyVoltage <= MIN_SUPPLY_VOLTAGE)
-	{
-		flags_setStatusFlag(motor, UNDERVOLTAGE);
-		flags_clearStatusFlag(motor, OVERVOLTAGE);
-	}
-	else if (gActualSupplyVoltage > ON__SUPPLY_VOLTAGE)
+	gActualSupplyVoltage = (VOLTAGE_FAKTOR*supplyVoltageAdc)/4095;
+
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
 	{
-		flags_clearStatusFlag(motor, OVERVOLTAGE);
-		flags_clearStatusFlag(motor, UNDERVOLTAGE);
+		if (gActualSupplyVoltage >= MAX_SUPPLY_VOLTAGE)
+		{
+			flags_setStatusFlag(motor, OVERVOLTAGE);
+		}
+		else if (gActualSupplyVoltage <= MIN_SUPPLY_VOLTAGE)
+		{
+			flags_setStatusFlag(motor, UNDERVOLTAGE);
+			flags_clearStatusFlag(motor, OVERVOLTAGE);
+		}
+		else if (gActualSupplyVoltage > ON__SUPPLY_VOLTAGE)
+		{
+			flags_clearStatusFlag(motor, OVERVOLTAGE);
+			flags_clearStatusFlag(motor, UNDERVOLTAGE);
+		}
 	}
 }
 
@@ -354,7 +804,7 @@ int16_t bldc_getMotorTemperature()
 
 int32 bldc_getTargetVolume(uint8_t motor)
 {
-	return gDesiredVolume[motor];
+	return bldcAxis[motor].desiredVolume;
 }
 
 bool bldc_setTargetVolume(uint8_t motor, int32_t targetVolume)
@@ -365,7 +815,7 @@ bool bldc_setTargetVolume(uint8_t motor, int32_t targetVolume)
 
 //	if((targetPressure >= 0) && (targetPressure <= motorConfig[motor].maxVolume))
 	{
-		gDesiredVolume[motor] = targetVolume;
+		bldcAxis[motor].desiredVolume = targetVolume;
 
 		// switch to volume mode
 		bldc_switchToRegulationMode(motor, VOLUME_MODE);
@@ -377,16 +827,40 @@ bool bldc_setTargetVolume(uint8_t motor, int32_t targetVolume)
 
 int32_t bldc_getActualVolume(uint8_t motor)
 {
-	return gActualVolume[motor];
+	return bldcAxis[motor].actualVolume;
+}
+
+// ===== flow control mode settings =====
+
+int32_t bldc_getTargetFlow(uint8_t motor)
+{
+	return bldcAxis[motor].desiredFlow;
+}
+
+/* set target flow [ml/min] */
+bool bldc_setTargetFlow(uint8_t motor, int32_t targetFlow)
+{
+	if ((motorConfig[motor].commutationMode == COMM_MODE_FOC_DISABLED)
+	  ||(motorConfig[motor].commutationMode == COMM_MODE_FOC_OPEN_LOOP))
+		return false;
+
+	if ((targetFlow >= -MAX_FLOW) && (targetFlow <= MAX_FLOW))
+	{
+		bldcAxis[motor].desiredFlow = targetFlow;
+
+		// switch to flow mode
+		bldc_switchToRegulationMode(motor, FLOW_MODE);
+		return true;
+	}
+	return false;
 }
 
 void bldc_checkMotorTemperature()
 {
-	float vTherm = tmcm_getModuleSpecificADCValue(ADC_MOT_TEMP)*3.3 / 4095.0;
-	float rNTC = (3.3-vTherm)/(vTherm/4700.0);
-	float b = 3455.0;
-	float temp = (1.0/((log(rNTC/10000.0)/b) + (1.0/298.16)))-273.16;
-	gActualMotorTemperature = temp;
+	uint16_t motorTemperatureAdc = tmcm_getModuleSpecificADCValue(ADC_MOT_TEMP);
+	recorder_addInput(RECORDER_INPUT_TEMPERATURE_ADC, motorTemperatureAdc);
+
+	gActualMotorTemperature = bldc_calculateMotorTemperature(motorTemperatureAdc);
 
 	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
 	{
@@ -405,6 +879,16 @@ void bldc_checkMotorTemperature()
 	}
 }
 
+/* NTC (10k, B 3455) with 4k7 pull up [C] */
+int16_t bldc_calculateMotorTemperature(uint16_t adcValue)
+{
+	float vTherm = adcValue*3.3 / 4095.0;
+	float rNTC = (3.3-vTherm)/(vTherm/4700.0);
+	float b = 3455.0;
+	float temp = (1.0/((log(rNTC/10000.0)/b) + (1.0/298.16)))-273.16;
+	return temp;
+}
+
 // ===== ADC offset configuration =====
 
 uint16_t bldc_getAdcI0Offset(uint8_t motor)
@@ -442,6 +926,7 @@ void bldc_updateMotorPolePairs(uint8_t motor, uint8_t motorPolePairs)
 {
 	motorConfig[motor].motorPolePairs = motorPolePairs;
 	tmc4671_setPolePairs(motor, motorConfig[motor].motorPolePairs);
+	bldc_updateConversions(motor);
 }
 
 uint16_t bldc_getMaxMotorCurrent(uint8_t motor)
@@ -453,6 +938,7 @@ void bldc_updateMaxMotorCurrent(uint8_t motor, uint16_t maxCurrent)
 {
 	motorConfig[motor].absMaxPositiveCurrent = maxCurrent;
 	tmc4671_setTorqueFluxLimit_mA(motor, motorConfig[motor].dualShuntFactor, maxCurrent);
+	bldc_updateRegulatorSettings(motor);
 }
 
 uint16_t bldc_getMaxNegativeMotorCurrent(uint8_t motor)
@@ -463,6 +949,7 @@ uint16_t bldc_getMaxNegativeMotorCurrent(uint8_t motor)
 void bldc_updateMaxNegativeMotorCurrent(uint8_t motor, uint16_t maxCurrent)
 {
 	motorConfig[motor].absMaxNegativeCurrent = maxCurrent;
+	bldc_updateRegulatorSettings(motor);
 }
 
 uint8_t bldc_getMotorDirection(uint8_t motor)
@@ -522,7 +1009,7 @@ bool bldc_setTargetMotorCurrent(uint8_t motor, int32_t targetCurrent)
 
 	if((targetCurrent >= -MAX_CURRENT) && (targetCurrent <= MAX_CURRENT))
 	{
-		gTargetTorque[motor] = targetCurrent;
+		bldcAxis[motor].targetTorque = targetCurrent;
 
 		// switch to torque mode
 		bldc_switchToRegulationMode(motor, TORQUE_MODE);
@@ -533,14 +1020,14 @@ bool bldc_setTargetMotorCurrent(uint8_t motor, int32_t targetCurrent)
 
 int32_t bldc_getActualMotorCurrent(uint8_t motor)
 {
-	return actualTorquePT1[motor];
+	return bldcAxis[motor].actualTorquePT1;
 }
 
 // ===== velocity mode settings =====
 
 int32_t bldc_getTargetVelocity(uint8_t motor)
 {
-	return gDesiredVelocity[motor];
+	return bldcAxis[motor].desiredVelocity;
 }
 
 /* set target velocity [rpm] (x{>0:CW | 0:Stop | <0: CCW} */
@@ -551,7 +1038,7 @@ bool bldc_setTargetVelocity(uint8_t motor, int32_t velocity)
 
 	if ((velocity >= -MAX_VELOCITY) && (velocity <= MAX_VELOCITY))
 	{
-		gDesiredVelocity[motor] = velocity;
+		bldcAxis[motor].desiredVelocity = velocity;
 
 		// switch to velocity motion mode
 		bldc_switchToRegulationMode(motor, VELOCITY_MODE);
@@ -563,13 +1050,13 @@ bool bldc_setTargetVelocity(uint8_t motor, int32_t velocity)
 /* actual ramp generator velocity */
 int32 bldc_getRampGeneratorVelocity(uint8_t motor)
 {
-	return gTargetSpeed[motor];
+	return bldcAxis[motor].targetSpeed;
 }
 
 /* actual velocity in rpm */
 int32_t bldc_getActualVelocity(uint8_t motor)
 {
-	return gActualVelocity[motor];
+	return bldcAxis[motor].actualVelocity;
 }
 
 bool bldc_setMaxVelocity(uint8_t motor, int32_t maxVelocity)
@@ -610,37 +1097,212 @@ bool bldc_setRampEnabled(uint8_t motor, int32_t enableRamp)
 
 void bldc_switchToRegulationMode(uint8_t motor, uint32_t mode)
 {
-	flags_clearStatusFlag(motor, STOP_MODE | TORQUE_MODE | VELOCITY_MODE | PRESSURE_MODE | VOLUME_MODE | POSITION_END);
+	// a new target or mode ends a running regulator autotuning
+	bldc_abortAutotune(motor);
+
+	// bumpless handover to the pressure/volume regulators on mode change
+	if (mode != bldcAxis[motor].motionMode)
+	{
+		if (mode == PRESSURE_MODE)
+		{
+			bldc_handoverPressureRegulator(motor, bldcAxis[motor].desiredPressure);
+		}
+		else if (mode == VOLUME_MODE)
+		{
+			// keep the pressure regulator running if it was active, else start at the actual pressure
+			int32_t pressure = bldcAxis[motor].desiredPressure;
+			if (bldcAxis[motor].motionMode != PRESSURE_MODE)
+			{
+				pressure = bldcAxis[motor].actualPressure;
+				bldc_handoverPressureRegulator(motor, pressure);
+			}
+			pid_handover(&bldcAxis[motor].volumePID, bldcAxis[motor].desiredVolume, bldc_getFeedbackVolume(motor), pressure);
+		}
+		else if (mode == FLOW_MODE)
+		{
+			if (motorConfig[motor].pidFlowOutput == FLOW_OUTPUT_PRESSURE)
+			{
+				// keep the pressure regulator running if it was active, else start at the actual pressure
+				int32_t pressure = bldcAxis[motor].desiredPressure;
+				if ((bldcAxis[motor].motionMode != PRESSURE_MODE) && (bldcAxis[motor].motionMode != VOLUME_MODE))
+				{
+					pressure = bldcAxis[motor].actualPressure;
+					bldc_handoverPressureRegulator(motor, pressure);
+				}
+				pid_handover(&bldcAxis[motor].flowPID, bldcAxis[motor].desiredFlow, bldc_getFeedbackFlow(motor), pressure);
+			}
+			else
+			{
+				pid_handover(&bldcAxis[motor].flowPID, bldcAxis[motor].desiredFlow, bldc_getFeedbackFlow(motor), bldcAxis[motor].actualTorquePT1);
+			}
+		}
+	}
+
+	flags_clearStatusFlag(motor, STOP_MODE | TORQUE_MODE | VELOCITY_MODE | PRESSURE_MODE | VOLUME_MODE | FLOW_MODE | POSITION_END);
 
 	switch (mode)
 	{
 		case STOP_MODE:
 			flags_setStatusFlag(motor, STOP_MODE);
-			gMotionMode[motor] = STOP_MODE;
+			bldcAxis[motor].motionMode = STOP_MODE;
 			break;
 		case TORQUE_MODE:
 			flags_setStatusFlag(motor, TORQUE_MODE);
-			gMotionMode[motor] = TORQUE_MODE;
+			bldcAxis[motor].motionMode = TORQUE_MODE;
 			tmc4671_switchToMotionMode(motor, TMC4671_MOTION_MODE_TORQUE);
 			break;
 		case VELOCITY_MODE:
 			flags_setStatusFlag(motor, VELOCITY_MODE);
-			gMotionMode[motor] = VELOCITY_MODE;
+			bldcAxis[motor].motionMode = VELOCITY_MODE;
 			tmc4671_switchToMotionMode(motor, TMC4671_MOTION_MODE_VELOCITY);
 			break;
 		case PRESSURE_MODE:
 			flags_setStatusFlag(motor, PRESSURE_MODE);
-			gMotionMode[motor] = PRESSURE_MODE;
-			tmc4671_switchToMotionMode(motor, TMC4671_MOTION_MODE_TORQUE);
+			bldcAxis[motor].motionMode = PRESSURE_MODE;
+			tmc4671_switchToMotionMode(motor, bldc_getRegulationMotionMode(motor, PRESSURE_MODE));
 			break;
 		case VOLUME_MODE:
 			flags_setStatusFlag(motor, VOLUME_MODE);
-			gMotionMode[motor] = VOLUME_MODE;
-			tmc4671_switchToMotionMode(motor, TMC4671_MOTION_MODE_TORQUE);
+			bldcAxis[motor].motionMode = VOLUME_MODE;
+			tmc4671_switchToMotionMode(motor, bldc_getRegulationMotionMode(motor, VOLUME_MODE));
+			break;
+		case FLOW_MODE:
+			flags_setStatusFlag(motor, FLOW_MODE);
+			bldcAxis[motor].motionMode = FLOW_MODE;
+			tmc4671_switchToMotionMode(motor, bldc_getRegulationMotionMode(motor, FLOW_MODE));
 			break;
 	}
 }
 
+// ===== state estimation =====
+
+int32_t bldc_getEstimatedPressure(uint8_t motor)
+{
+	return estimator_getValue(&bldcAxis[motor].pressureEstimator);
+}
+
+/* [Pa/s] */
+int32_t bldc_getEstimatedPressureSlope(uint8_t motor)
+{
+	return ((int64_t)estimator_getSlope(&bldcAxis[motor].pressureEstimator) * 1000) >> 16;
+}
+
+int32_t bldc_getEstimatedFlow(uint8_t motor)
+{
+	return estimator_getValue(&bldcAxis[motor].flowEstimator);
+}
+
+/* q16 [ml/min per ms] */
+int32_t bldc_getEstimatedFlowSlope(uint8_t motor)
+{
+	return estimator_getSlope(&bldcAxis[motor].flowEstimator);
+}
+
+/* pressure for the regulators by the selected signal */
+int32_t bldc_getFeedbackPressure(uint8_t motor)
+{
+	switch(motorConfig[motor].pressureSignal)
+	{
+		case FEEDBACK_SIGNAL_PT1:
+			return bldcAxis[motor].actualPressurePT1;
+		case FEEDBACK_SIGNAL_ESTIMATED:
+			return estimator_getValue(&bldcAxis[motor].pressureEstimator);
+		default:
+			return bldcAxis[motor].actualPressure;
+	}
+}
+
+/* flow for the feed forward by the selected signal */
+int32_t bldc_getFeedbackFlow(uint8_t motor)
+{
+	switch(motorConfig[motor].flowSignal)
+	{
+		case FEEDBACK_SIGNAL_PT1:
+			return tosv_getFlowValue();
+		case FEEDBACK_SIGNAL_ESTIMATED:
+			return estimator_getValue(&bldcAxis[motor].flowEstimator);
+		default:
+			return tosv_getActualFlowValue();
+	}
+}
+
+/* volume for the volume regulator (integrated raw flow, or integrated estimated flow) */
+int32_t bldc_getFeedbackVolume(uint8_t motor)
+{
+	return (motorConfig[motor].flowSignal == FEEDBACK_SIGNAL_ESTIMATED) ? tosv_getEstimatedVolume() : bldcAxis[motor].actualVolume;
+}
+
+// ===== regulator autotuning =====
+
+/* start the autotuning experiment of the pressure or volume regulator at the actual operating point */
+bool bldc_startAutotune(uint8_t motor, uint8_t loop, uint8_t rule)
+{
+	// needs a constant target, so not while ventilating
+	if (tosv_isVentilatorEnabled(&tosvConfig[TOSV_AXIS]) || autotune_isActive(&bldcAxis[motor].autotune))
+		return false;
+
+	bool started = false;
+	if ((loop == AUTOTUNE_LOOP_PRESSURE) && flags_isStatusFlagSet(motor, PRESSURE_MODE) && (motorConfig[motor].pressureCascade == PRESSURE_CASCADE_TORQUE))
+	{
+		started = autotune_start(&bldcAxis[motor].autotune, bldcAxis[motor].targetTorque, motorConfig[motor].autotuneAmplitude, motorConfig[motor].autotuneHysteresis,
+				motorConfig[motor].autotuneSettleTime, rule, bldcAxis[motor].pressurePID.pShift, bldcAxis[motor].pressurePID.iShift);
+	}
+	else if ((loop == AUTOTUNE_LOOP_VOLUME) && flags_isStatusFlagSet(motor, VOLUME_MODE))
+	{
+		started = autotune_start(&bldcAxis[motor].autotune, bldcAxis[motor].desiredPressure, motorConfig[motor].autotuneAmplitude, motorConfig[motor].autotuneHysteresis,
+				motorConfig[motor].autotuneSettleTime, rule, bldcAxis[motor].volumePID.pShift, bldcAxis[motor].volumePID.iShift);
+	}
+
+	if (started)
+		bldcAxis[motor].autotuneLoop = loop;
+
+	return started;
+}
+
+void bldc_abortAutotune(uint8_t motor)
+{
+	if (autotune_isActive(&bldcAxis[motor].autotune))
+	{
+		autotune_abort(&bldcAxis[motor].autotune);
+		bldc_finishAutotune(motor);
+	}
+}
+
+/* continue with the regulator at the last experiment output */
+void bldc_finishAutotune(uint8_t motor)
+{
+	if (bldcAxis[motor].autotuneLoop == AUTOTUNE_LOOP_PRESSURE)
+		bldc_handoverPressureRegulator(motor, bldcAxis[motor].targetPressure);
+	else
+		pid_handover(&bldcAxis[motor].volumePID, bldcAxis[motor].desiredVolume, bldc_getFeedbackVolume(motor), bldcAxis[motor].desiredPressure);
+}
+
+/* use the identified gains for the tested regulator */
+bool bldc_applyAutotune(uint8_t motor)
+{
+	if (bldcAxis[motor].autotune.state != AUTOTUNE_STATE_DONE)
+		return false;
+
+	if (bldcAxis[motor].autotuneLoop == AUTOTUNE_LOOP_PRESSURE)
+	{
+		motorConfig[motor].pidPressure_P_param = bldcAxis[motor].autotune.pParam;
+		motorConfig[motor].pidPressure_I_param = bldcAxis[motor].autotune.iParam;
+	}
+	else
+	{
+		motorConfig[motor].pidVolume_P_param = bldcAxis[motor].autotune.pParam;
+		motorConfig[motor].pidVolume_I_param = bldcAxis[motor].autotune.iParam;
+	}
+	bldc_updateRegulatorSettings(motor);
+
+	return true;
+}
+
+Autotune *bldc_getAutotune(uint8_t motor)
+{
+	return &bldcAxis[motor].autotune;
+}
+
 // ===== hall sensor settings =====
 
 void bldc_updateHallSettings(uint8_t motor)
@@ -667,7 +1329,7 @@ void bldc_updateHallSettings(uint8_t motor)
 
 void bldc_checkCommutationMode(uint8_t motor)
 {
-	if(gLastSetCommutationMode[motor] != motorConfig[motor].commutationMode)
+	if(bldcAxis[motor].lastSetCommutationMode != motorConfig[motor].commutationMode)
 	{
 		switch(motorConfig[motor].commutationMode)
 		{
@@ -686,32 +1348,23 @@ void bldc_checkCommutationMode(uint8_t motor)
 			case COMM_MODE_FOC_DIGITAL_HALL:
 				tmc4671_writeInt(motor, TMC4671_PHI_E_SELECTION, TMC4671_PHI_E_HALL);
 
-				if (flags_isStatusFlagSet(motor, STOP_MODE))
-					tmc4671_switchToMotionMode(motor, TMC4671_MOTION_MODE_STOPPED);
-				else if (flags_isStatusFlagSet(motor, TORQUE_MODE))
-					tmc4671_switchToMotionMode(motor, TMC4671_MOTION_MODE_TORQUE);
-				else if (flags_isStatusFlagSet(motor, PRESSURE_MODE))
-					tmc4671_switchToMotionMode(motor, TMC4671_MOTION_MODE_TORQUE);
-				else if (flags_isStatusFlagSet(motor, VOLUME_MODE))
-					tmc4671_switchToMotionMode(motor, TMC4671_MOTION_MODE_TORQUE);
-				else	// velocity mode
-					tmc4671_switchToMotionMode(motor, TMC4671_MOTION_MODE_VELOCITY);
+				tmc4671_switchToMotionMode(motor, bldc_getRegulationMotionMode(motor, bldcAxis[motor].motionMode));
 
 				flags_setStatusFlag(motor, MODULE_INITIALIZED);
 				break;
 		}
-		gLastSetCommutationMode[motor] = motorConfig[motor].commutationMode;
+		bldcAxis[motor].lastSetCommutationMode = motorConfig[motor].commutationMode;
 	}
 }
 
 int32 bldc_getTargetPressure(uint8_t motor)
 {
-	return gDesiredPressure[motor];
+	return bldcAxis[motor].desiredPressure;
 }
 
 int32 bldc_getRampPressure(uint8_t motor)
 {
-	return gTargetPressure[motor];
+	return bldcAxis[motor].targetPressure;
 }
 
 bool bldc_setTargetPressure(uint8_t motor, int32_t targetPressure)
@@ -722,7 +1375,8 @@ bool bldc_setTargetPressure(uint8_t motor, int32_t targetPressure)
 
 	if((targetPressure >= 0) && (targetPressure <= motorConfig[motor].maxPressure))
 	{
-		gDesiredPressure[motor] = targetPressure;
+		bldcAxis[motor].desiredPressure = targetPressure;
+		bldcAxis[motor].isPressureRamp = false;
 
 		// switch to velocity mode
 		bldc_switchToRegulationMode(motor, PRESSURE_MODE);
@@ -731,6 +1385,16 @@ bool bldc_setTargetPressure(uint8_t motor, int32_t targetPressure)
 	return false;
 }
 
+/* target pressure of a planner ramp, one point per ms (feed forward of the ramp slope) */
+bool bldc_setTargetPressureRamp(uint8_t motor, int32_t targetPressure)
+{
+	if (!bldc_setTargetPressure(motor, targetPressure))
+		return false;
+
+	bldcAxis[motor].isPressureRamp = true;
+	return true;
+}
+
 void bldc_updateBrakeChopperConfig(uint8_t motor)
 {
 	if(motorConfig[motor].brakeChopperEnabled)
@@ -747,7 +1411,59 @@ void bldc_updateBrakeChopperConfig(uint8_t motor)
 	}
 }
 
+// ===== pressure sensor calibration =====
+
+/* precalculate the pressure calibration table slopes (call on every table change) */
+void bldc_updatePressureCalibration(uint8_t motor)
+{
+	calibration_updateSlopes(motorConfig[motor].pressureCalAdc, motorConfig[motor].pressureCalPressure, bldcAxis[motor].pressureCalSlope, PRESSURE_CAL_POINTS);
+}
+
+/* Start the atmospheric auto zero of the pressure sensor.
+ *
+ * Only possible with stopped blower and ventilator. The calibrated pressure is averaged
+ * over 256 ms and stored as offset. Starting the blower during measurement aborts it.
+ */
+bool bldc_startPressureAutoZero(uint8_t motor)
+{
+	if ((abs(bldcAxis[motor].actualVelocity) > PRESSURE_ZERO_MAX_VELOCITY) || tosv_isVentilatorEnabled(&tosvConfig[TOSV_AXIS]))
+		return false;
+
+	bldcAxis[motor].pressureZeroSum = 0;
+	bldcAxis[motor].pressureZeroCounter = 1 << PRESSURE_ZERO_SAMPLES_SHIFT;
+	return true;
+}
+
+bool bldc_isPressureAutoZeroActive(uint8_t motor)
+{
+	return (bldcAxis[motor].pressureZeroCounter > 0);
+}
+
+void bldc_updatePressureAutoZero(uint8_t motor, int32_t pressure)
+{
+	if (bldcAxis[motor].pressureZeroCounter == 0)
+		return;
+
+	if (abs(bldcAxis[motor].actualVelocity) > PRESSURE_ZERO_MAX_VELOCITY)
+	{
+		bldcAxis[motor].pressureZeroCounter = 0;
+		return;
+	}
+
+	bldcAxis[motor].pressureZeroSum += pressure;
+	bldcAxis[motor].pressureZeroCounter--;
+
+	if (bldcAxis[motor].pressureZeroCounter == 0)
+		motorConfig[motor].pressureCalOffset = bldcAxis[motor].pressureZeroSum >> PRESSURE_ZERO_SAMPLES_SHIFT;
+}
+
+/* oversampled ADC value of the pressure sensor for calibration */
+uint16_t bldc_getPressureAdcValue(uint8_t motor)
+{
+	return bldcAxis[motor].pressureAdcValue;
+}
+
 int32_t bldc_getActualPressure(uint8_t motor) // unit: Pa
 {
-	return actualPressurePT1[motor];
+	return bldcAxis[motor].actualPressurePT1;
 }
@@ -10,14 +10,38 @@
 
 	#include "Definitions.h"
 	#include "hal/modules/SelectModule.h"
+	#include "Autotune.h"
+	#include "hal/system/Recorder.h"
+
+	// regulators tunable by the autotuner
+	#define AUTOTUNE_LOOP_PRESSURE		0
+	#define AUTOTUNE_LOOP_VOLUME		1
+
+	// regulator feedback signals
+	#define FEEDBACK_SIGNAL_RAW			0
+	#define FEEDBACK_SIGNAL_PT1			1
+	#define FEEDBACK_SIGNAL_ESTIMATED	2
+
+	// flow regulator outputs
+	#define FLOW_OUTPUT_PRESSURE		0	// cascaded onto the pressure regulator
+	#define FLOW_OUTPUT_TORQUE			1
+
+	// inner loops of the pressure regulator
+	#define PRESSURE_CASCADE_TORQUE		0	// output: torque target
+	#define PRESSURE_CASCADE_VELOCITY	1	// output: velocity target of the TMC4671 velocity PI
 
 	void bldc_init();
 	void bldc_processBLDC();
 	void bldc_updateHallSettings(uint8_t motor);
+	void bldc_updateRegulatorSettings(uint8_t motor);
+	void bldc_updateConversions(uint8_t motor);
+	void bldc_updateEstimatorSettings(uint8_t motor);
+	void bldc_visitState(Recorder_StateVisitor visit);
 
 	// ===== general info =====
 	int16_t bldc_getSupplyVoltage();
 	int16_t bldc_getMotorTemperature();
+	int16_t bldc_calculateMotorTemperature(uint16_t adcValue);
 
 	// ===== ADC offset configuration =====
 	uint16_t bldc_getAdcI0Offset(uint8_t motor);
@@ -60,8 +84,21 @@
 	int32 bldc_getTargetPressure(uint8_t motor);
 	int32 bldc_getRampPressure(uint8_t motor);
 	bool bldc_setTargetPressure(uint8_t motor, int32_t pressure);
+	bool bldc_setTargetPressureRamp(uint8_t motor, int32_t pressure);
 	int32 bldc_getActualPressure(uint8_t motor);
 	int32_t bldc_getPressureErrorSum(uint8_t motor);
+	int32_t bldc_getPressureFeedForward(uint8_t motor);
+	int32_t bldc_getPressureFeedbackTorque(uint8_t motor);
+	uint16_t bldc_getPressurePParam(uint8_t motor);
+	uint16_t bldc_getPressureIParam(uint8_t motor);
+	bool bldc_setPressureCascade(uint8_t motor, uint8_t cascade);
+	bool bldc_isPressureRegulatorActive(uint8_t motor);
+
+	// ===== pressure sensor calibration =====
+	void bldc_updatePressureCalibration(uint8_t motor);
+	bool bldc_startPressureAutoZero(uint8_t motor);
+	bool bldc_isPressureAutoZeroActive(uint8_t motor);
+	uint16_t bldc_getPressureAdcValue(uint8_t motor);
 
 	// ===== volume control mode settings =====
 	bool bldc_setTargetVolume(uint8_t motor, int32_t targetVolume);
@@ -69,9 +106,26 @@
 	int32_t bldc_getActualVolume(uint8_t motor);
 	int32_t bldc_getVolumeErrorSum(uint8_t motor);
 
+	// ===== flow control mode settings =====
+	bool bldc_setTargetFlow(uint8_t motor, int32_t targetFlow);
+	int32_t bldc_getTargetFlow(uint8_t motor);
+	int32_t bldc_getFlowErrorSum(uint8_t motor);
+
 	// ===== pi controller mode settings =====
 	void bldc_switchToRegulationMode(uint8_t motor, uint32_t mode);
 
+	// ===== state estimation =====
+	int32_t bldc_getEstimatedPressure(uint8_t motor);
+	int32_t bldc_getEstimatedPressureSlope(uint8_t motor);
+	int32_t bldc_getEstimatedFlow(uint8_t motor);
+	int32_t bldc_getEstimatedFlowSlope(uint8_t motor);
+
+	// ===== regulator autotuning =====
+	bool bldc_startAutotune(uint8_t motor, uint8_t loop, uint8_t rule);
+	void bldc_abortAutotune(uint8_t motor);
+	bool bldc_applyAutotune(uint8_t motor);
+	Autotune *bldc_getAutotune(uint8_t motor);
+
 	// ===== brake chopper settings =====
 	void bldc_updateBrakeChopperConfig(uint8_t motor);
 
@@ -0,0 +1,192 @@
+/*
+ * Benchmark.c
+ *
+ *  Cpu cycles of the control loop kernels, measured on the target with the DWT cycle counter
+ *
+ *  Every kernel is called BENCHMARK_CALLS times with changing inputs. Each call is measured on its own,
+ *  the cycles of an empty call (measurement and dispatch) are subtracted. The minimum is the cost of
+ *  the kernel itself, the mean includes the interrupts hitting the measurement.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Benchmark.h"
+#include "BLDC.h"
+#include "TOSV.h"
+#include "TMCL.h"
+#include "PID.h"
+#include "Conversion.h"
+#include "Calibration.h"
+#include "Estimator.h"
+#include "LungMechanics.h"
+#include "hal/system/SystemInfo.h"
+
+#define BENCHMARK_CALLS		32
+
+typedef struct
+{
+	int64_t filterAkku;
+	int32_t filterValue;
+	PIDControl pid;
+	Reciprocal reciprocal;
+	int32_t pressureCalSlope[PRESSURE_CAL_POINTS-1];
+	uint8_t frame[9];
+	TTMCLCommand command;
+	int64_t flowSum;
+	AlphaBetaFilter estimator;
+	LungMechanics lung;
+	TOSV_Config tosv;
+} BenchmarkData;
+
+INSTANCE_STATE volatile int32_t benchmarkResult;	// keeps the kernel results alive
+
+/* breath phases without regulator setpoints: the benchmark must not start the blower */
+void benchmark_phaseSetpoint(TOSV_Config *config)
+{
+	benchmarkResult = config->timer;
+}
+
+bool benchmark_phaseCondition(TOSV_Config *config)
+{
+	return (config->timer >= 8);
+}
+
+const TOSV_Phase benchmarkPhases[TOSV_PHASES] =
+{
+	[TOSV_STATE_INHALATION_RISE]   = { benchmark_phaseSetpoint, TOSV_PHASE_TIME(tInhalationRise), NULL,                     NULL, TOSV_STATE_EXHALATION_PAUSE },
+	[TOSV_STATE_EXHALATION_PAUSE]  = { benchmark_phaseSetpoint, TOSV_PHASE_UNTIMED,               benchmark_phaseCondition, NULL, TOSV_STATE_INHALATION_RISE },
+};
+
+void benchmark_init(BenchmarkData *data)
+{
+	data->filterAkku = 0;
+	data->filterValue = 0;
+
+	// scaling of the pressure regulator (P/D divisor 256, I divisor 65536, D filter over 8 ms)
+	data->pid.pParam = motorConfig[0].pidPressure_P_param;
+	data->pid.iParam = motorConfig[0].pidPressure_I_param;
+	data->pid.dParam = motorConfig[0].pidPressure_D_param;
+	data->pid.pShift = 8;
+	data->pid.iShift = 16;
+	data->pid.dFilterShift = 3;
+	data->pid.setpointWeight = motorConfig[0].pidPressureSetpointWeight;
+	data->pid.trackingGain = 128;
+	data->pid.maxOutputStep = motorConfig[0].maxTorqueStep;
+	pid_reset(&data->pid);
+
+	conversion_setDivisor(&data->reciprocal, motorConfig[0].motorPolePairs);
+	calibration_updateSlopes(motorConfig[0].pressureCalAdc, motorConfig[0].pressureCalPressure, data->pressureCalSlope, PRESSURE_CAL_POINTS);
+
+	uint8_t frame[9] = { moduleConfig.serialModuleAddress, TMCL_GAP, 0, 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 9; i++)
+		data->frame[i] = frame[i];
+
+	data->flowSum = 0;
+	estimator_setNoiseRatio(&data->estimator, motorConfig[0].estPressureNoiseRatio);
+	estimator_reset(&data->estimator, 0);
+	lungMechanics_reset(&data->lung);
+
+	data->tosv = tosvConfig[0];
+	data->tosv.actualState = TOSV_STATE_INHALATION_RISE;
+	data->tosv.timer = 0;
+	data->tosv.tInhalationRise = 8;
+}
+
+/* one call of the kernel with input number i (BENCHMARK_KERNELS: empty call) */
+void benchmark_call(uint8_t kernel, BenchmarkData *data, int32_t i)
+{
+	switch(kernel)
+	{
+		case BENCHMARK_FILTER_PT1:
+			data->filterValue = tmc_filterPT1(&data->filterAkku, 1000 + 37*i, data->filterValue, 2, 8);
+			benchmarkResult = data->filterValue;
+			break;
+		case BENCHMARK_PID:
+			benchmarkResult = pid_process(&data->pid, 2000, 1500 + 37*i, -2000, 6000);
+			break;
+		case BENCHMARK_DIVIDE:
+			benchmarkResult = conversion_divide(-100000 + 7919*i, &data->reciprocal);
+			break;
+		case BENCHMARK_CALIBRATION:
+			benchmarkResult = calibration_interpolate(2048*i, motorConfig[0].pressureCalAdc, motorConfig[0].pressureCalPressure, data->pressureCalSlope, PRESSURE_CAL_POINTS);
+			break;
+		case BENCHMARK_MOTOR_TEMPERATURE:
+			benchmarkResult = bldc_calculateMotorTemperature(1000 + 64*i);
+			break;
+		case BENCHMARK_TMCL_FRAME:
+			data->frame[2] = i;
+			data->frame[8] = data->frame[0] + data->frame[1] + data->frame[2];
+			benchmarkResult = tmcl_parseFrame(data->frame, &data->command);
+			break;
+		case BENCHMARK_VOLUME:
+			benchmarkResult = tosv_integrateVolume(&data->flowSum, 30000 + 997*i);
+			break;
+		case BENCHMARK_ESTIMATOR:
+			estimator_update(&data->estimator, 1500 + 37*i, true, 0);
+			benchmarkResult = data->estimator.value >> 16;
+			break;
+		case BENCHMARK_LUNG_SAMPLE:
+			lungMechanics_addSample(&data->lung, 1500 + 37*i, 30000 - 997*i, 250 + 13*i);
+			benchmarkResult = data->lung.samples;
+			break;
+		case BENCHMARK_REGULATOR_SETTINGS:
+			bldc_updateRegulatorSettings(0);
+			break;
+		case BENCHMARK_BREATH_PHASE:
+			tosv_processPhase(&data->tosv, benchmarkPhases);
+			break;
+		default:
+			break;
+	}
+}
+
+/* calls of a kernel one after another without measurement, for timing a whole batch on the host
+ * (BENCHMARK_KERNELS: empty calls for the overhead of the loop)
+ */
+void benchmark_repeat(uint8_t kernel, uint32_t calls)
+{
+	BenchmarkData data;
+	benchmark_init(&data);
+
+	for (uint32_t i = 0; i < calls; i++)
+		benchmark_call(kernel, &data, i % BENCHMARK_CALLS);
+}
+
+/* cycles per call of a kernel, returns false for an unknown kernel */
+bool benchmark_run(uint8_t kernel, uint32_t *minCycles, uint32_t *meanCycles)
+{
+	if (kernel >= BENCHMARK_KERNELS)
+		return false;
+
+	BenchmarkData data;
+	benchmark_init(&data);
+
+	// cycles of the measurement itself
+	uint32_t overhead = UINT32_MAX;
+	for (int i = 0; i < BENCHMARK_CALLS; i++)
+	{
+		uint32_t start = systemInfo_getCycleCounter();
+		benchmark_call(BENCHMARK_KERNELS, &data, i);
+		uint32_t cycles = systemInfo_getCycleCounter() - start;
+
+		if (cycles < overhead)
+			overhead = cycles;
+	}
+
+	uint32_t sum = 0;
+	*minCycles = UINT32_MAX;
+	for (int i = 0; i < BENCHMARK_CALLS; i++)
+	{
+		uint32_t start = systemInfo_getCycleCounter();
+		benchmark_call(kernel, &data, i);
+		uint32_t cycles = systemInfo_getCycleCounter() - start;
+
+		cycles = (cycles > overhead) ? cycles - overhead : 0;
+		sum += cycles;
+		if (cycles < *minCycles)
+			*minCycles = cycles;
+	}
+	*meanCycles = sum / BENCHMARK_CALLS;
+
+	return true;
+}
@@ -0,0 +1,31 @@
+/*
+ * Benchmark.h
+ *
+ *  Cpu cycles of the control loop kernels, measured on the target with the DWT cycle counter
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+	#include "TMC-API/tmc/helpers/API_Header.h"
+
+	// kernels
+	#define BENCHMARK_FILTER_PT1			0	// tmc_filterPT1()
+	#define BENCHMARK_PID					1	// pid_process() with D part, setpoint weight and output step limit
+	#define BENCHMARK_DIVIDE				2	// conversion_divide()
+	#define BENCHMARK_CALIBRATION			3	// calibration_interpolate() of the pressure table
+	#define BENCHMARK_MOTOR_TEMPERATURE		4	// bldc_calculateMotorTemperature()
+	#define BENCHMARK_TMCL_FRAME			5	// tmcl_parseFrame()
+	#define BENCHMARK_VOLUME				6	// tosv_integrateVolume()
+	#define BENCHMARK_ESTIMATOR				7	// estimator_update()
+	#define BENCHMARK_LUNG_SAMPLE			8	// lungMechanics_addSample()
+	#define BENCHMARK_REGULATOR_SETTINGS	9	// bldc_updateRegulatorSettings(), the work the cache keeps out of every tick
+	#define BENCHMARK_BREATH_PHASE			10	// tosv_processPhase() over a timed phase and a phase with condition
+	#define BENCHMARK_KERNELS				11
+
+	bool benchmark_run(uint8_t kernel, uint32_t *minCycles, uint32_t *meanCycles);
+	void benchmark_repeat(uint8_t kernel, uint32_t calls);
+
+#endif
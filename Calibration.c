@@ -0,0 +1,37 @@
+/*
+ * Calibration.c
+ *
+ *  Piecewise linear sensor calibration tables
+ *
+ *  A table consists of ascending x values (raw sensor values) and the corresponding y values
+ *  (physical values). The slopes of the segments are precalculated in q16 format whenever the
+ *  table changes, so the conversion in the regulation loop needs no division.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Calibration.h"
+
+/* calculate the q16 slopes of the points-1 segments (segments with non ascending x get slope 0) */
+void calibration_updateSlopes(const int32_t *x, const int32_t *y, int32_t *slope, uint8_t points)
+{
+	for (int i = 0; i < points-1; i++)
+	{
+		int64_t xDiff = (int64_t)x[i+1] - x[i];
+
+		if (xDiff > 0)
+			slope[i] = (((int64_t)y[i+1] - y[i]) * 65536) / xDiff;
+		else
+			slope[i] = 0;
+	}
+}
+
+/* convert x by linear interpolation, the outer segments are extrapolated */
+int32_t calibration_interpolate(int32_t x, const int32_t *xTable, const int32_t *yTable, const int32_t *slope, uint8_t points)
+{
+	int i = 0;
+	while ((i < points-2) && (x >= xTable[i+1]))
+		i++;
+
+	return yTable[i] + (((int64_t)x - xTable[i]) * slope[i] >> 16);
+}
@@ -0,0 +1,17 @@
+/*
+ * Calibration.h
+ *
+ *  Piecewise linear sensor calibration tables
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+	#include "TMC-API/tmc/helpers/API_Header.h"
+
+	void calibration_updateSlopes(const int32_t *x, const int32_t *y, int32_t *slope, uint8_t points);
+	int32_t calibration_interpolate(int32_t x, const int32_t *xTable, const int32_t *yTable, const int32_t *slope, uint8_t points);
+
+#endif
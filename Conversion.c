@@ -0,0 +1,32 @@
+/*
+ * Conversion.c
+ *
+ *  Division by configurable divisors via cached reciprocals
+ *
+ *  Divisors that only change with a parameter update (pole pairs, shunt factor, ramp times) are
+ *  converted into a multiplier and shift once, so the regulation loop only needs a 32x32->64 bit
+ *  multiplication. With multiplier = ceil(2^(31+l) / divisor) and l = ceil(log2(divisor)) the
+ *  result is exact for all magnitudes up to 2^31 (Granlund/Montgomery).
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Conversion.h"
+
+void conversion_setDivisor(Reciprocal *reciprocal, uint32_t divisor)
+{
+	// keep the Cortex-M3 behavior of a division by zero: result 0
+	if (divisor == 0)
+	{
+		reciprocal->multiplier = 0;
+		reciprocal->shift = 31;
+		return;
+	}
+
+	uint8_t log2Divisor = 0;
+	while (((uint64_t)1 << log2Divisor) < divisor)
+		log2Divisor++;
+
+	reciprocal->shift = 31 + log2Divisor;
+	reciprocal->multiplier = (((uint64_t)1 << reciprocal->shift) + divisor - 1) / divisor;
+}
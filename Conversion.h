@@ -0,0 +1,31 @@
+/*
+ * Conversion.h
+ *
+ *  Division by configurable divisors via cached reciprocals
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef CONVERSION_H
+#define CONVERSION_H
+
+	#include "TMC-API/tmc/helpers/API_Header.h"
+
+	typedef struct
+	{
+		uint32_t multiplier;	// ceil(2^shift / divisor)
+		uint8_t shift;			// 31 + ceil(log2(divisor))
+	} Reciprocal;
+
+	void conversion_setDivisor(Reciprocal *reciprocal, uint32_t divisor);
+
+	/* value / divisor, truncated towards zero like the C division */
+	static inline int32_t conversion_divide(int32_t value, const Reciprocal *reciprocal)
+	{
+		uint32_t magnitude = (value < 0) ? -(uint32_t)value : (uint32_t)value;
+		uint32_t quotient = ((uint64_t)magnitude * reciprocal->multiplier) >> reciprocal->shift;
+
+		return (value < 0) ? (int32_t)(0 - quotient) : (int32_t)quotient;
+	}
+
+#endif
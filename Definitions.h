@@ -17,8 +17,22 @@
 	extern uint8_t ADC_VOLTAGE;
 	extern uint8_t ADC_MOT_TEMP;
 
+	// state of one controller instance (host simulations run one instance per thread)
+	#ifdef HOST_SIMULATION
+		#define INSTANCE_STATE	_Thread_local
+	#else
+		#define INSTANCE_STATE
+	#endif
+
 	#include "modules/SelectModule.h"
 
+	// number of points of the sensor calibration tables
+	#define FLOW_CAL_POINTS		9
+	#define PRESSURE_CAL_POINTS	5
+
+	// number of pressure regulator gain sets (one per TOSV state)
+	#define PRESSURE_GAIN_SETS	6
+
 	typedef struct
 	{
 		uint8_t baudrate;
@@ -41,6 +55,11 @@
 
 		int32_t  maxPressure;
 
+		// pressure sensor calibration
+		int32_t pressureCalAdc[PRESSURE_CAL_POINTS];		// ascending oversampled ADC values (16 bit)
+		int32_t pressureCalPressure[PRESSURE_CAL_POINTS];	// pressure [Pa]
+		int32_t pressureCalOffset;							// atmospheric offset [Pa] (auto zero)
+
 		uint16_t pidTorque_P_param;
 		uint16_t pidTorque_I_param;
 		uint16_t pidVelocity_P_param;
@@ -52,6 +71,47 @@
 		uint16_t pidVolume_P_param;
 		uint16_t pidVolume_I_param;
 
+		uint16_t pidPressure_D_param;
+		uint16_t pidVolume_D_param;
+		uint16_t pidPressureSetpointWeight;		// 256 = 1.0
+		uint16_t pidVolumeSetpointWeight;		// 256 = 1.0
+		uint16_t pidFlow_P_param;
+		uint16_t pidFlow_I_param;
+		uint8_t pidFlowOutput;					// flow regulator output (see FLOW_OUTPUT_*)
+		uint16_t maxTorqueStep;					// [mA/ms] 0 = no limit
+		uint8_t pressureCascade;				// inner loop of the pressure regulator (see PRESSURE_CASCADE_*)
+		uint16_t pidPressureVelocity_P_param;	// pressure regulator gains onto the velocity loop
+		uint16_t pidPressureVelocity_I_param;
+
+		// pressure feed forward (identified blower model)
+		uint8_t ffEnable;
+		uint16_t ffPressureGain;				// [mA per 1024 Pa target pressure]
+		uint16_t ffSlopeGain;					// [mA per Pa/ms target pressure slope]
+		uint16_t ffFlowGain;					// [mA per 1024 ml/min actual flow]
+
+		// breath to breath learning of the feed forward torque
+		uint8_t ilcEnable;
+		uint16_t ilcGain;						// [mA per mA feedback torque, q16]
+		uint16_t ilcMaxTorque;					// [mA]
+
+		// pressure regulator gain scheduling (one gain set per TOSV state)
+		uint8_t pidPressureScheduleEnable;
+		uint16_t pidPressureScheduleBlendTime;	// [ms] blend time on a state change
+		uint16_t pidPressureSchedule_P_param[PRESSURE_GAIN_SETS];
+		uint16_t pidPressureSchedule_I_param[PRESSURE_GAIN_SETS];
+
+		// regulator autotuning experiment
+		uint16_t autotuneAmplitude;				// [mA] pressure loop, [Pa] volume loop
+		uint16_t autotuneHysteresis;			// [Pa] pressure loop, [ml] volume loop
+		uint16_t autotuneSettleTime;			// [ms] per operating point
+
+		// state estimation (signal selection see FEEDBACK_SIGNAL_*)
+		uint8_t pressureSignal;					// pressure regulator feedback
+		uint8_t flowSignal;						// feed forward flow and volume regulator feedback
+		uint16_t estPressureNoiseRatio;			// tracking index [1/1000]
+		uint16_t estFlowNoiseRatio;				// tracking index [1/1000]
+		uint16_t estBlowerPressure;				// [Pa] blower pressure at 10000 rpm (0 = no speed input)
+
 		uint8_t motorType;
 		uint8_t motorPolePairs;
 		uint8_t shaftBit;
@@ -81,19 +141,25 @@
 		bool asbEnable; // early state machine reset on spontaneous flow
 		int32_t asbThreshold;
 		int32_t asbVolumeCondition;
+		uint16_t asbSlopeThreshold;		// [ml/min per ms]
+		uint16_t asbTorqueThreshold;	// [mA]
+		uint16_t asbBlowerInertia;		// [mA per rpm/ms]
+		uint8_t psCycleThreshold;		// [%] of the peak flow
+		uint16_t psApneaTime;			// [ms]
+		uint16_t prvcMaxStep;			// [Pa]
+		uint8_t flowProfile;
+		uint8_t flowZeroTrackingEnable;
+		uint32_t flowZeroVarianceLimit;
+
+		// flow sensor calibration
+		int32_t flowCalCounts[FLOW_CAL_POINTS];		// ascending SM9333 pressure counts
+		int32_t flowCalFlow[FLOW_CAL_POINTS];		// flow [ml/min]
+		int16_t flowCalTempRef;						// raw temperature at calibration
+		int16_t flowCalTempCoeff;					// zero drift [counts per 256 temperature counts]
 	} TMotorConfig;
 
-	TModuleConfig moduleConfig;
-	TMotorConfig motorConfig[NUMBER_OF_MOTORS];
-
-	typedef struct
-	{
-		int32_t error;            // regulation error
-		int64_t errorSum;         // sum of the I-part integration
-		int32_t pParam;           // P parameter
-		int32_t iParam;           // I parameter
-		int32_t result;			  // result of the PI regulator
-	} PIControl;
+	extern INSTANCE_STATE TModuleConfig moduleConfig;
+	extern INSTANCE_STATE TMotorConfig motorConfig[NUMBER_OF_MOTORS];
 
 	// commutation modes
 	#define COMM_MODE_FOC_DISABLED			0
@@ -141,5 +207,7 @@
 	extern uint8_t tmcm_getModuleSpecificIOPin(uint8_t pin);
 	extern uint8_t tmcm_getModuleSpecificIOPinStatus(uint8_t pin);
 	extern uint16_t tmcm_getModuleSpecificADCValue(uint8_t pin);
+	extern uint16_t tmcm_getModuleSpecificOversampledADCValue(uint8_t pin);
+	extern uint8_t tmcm_getADCSampleReady();
 
 #endif /* DEFINITIONS_H */
@@ -0,0 +1,53 @@
+/*
+ * Estimator.c
+ *
+ *  Steady state Kalman filters for the measured signals
+ *
+ *  Each signal is modeled as value and slope with random changes of the slope (constant velocity
+ *  model, sampled every 1 ms). For this model the Kalman gains converge to the constant alpha/beta
+ *  gains of the tracking index lambda = process noise / measurement noise (Kalata), so they are
+ *  calculated once on a configuration change and the filter costs only a few multiplications per tick.
+ *  Unlike a PT1 filter, the estimate follows ramps without a lag.
+ *
+ *  A known model input (e.g. the blower pressure change from the speed change) is added to the
+ *  prediction, so the estimate reacts before the measurement does.
+ *  Ticks without a valid measurement only do the prediction.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Estimator.h"
+#include <math.h>
+
+/* calculate the steady state gains from the tracking index lambda [1/1000] */
+void estimator_setNoiseRatio(AlphaBetaFilter *filter, uint16_t noiseRatio)
+{
+	float lambda = noiseRatio / 1000.0f;
+	float r = (4.0f + lambda - sqrtf(8.0f * lambda + lambda * lambda)) / 4.0f;
+	float alpha = 1.0f - r * r;
+	float beta = 2.0f * (2.0f - alpha) - 4.0f * sqrtf(1.0f - alpha);
+
+	filter->alpha = alpha * 65536.0f;
+	filter->beta = beta * 65536.0f;
+}
+
+void estimator_reset(AlphaBetaFilter *filter, int32_t value)
+{
+	filter->value = (int64_t)value << 16;
+	filter->slope = 0;
+}
+
+/* one filter step (1 ms), input: known change of the value by the model q16 */
+void estimator_update(AlphaBetaFilter *filter, int32_t measurement, bool isMeasurementValid, int64_t input)
+{
+	// prediction
+	filter->value += filter->slope + input;
+
+	// correction
+	if (isMeasurementValid)
+	{
+		int64_t residual = ((int64_t)measurement << 16) - filter->value;
+		filter->value += (residual * filter->alpha) >> 16;
+		filter->slope += (residual * filter->beta) >> 16;
+	}
+}
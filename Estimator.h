@@ -0,0 +1,38 @@
+/*
+ * Estimator.h
+ *
+ *  Steady state Kalman filters for the measured signals
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+
+	#include "TMC-API/tmc/helpers/API_Header.h"
+
+	typedef struct
+	{
+		int32_t alpha;		// steady state Kalman gains q16
+		int32_t beta;
+		int64_t value;		// estimate q16
+		int64_t slope;		// estimated change per ms q16
+	} AlphaBetaFilter;
+
+	void estimator_setNoiseRatio(AlphaBetaFilter *filter, uint16_t noiseRatio);
+	void estimator_reset(AlphaBetaFilter *filter, int32_t value);
+	void estimator_update(AlphaBetaFilter *filter, int32_t measurement, bool isMeasurementValid, int64_t input);
+
+	/* estimated value */
+	static inline int32_t estimator_getValue(const AlphaBetaFilter *filter)
+	{
+		return filter->value >> 16;
+	}
+
+	/* estimated change per ms q16 */
+	static inline int32_t estimator_getSlope(const AlphaBetaFilter *filter)
+	{
+		return filter->slope;
+	}
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * LungMechanics.c
+ *
+ *  Least squares estimation of resistance, compliance and total PEEP
+ *
+ *  Equation of motion of the respiratory system (airway pressure, flow, volume since breath start):
+ *      pressure = R * flow + volume / C + PEEPtotal
+ *
+ *  Every tick the sample is added to the normal equations (integer multiply-accumulates, no division).
+ *  Once per breath the 3x3 system is solved (one division) and the sums are weighted down, so
+ *  older breaths are forgotten exponentially (recursive least squares in information form).
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "LungMechanics.h"
+
+	#define LUNG_FORGET_SHIFT		1		// weight of the previous breaths halves per breath
+	#define LUNG_MIN_SAMPLES		500		// [ms] min. breath length for an update
+	#define LUNG_MIN_CONDITION		1e-9	// min. normalized determinant (excitation of all regressors)
+
+void lungMechanics_reset(LungMechanics *lung)
+{
+	for (int i = 0; i < LUNG_PARAMETERS; i++)
+	{
+		for (int j = 0; j < LUNG_PARAMETERS; j++)
+			lung->information[i][j] = 0;
+
+		lung->correlation[i] = 0;
+	}
+
+	lung->samples = 0;
+	lung->resistance = 0;
+	lung->compliance = 0;
+	lung->totalPeep = 0;
+	lung->updates = 0;
+	lung->rejectedUpdates = 0;
+}
+
+/* add one sample (pressure [Pa], flow [ml/min], volume [ml]) */
+void lungMechanics_addSample(LungMechanics *lung, int32_t pressure, int32_t flow, int32_t volume)
+{
+	lung->information[0][0] += (int64_t)flow * flow;
+	lung->information[0][1] += (int64_t)flow * volume;
+	lung->information[0][2] += flow;
+	lung->information[1][1] += (int64_t)volume * volume;
+	lung->information[1][2] += volume;
+	lung->information[2][2] += 1;
+
+	lung->correlation[0] += (int64_t)flow * pressure;
+	lung->correlation[1] += (int64_t)volume * pressure;
+	lung->correlation[2] += pressure;
+
+	lung->samples++;
+}
+
+/* solve the normal equations at the end of a breath, returns true if the results have been updated */
+bool lungMechanics_update(LungMechanics *lung)
+{
+	bool isUpdated = false;
+
+	if (lung->samples >= LUNG_MIN_SAMPLES)
+	{
+		double a00 = lung->information[0][0], a01 = lung->information[0][1], a02 = lung->information[0][2];
+		double a11 = lung->information[1][1], a12 = lung->information[1][2], a22 = lung->information[2][2];
+		double b0 = lung->correlation[0], b1 = lung->correlation[1], b2 = lung->correlation[2];
+
+		// Cramer's rule with the cofactors of the symmetric matrix
+		double c00 = a11*a22 - a12*a12;
+		double c01 = a02*a12 - a01*a22;
+		double c02 = a01*a12 - a02*a11;
+		double det = a00*c00 + a01*c01 + a02*c02;
+
+		if (det > LUNG_MIN_CONDITION * a00 * a11 * a22)
+		{
+			double inverseDet = 1.0 / det;
+			double r = (b0*c00 + b1*c01 + b2*c02) * inverseDet;							// [Pa per ml/min]
+			double e = (b0*c01 + b1*(a00*a22 - a02*a02) + b2*(a01*a02 - a00*a12)) * inverseDet;	// elastance [Pa/ml]
+			double p = (b0*c02 + b1*(a01*a02 - a00*a12) + b2*(a00*a11 - a01*a01)) * inverseDet;	// [Pa]
+
+			// only physically meaningful results
+			if ((r >= 0.0) && (e > 0.0))
+			{
+				lung->resistance = r * 60000.0;
+				lung->compliance = 1000.0 / e;
+				lung->totalPeep = p;
+				lung->updates++;
+				isUpdated = true;
+			}
+		}
+
+		if (!isUpdated)
+			lung->rejectedUpdates++;
+	}
+
+	// forget the previous breaths
+	for (int i = 0; i < LUNG_PARAMETERS; i++)
+	{
+		for (int j = i; j < LUNG_PARAMETERS; j++)
+			lung->information[i][j] -= lung->information[i][j] >> LUNG_FORGET_SHIFT;
+
+		lung->correlation[i] -= lung->correlation[i] >> LUNG_FORGET_SHIFT;
+	}
+	lung->samples = 0;
+
+	return isUpdated;
+}
@@ -0,0 +1,34 @@
+/*
+ * LungMechanics.h
+ *
+ *  Least squares estimation of resistance, compliance and total PEEP
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef LUNGMECHANICS_H
+#define LUNGMECHANICS_H
+
+	#include "TMC-API/tmc/helpers/API_Header.h"
+
+	#define LUNG_PARAMETERS		3	// regressors: flow, volume, 1
+
+	typedef struct
+	{
+		int64_t information[LUNG_PARAMETERS][LUNG_PARAMETERS];	// weighted sums of phi*phi' (upper triangle)
+		int64_t correlation[LUNG_PARAMETERS];					// weighted sums of phi*pressure
+		uint32_t samples;										// samples of the actual breath
+
+		// results of the last update
+		int32_t resistance;		// [Pa/(l/s)]
+		int32_t compliance;		// [ml/kPa]
+		int32_t totalPeep;		// [Pa]
+		uint32_t updates;
+		uint32_t rejectedUpdates;
+	} LungMechanics;
+
+	void lungMechanics_reset(LungMechanics *lung);
+	void lungMechanics_addSample(LungMechanics *lung, int32_t pressure, int32_t flow, int32_t volume);
+	bool lungMechanics_update(LungMechanics *lung);
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * PID.c
+ *
+ *  Fixed point PID regulator
+ *
+ *  - P part with setpoint weighting
+ *  - I part with back calculation anti windup: the part of the output cut by the limits
+ *    is fed back into the integral, so the regulator leaves the limit without overshoot
+ *  - D part on the actual value (no kick on setpoint steps) with PT1 filter
+ *  - output rate limit
+ *  - bumpless handover: the integral is preset to continue with a given output
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "PID.h"
+
+int32_t pid_getProportionalPart(PIDControl *pid, int32_t target, int32_t actual);
+
+/* reset the regulator state, the parameters are kept */
+void pid_reset(PIDControl *pid)
+{
+	pid->error = 0;
+	pid->integral = 0;
+	pid->dFilterAkku = 0;
+	pid->dPart = 0;
+	pid->lastActual = 0;
+	pid->result = 0;
+}
+
+/* preset the regulator to continue with the given output (call on regulation mode change) */
+void pid_handover(PIDControl *pid, int32_t target, int32_t actual, int32_t output)
+{
+	pid->error = target-actual;
+	pid->dFilterAkku = 0;
+	pid->dPart = 0;
+	pid->lastActual = actual;
+	pid->result = output;
+	pid->integral = ((int64_t)output - pid_getProportionalPart(pid, target, actual)) * ((int64_t)1 << pid->iShift);
+}
+
+int32_t pid_process(PIDControl *pid, int32_t target, int32_t actual, int32_t minOutput, int32_t maxOutput)
+{
+	pid->error = target-actual;
+
+	int64_t pPart = pid_getProportionalPart(pid, target, actual);
+
+	// D part on the actual value
+	int32_t derivative = ((int64_t)pid->dParam * (pid->lastActual-actual)) >> pid->pShift;
+	pid->dFilterAkku += derivative - (pid->dFilterAkku >> pid->dFilterShift);
+	pid->dPart = pid->dFilterAkku >> pid->dFilterShift;
+	pid->lastActual = actual;
+
+	// I part
+	pid->integral += (int64_t)pid->iParam * pid->error;
+
+	int64_t output = pPart + (pid->integral >> pid->iShift) + pid->dPart;
+
+	// limit output and output change
+	int32_t result = tmc_limitS64(output, minOutput, maxOutput);
+	if (pid->maxOutputStep > 0)
+		result = tmc_limitInt(result, pid->result-pid->maxOutputStep, pid->result+pid->maxOutputStep);
+
+	// back calculation anti windup (multiplied, a left shift of the negative values is undefined)
+	pid->integral += (((int64_t)result - output) * pid->trackingGain * ((int64_t)1 << pid->iShift)) >> 8;
+
+	pid->result = result;
+	return result;
+}
+
+/* I part in output units */
+int32_t pid_getIntegral(PIDControl *pid)
+{
+	return pid->integral >> pid->iShift;
+}
+
+int32_t pid_getProportionalPart(PIDControl *pid, int32_t target, int32_t actual)
+{
+	int32_t weightedError = (((int64_t)target * pid->setpointWeight) >> 8) - actual;
+	return ((int64_t)pid->pParam * weightedError) >> pid->pShift;
+}
@@ -0,0 +1,41 @@
+/*
+ * PID.h
+ *
+ *  Fixed point PID regulator
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef PID_H
+#define PID_H
+
+	#include "TMC-API/tmc/helpers/API_Header.h"
+
+	typedef struct
+	{
+		// parameters
+		int32_t pParam;				// P parameter, scaled by 2^pShift
+		int32_t iParam;				// I parameter, scaled by 2^iShift
+		int32_t dParam;				// D parameter, scaled by 2^pShift
+		uint8_t pShift;
+		uint8_t iShift;
+		uint8_t dFilterShift;		// PT1 filter of the D part with 2^dFilterShift ticks
+		uint16_t setpointWeight;	// setpoint weight of the P part (256 = 1.0)
+		uint16_t trackingGain;		// back calculation gain of the anti windup (256 = 1.0)
+		int32_t maxOutputStep;		// max. output change per tick (0 = no limit)
+
+		// state
+		int32_t error;				// regulation error
+		int64_t integral;			// I part, scaled by 2^iShift
+		int64_t dFilterAkku;
+		int32_t dPart;
+		int32_t lastActual;
+		int32_t result;				// (limited) result of the PID regulator
+	} PIDControl;
+
+	void pid_reset(PIDControl *pid);
+	void pid_handover(PIDControl *pid, int32_t target, int32_t actual, int32_t output);
+	int32_t pid_process(PIDControl *pid, int32_t target, int32_t actual, int32_t minOutput, int32_t maxOutput);
+	int32_t pid_getIntegral(PIDControl *pid);
+
+#endif
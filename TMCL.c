@@ -9,11 +9,13 @@
 #include "hal/system/SysTick.h"
 #include "hal/system/SystemInfo.h"
 #include "hal/system/Debug.h"
+#include "hal/system/Recorder.h"
 #include "hal/comm/Eeprom.h"
 #include "hal/comm/RS485.h"
 #include "hal/comm/SPI.h"
 #include "hal/tmcl/TMCL-Variables.h"
 #include "TOSV.h"
+#include "Benchmark.h"
 
 #ifdef USE_UART_INTERFACE
 	#include "hal/comm/UART.h"
@@ -25,10 +27,14 @@
 
 	#define AIRCR_VECTKEY_MASK    ((uint32_t)0x05FA0000)
 
-	uint8_t ResetRequested;
+	INSTANCE_STATE uint8_t ResetRequested;
 	extern const char *VersionString;
 	uint32_t TMCM_MOTOR_CONFIG_SIZE = sizeof(TMotorConfig);
 
+	INSTANCE_STATE uint8_t flowCalIndex = 0;		// selected point of the flow calibration table
+	INSTANCE_STATE uint8_t pressureCalIndex = 0;	// selected point of the pressure calibration table
+	INSTANCE_STATE uint8_t pressureGainIndex = 0;	// selected gain set of the pressure regulator gain scheduling
+
 	// local used functions
 	uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type, int32_t *value);
 
@@ -41,6 +47,9 @@
 	void tmcl_firmwareDefault();
 	void tmcl_boot();
 	void tmcl_softwareReset();
+	void tmcl_autotune();
+	void tmcl_recorder();
+	void tmcl_benchmark();
 
 // => SPI wrapper for TMC-API
 u8 tmc4671_readwriteByte(u8 motor, u8 data, u8 lastTransfer)
@@ -62,6 +71,10 @@ void tmcl_executeActualCommand()
 	ActualReply.Status = REPLY_OK;
 	ActualReply.Value.Int32 = ActualCommand.Value.Int32;
 
+	// commands are inputs of the control loop too (except the download of the recording)
+	if (ActualCommand.Opcode != TMCL_Recorder)
+		recorder_addCommand(ActualCommand.Opcode, ActualCommand.Type, ActualCommand.Motor, ActualCommand.Value.Int32);
+
 	// handle command
 	switch(ActualCommand.Opcode)
 	{
@@ -114,6 +127,15 @@ void tmcl_executeActualCommand()
     	case TMCL_SoftwareReset:
     		tmcl_softwareReset();
     		break;
+    	case TMCL_Autotune:
+    		tmcl_autotune();
+    		break;
+    	case TMCL_Recorder:
+    		tmcl_recorder();
+    		break;
+    	case TMCL_Benchmark:
+    		tmcl_benchmark();
+    		break;
     	default:
     		ActualReply.Status = REPLY_INVALID_CMD;
     		break;
@@ -128,18 +150,17 @@ void tmcl_init()
 /* process next TMCL command */
 void tmcl_processCommand()
 {
-	static uint8_t TMCLCommandState;
-    uint32_t i;
+	static INSTANCE_STATE uint8_t TMCLCommandState;
 
 #ifdef USE_UART_INTERFACE
     uint8_t Byte;
-    static uint8_t UARTCmd[9];
-    static uint8_t UARTCount;
+    static INSTANCE_STATE uint8_t UARTCmd[9];
+    static INSTANCE_STATE uint8_t UARTCount;
 #endif
 
 #ifdef USE_RS485_INTERFACE
-    static uint8_t RS485Cmd[9];
-    static uint8_t RS485Count;
+    static INSTANCE_STATE uint8_t RS485Cmd[9];
+    static INSTANCE_STATE uint8_t RS485Count;
 #endif
 
 #ifdef USE_USB_INTERFACE
@@ -172,7 +193,7 @@ void tmcl_processCommand()
     	}
     	else if(TMCLReplyFormat==RF_SPECIAL)
     	{
-    		for(i=0; i<9; i++)
+    		for(uint32_t i=0; i<9; i++)
     		{
     			uart_write(SpecialReply[i]);
     		}
@@ -225,7 +246,7 @@ void tmcl_processCommand()
     	}
     	else if(TMCLReplyFormat==RF_SPECIAL)
     	{
-    		for(i=0; i<9; i++)
+    		for(uint32_t i=0; i<9; i++)
     		{
     			rs485_write(SpecialReply[i]);
     		}
@@ -278,7 +299,7 @@ void tmcl_processCommand()
     	}
     	else if(TMCLReplyFormat==RF_SPECIAL)
     	{
-    		for(i=0; i<9; i++)
+    		for(uint32_t i=0; i<9; i++)
     		{
     			USBReply[i]=SpecialReply[i];
     		}
@@ -344,21 +365,8 @@ void tmcl_processCommand()
 
   			if(UARTCmd[0] == moduleConfig.serialModuleAddress)  // is this our address?
   			{
-  				uint8_t checksum = 0;
-  				for(i=0; i<8; i++)
-  					checksum+=UARTCmd[i];
-
-  				if(checksum==UARTCmd[8])  // is the checksum correct?
-  				{
-  					ActualCommand.Opcode=UARTCmd[1];
-  					ActualCommand.Type=UARTCmd[2];
-  					ActualCommand.Motor=UARTCmd[3];
-  					ActualCommand.Value.Byte[3]=UARTCmd[4];
-  					ActualCommand.Value.Byte[2]=UARTCmd[5];
-  					ActualCommand.Value.Byte[1]=UARTCmd[6];
-  					ActualCommand.Value.Byte[0]=UARTCmd[7];
+  				if(tmcl_parseFrame(UARTCmd, &ActualCommand))  // is the checksum correct?
   					TMCLCommandState = TCS_UART;
-  				}
   				else TMCLCommandState = TCS_UART_ERROR;  //Checksum wrong
   			}
   		}
@@ -381,21 +389,8 @@ void tmcl_processCommand()
 
   			if(RS485Cmd[0] == moduleConfig.serialModuleAddress)  // is this our address?
   			{
-  				uint8_t checksum = 0;
-  				for(i=0; i<8; i++)
-  					checksum+=RS485Cmd[i];
-
-  				if(checksum==RS485Cmd[8])  // is the checksum correct?
-  				{
-  					ActualCommand.Opcode=RS485Cmd[1];
-  					ActualCommand.Type=RS485Cmd[2];
-  					ActualCommand.Motor=RS485Cmd[3];
-  					ActualCommand.Value.Byte[3]=RS485Cmd[4];
-  					ActualCommand.Value.Byte[2]=RS485Cmd[5];
-  					ActualCommand.Value.Byte[1]=RS485Cmd[6];
-  					ActualCommand.Value.Byte[0]=RS485Cmd[7];
+  				if(tmcl_parseFrame(RS485Cmd, &ActualCommand))  // is the checksum correct?
   					TMCLCommandState = TCS_RS485;
-  				}
   				else TMCLCommandState = TCS_RS485_ERROR;  //Checksum wrong
   			}
   		}
@@ -410,21 +405,9 @@ void tmcl_processCommand()
 
     	if(USBCmd[0] == moduleConfig.serialModuleAddress)	 // check address
     	{
-    		uint8_t checksum=0;
-    		for(i=0; i<8; i++)
-    			checksum+=USBCmd[i];
-
-    		if(checksum==USBCmd[8])  // check checksum
-    		{
-    			ActualCommand.Opcode=USBCmd[1];
-    			ActualCommand.Type=USBCmd[2];
-    			ActualCommand.Motor=USBCmd[3];
-    			ActualCommand.Value.Byte[3]=USBCmd[4];
-    			ActualCommand.Value.Byte[2]=USBCmd[5];
-    			ActualCommand.Value.Byte[1]=USBCmd[6];
-    			ActualCommand.Value.Byte[0]=USBCmd[7];
+    		if(tmcl_parseFrame(USBCmd, &ActualCommand))  // check checksum
     			TMCLCommandState = TCS_USB;
-    		} else TMCLCommandState = TCS_USB_ERROR;  // checksum was wrong
+    		else TMCLCommandState = TCS_USB_ERROR;  // checksum was wrong
     	}
     }
 #endif
@@ -434,6 +417,26 @@ void tmcl_processCommand()
    		tmcl_executeActualCommand();
 }
 
+/* check the checksum of a received 9 byte frame (address, opcode, type, motor, value, checksum) and decode it */
+bool tmcl_parseFrame(const uint8_t *frame, TTMCLCommand *command)
+{
+	uint8_t checksum = 0;
+	for(int i=0; i<8; i++)
+		checksum+=frame[i];
+
+	if(checksum!=frame[8])
+		return false;
+
+	command->Opcode=frame[1];
+	command->Type=frame[2];
+	command->Motor=frame[3];
+	command->Value.Byte[3]=frame[4];
+	command->Value.Byte[2]=frame[5];
+	command->Value.Byte[1]=frame[6];
+	command->Value.Byte[0]=frame[7];
+	return true;
+}
+
 /* TMCL command ROL */
 void tmcl_rotateLeft()
 {
@@ -566,6 +569,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 				} else if (command == TMCL_RSAP) {
 					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].motorPolePairs-(u32)&motorConfig[motor],
 							(u8 *)&motorConfig[motor].motorPolePairs, sizeof(motorConfig[motor].motorPolePairs));
+					bldc_updateConversions(motor);
 				}
 				break;
 			case 11: // max current
@@ -583,6 +587,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 				} else if (command == TMCL_RSAP) {
 					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].absMaxPositiveCurrent-(u32)&motorConfig[motor],
 							(u8 *)&motorConfig[motor].absMaxPositiveCurrent, sizeof(motorConfig[motor].absMaxPositiveCurrent));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
 			case 12: // open loop current
@@ -771,6 +776,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 				if (command == TMCL_SAP)
 				{
 					motorConfig[motor].maxPressure = *value;
+					bldc_updateRegulatorSettings(motor);
 				} else if (command == TMCL_GAP) {
 					*value = motorConfig[motor].maxPressure;
 				} else if (command == TMCL_STAP) {
@@ -779,6 +785,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 				} else if (command == TMCL_RSAP) {
 					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].maxPressure-(u32)&motorConfig[motor],
 							(u8 *)&motorConfig[motor].maxPressure, sizeof(motorConfig[motor].maxPressure));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
 
@@ -871,6 +878,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 					if((*value >= 0) && (*value <= 32767))
 					{
 						motorConfig[motor].pidPressure_P_param = *value;
+						bldc_updateRegulatorSettings(motor);
 					}
 					else
 						errors = REPLY_INVALID_VALUE;
@@ -882,6 +890,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 				} else if (command == TMCL_RSAP) {
 					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressure_P_param-(u32)&motorConfig[motor],
 							(u8 *)&motorConfig[motor].pidPressure_P_param, sizeof(motorConfig[motor].pidPressure_P_param));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
 			case 40: // pressure I
@@ -890,6 +899,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 					if((*value >= 0) && (*value <= 32767))
 					{
 						motorConfig[motor].pidPressure_I_param = *value;
+						bldc_updateRegulatorSettings(motor);
 					}
 					else
 						errors = REPLY_INVALID_VALUE;
@@ -901,6 +911,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 				} else if (command == TMCL_RSAP) {
 					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressure_I_param-(u32)&motorConfig[motor],
 							(u8 *)&motorConfig[motor].pidPressure_I_param, sizeof(motorConfig[motor].pidPressure_I_param));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
 
@@ -961,6 +972,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 				} else if (command == TMCL_RSAP) {
 					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].absMaxNegativeCurrent-(u32)&motorConfig[motor],
 							(u8 *)&motorConfig[motor].absMaxNegativeCurrent, sizeof(motorConfig[motor].absMaxNegativeCurrent));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
 
@@ -1058,6 +1070,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 					if((*value >= 0) && (*value <= 32767))
 					{
 						motorConfig[motor].pidVolume_P_param = *value;
+						bldc_updateRegulatorSettings(motor);
 					}
 					else
 						errors = REPLY_INVALID_VALUE;
@@ -1069,6 +1082,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 				} else if (command == TMCL_RSAP) {
 					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidVolume_P_param-(u32)&motorConfig[motor],
 							(u8 *)&motorConfig[motor].pidVolume_P_param, sizeof(motorConfig[motor].pidVolume_P_param));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
 			case 57: // volume I
@@ -1077,6 +1091,7 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 					if((*value >= 0) && (*value <= 32767))
 					{
 						motorConfig[motor].pidVolume_I_param = *value;
+						bldc_updateRegulatorSettings(motor);
 					}
 					else
 						errors = REPLY_INVALID_VALUE;
@@ -1088,353 +1103,1638 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 				} else if (command == TMCL_RSAP) {
 					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidVolume_I_param-(u32)&motorConfig[motor],
 							(u8 *)&motorConfig[motor].pidVolume_I_param, sizeof(motorConfig[motor].pidVolume_I_param));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
 
-			// ===== brake chopper settings  =====
-			case 95: // enable brake chopper
-				if (command == TMCL_SAP) {
-					motorConfig[motor].brakeChopperEnabled = (*value) ? 1:0;
-					bldc_updateBrakeChopperConfig(motor);
+			// ===== flow control mode settings =====
+
+			case 92: // target flow [ml/min]
+				if (command == TMCL_SAP)
+				{
+					if(!bldc_setTargetFlow(motor, *value))
+						errors = REPLY_INVALID_VALUE;
 				} else if (command == TMCL_GAP) {
-					*value = motorConfig[motor].brakeChopperEnabled;
-				} else if (command == TMCL_STAP) {
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperEnabled-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].brakeChopperEnabled, sizeof(motorConfig[motor].brakeChopperEnabled));
-				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperEnabled-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].brakeChopperEnabled, sizeof(motorConfig[motor].brakeChopperEnabled));
+					*value = bldc_getTargetFlow(motor);
 				}
 				break;
-			case 96: // brake chopper voltage limit
-				if (command == TMCL_SAP) {
-					motorConfig[motor].brakeChopperVoltage = *value;
-					bldc_updateBrakeChopperConfig(motor);
+			case 93: // flow P
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 32767))
+					{
+						motorConfig[motor].pidFlow_P_param = *value;
+						bldc_updateRegulatorSettings(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
 				} else if (command == TMCL_GAP) {
-					*value = motorConfig[motor].brakeChopperVoltage;
+					*value = motorConfig[motor].pidFlow_P_param;
 				} else if (command == TMCL_STAP) {
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperVoltage-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].brakeChopperVoltage, sizeof(motorConfig[motor].brakeChopperVoltage));
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidFlow_P_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidFlow_P_param, sizeof(motorConfig[motor].pidFlow_P_param));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperVoltage-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].brakeChopperVoltage, sizeof(motorConfig[motor].brakeChopperVoltage));
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidFlow_P_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidFlow_P_param, sizeof(motorConfig[motor].pidFlow_P_param));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
-			case 97: // brake chopper hysteresis
-				if (command == TMCL_SAP) {
-					motorConfig[motor].brakeChopperHysteresis = *value;
-					bldc_updateBrakeChopperConfig(motor);
+			case 94: // flow I
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 32767))
+					{
+						motorConfig[motor].pidFlow_I_param = *value;
+						bldc_updateRegulatorSettings(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
 				} else if (command == TMCL_GAP) {
-					*value = motorConfig[motor].brakeChopperHysteresis;
+					*value = motorConfig[motor].pidFlow_I_param;
 				} else if (command == TMCL_STAP) {
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperHysteresis-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].brakeChopperHysteresis, sizeof(motorConfig[motor].brakeChopperHysteresis));
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidFlow_I_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidFlow_I_param, sizeof(motorConfig[motor].pidFlow_I_param));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperHysteresis-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].brakeChopperHysteresis, sizeof(motorConfig[motor].brakeChopperHysteresis));
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidFlow_I_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidFlow_I_param, sizeof(motorConfig[motor].pidFlow_I_param));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
 
-			// ===== tosv settings =====
-			case 99: // TOSV mode
+			// ===== pressure sensor calibration =====
+
+			case 58: // pressure sensor auto zero
 				if (command == TMCL_SAP)
 				{
-					if (*value == 0)
-						tosvConfig[motor].mode = TOSV_MODE_PRESSURE_CONTROL;
-					else if (*value == 1)
-						tosvConfig[motor].mode = TOSV_MODE_VOLUME_CONTROL;
-					else
+					if(!bldc_startPressureAutoZero(motor))
 						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = bldc_isPressureAutoZeroActive(motor);
 				}
-				else if (command == TMCL_GAP)
+				break;
+			case 59: // pressure sensor offset
+				if (command == TMCL_SAP)
 				{
-					*value = tosvConfig[motor].mode;
+					motorConfig[motor].pressureCalOffset = *value;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pressureCalOffset;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pressureCalOffset-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pressureCalOffset, sizeof(motorConfig[motor].pressureCalOffset));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pressureCalOffset-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pressureCalOffset, sizeof(motorConfig[motor].pressureCalOffset));
 				}
 				break;
-			case 100: // enable tosv
+			case 60: // pressure calibration point index
 				if (command == TMCL_SAP)
 				{
-					// todo: add value check for enable:  *value==0x1234
-					// todo: add value check for disable: *value==0x4321
-					tosv_enableVentilator(&tosvConfig[motor], *value);
+					if ((*value >= 0) && (*value < PRESSURE_CAL_POINTS))
+						pressureCalIndex = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = pressureCalIndex;
 				}
-				else if (command == TMCL_GAP)
+				break;
+			case 61: // pressure calibration point ADC value
+				if (command == TMCL_SAP)
 				{
-					*value = tosv_isVentilatorEnabled(&tosvConfig[motor]);
+					if ((*value >= 0) && (*value <= 65535))
+					{
+						motorConfig[motor].pressureCalAdc[pressureCalIndex] = *value;
+						bldc_updatePressureCalibration(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pressureCalAdc[pressureCalIndex];
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pressureCalAdc[pressureCalIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pressureCalAdc[pressureCalIndex], sizeof(motorConfig[motor].pressureCalAdc[pressureCalIndex]));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pressureCalAdc[pressureCalIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pressureCalAdc[pressureCalIndex], sizeof(motorConfig[motor].pressureCalAdc[pressureCalIndex]));
+					bldc_updatePressureCalibration(motor);
 				}
 				break;
-			case 101: // actual state
-				if(command==TMCL_GAP)
+			case 62: // pressure calibration point pressure
+				if (command == TMCL_SAP)
 				{
-					*value = tosvConfig[motor].actualState;
+					motorConfig[motor].pressureCalPressure[pressureCalIndex] = *value;
+					bldc_updatePressureCalibration(motor);
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pressureCalPressure[pressureCalIndex];
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pressureCalPressure[pressureCalIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pressureCalPressure[pressureCalIndex], sizeof(motorConfig[motor].pressureCalPressure[pressureCalIndex]));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pressureCalPressure[pressureCalIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pressureCalPressure[pressureCalIndex], sizeof(motorConfig[motor].pressureCalPressure[pressureCalIndex]));
+					bldc_updatePressureCalibration(motor);
 				}
 				break;
-			case 102: // timer
-				if(command==TMCL_GAP)
+			case 63: // pressure sensor ADC value (oversampled)
+				if (command == TMCL_GAP)
 				{
-					*value = tosvConfig[motor].timer;
+					*value = bldc_getPressureAdcValue(motor);
 				}
 				break;
-			case 103: // startup time
+
+			// ===== pid regulator extensions =====
+
+			case 64: // pressure D
 				if (command == TMCL_SAP)
 				{
-					if((*value >= 0) && (*value <= 65535))
-						tosvConfig[motor].tStartup = *value;
+					if((*value >= 0) && (*value <= 32767))
+					{
+						motorConfig[motor].pidPressure_D_param = *value;
+						bldc_updateRegulatorSettings(motor);
+					}
 					else
 						errors = REPLY_INVALID_VALUE;
-				}
-				else if (command == TMCL_GAP)
-				{
-					*value = tosvConfig[motor].tStartup;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pidPressure_D_param;
 				} else if (command == TMCL_STAP) {
-					motorConfig[0].tStartup = tosvConfig[motor].tStartup;
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tStartup-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].tStartup, sizeof(motorConfig[motor].tStartup));
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressure_D_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressure_D_param, sizeof(motorConfig[motor].pidPressure_D_param));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tStartup-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].tStartup, sizeof(motorConfig[motor].tStartup));
-					tosvConfig[motor].tStartup = motorConfig[motor].tStartup;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressure_D_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressure_D_param, sizeof(motorConfig[motor].pidPressure_D_param));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
-			case 104: // inhalation rise time
+			case 65: // volume D
 				if (command == TMCL_SAP)
 				{
-					if((*value >= 0) && (*value <= 65535))
-						tosvConfig[motor].tInhalationRise = *value;
+					if((*value >= 0) && (*value <= 32767))
+					{
+						motorConfig[motor].pidVolume_D_param = *value;
+						bldc_updateRegulatorSettings(motor);
+					}
 					else
 						errors = REPLY_INVALID_VALUE;
-				}
-				else if (command == TMCL_GAP)
-				{
-					*value = tosvConfig[motor].tInhalationRise;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pidVolume_D_param;
 				} else if (command == TMCL_STAP) {
-					motorConfig[0].tInhalationRise = tosvConfig[motor].tInhalationRise;
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tInhalationRise-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].tInhalationRise, sizeof(motorConfig[motor].tInhalationRise));
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidVolume_D_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidVolume_D_param, sizeof(motorConfig[motor].pidVolume_D_param));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tInhalationRise-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].tInhalationRise, sizeof(motorConfig[motor].tInhalationRise));
-					tosvConfig[motor].tInhalationRise = motorConfig[motor].tInhalationRise;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidVolume_D_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidVolume_D_param, sizeof(motorConfig[motor].pidVolume_D_param));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
-			case 105: // inhalation pause time
+			case 66: // pressure setpoint weight (256 = 1.0)
 				if (command == TMCL_SAP)
 				{
-					if((*value >= 0) && (*value <= 65535))
-						tosvConfig[motor].tInhalationPause = *value;
+					if((*value >= 0) && (*value <= 256))
+					{
+						motorConfig[motor].pidPressureSetpointWeight = *value;
+						bldc_updateRegulatorSettings(motor);
+					}
 					else
 						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pidPressureSetpointWeight;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureSetpointWeight-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureSetpointWeight, sizeof(motorConfig[motor].pidPressureSetpointWeight));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureSetpointWeight-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureSetpointWeight, sizeof(motorConfig[motor].pidPressureSetpointWeight));
+					bldc_updateRegulatorSettings(motor);
 				}
-				else if (command == TMCL_GAP)
+				break;
+			case 67: // volume setpoint weight (256 = 1.0)
+				if (command == TMCL_SAP)
 				{
-					*value = tosvConfig[motor].tInhalationPause;
+					if((*value >= 0) && (*value <= 256))
+					{
+						motorConfig[motor].pidVolumeSetpointWeight = *value;
+						bldc_updateRegulatorSettings(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pidVolumeSetpointWeight;
 				} else if (command == TMCL_STAP) {
-					motorConfig[0].tInhalationPause = tosvConfig[motor].tInhalationPause;
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tInhalationPause-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].tInhalationPause, sizeof(motorConfig[motor].tInhalationPause));
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidVolumeSetpointWeight-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidVolumeSetpointWeight, sizeof(motorConfig[motor].pidVolumeSetpointWeight));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tInhalationPause-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].tInhalationPause, sizeof(motorConfig[motor].tInhalationPause));
-					tosvConfig[motor].tInhalationPause = motorConfig[motor].tInhalationPause;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidVolumeSetpointWeight-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidVolumeSetpointWeight, sizeof(motorConfig[motor].pidVolumeSetpointWeight));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
-			case 106: // exhalation fall time
+			case 68: // max torque change per ms (0 = no limit)
 				if (command == TMCL_SAP)
 				{
 					if((*value >= 0) && (*value <= 65535))
-						tosvConfig[motor].tExhalationFall = *value;
+					{
+						motorConfig[motor].maxTorqueStep = *value;
+						bldc_updateRegulatorSettings(motor);
+					}
 					else
 						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].maxTorqueStep;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].maxTorqueStep-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].maxTorqueStep, sizeof(motorConfig[motor].maxTorqueStep));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].maxTorqueStep-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].maxTorqueStep, sizeof(motorConfig[motor].maxTorqueStep));
+					bldc_updateRegulatorSettings(motor);
 				}
-				else if (command == TMCL_GAP)
+				break;
+
+			// ===== pressure feed forward =====
+
+			case 69: // pressure feed forward enable
+				if (command == TMCL_SAP)
 				{
-					*value = tosvConfig[motor].tExhalationFall;
+					if((*value >= 0) && (*value <= 1))
+						motorConfig[motor].ffEnable = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].ffEnable;
 				} else if (command == TMCL_STAP) {
-					motorConfig[0].tExhalationFall = tosvConfig[motor].tExhalationFall;
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tExhalationFall-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].tExhalationFall, sizeof(motorConfig[motor].tExhalationFall));
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ffEnable-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ffEnable, sizeof(motorConfig[motor].ffEnable));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tExhalationFall-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].tExhalationFall, sizeof(motorConfig[motor].tExhalationFall));
-					tosvConfig[motor].tExhalationFall = motorConfig[motor].tExhalationFall;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ffEnable-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ffEnable, sizeof(motorConfig[motor].ffEnable));
 				}
 				break;
-			case 107: // exhalation pause time
+			case 70: // feed forward pressure gain [mA per 1024 Pa]
 				if (command == TMCL_SAP)
 				{
 					if((*value >= 0) && (*value <= 65535))
-						tosvConfig[motor].tExhalationPause = *value;
+						motorConfig[motor].ffPressureGain = *value;
 					else
 						errors = REPLY_INVALID_VALUE;
-				}
-				else if (command == TMCL_GAP)
-				{
-					*value = tosvConfig[motor].tExhalationPause;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].ffPressureGain;
 				} else if (command == TMCL_STAP) {
-					motorConfig[0].tExhalationPause = tosvConfig[motor].tExhalationPause;
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tExhalationPause-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].tExhalationPause, sizeof(motorConfig[motor].tExhalationPause));
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ffPressureGain-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ffPressureGain, sizeof(motorConfig[motor].ffPressureGain));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tExhalationPause-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].tExhalationPause, sizeof(motorConfig[motor].tExhalationPause));
-					tosvConfig[motor].tExhalationPause = motorConfig[motor].tExhalationPause;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ffPressureGain-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ffPressureGain, sizeof(motorConfig[motor].ffPressureGain));
 				}
 				break;
-			case 108: // LIMIT pressure
+			case 71: // feed forward pressure slope gain [mA per Pa/ms]
 				if (command == TMCL_SAP)
 				{
-					if ((*value >= 0) && (*value <= MAX_PRESSURE))
-						tosvConfig[motor].pLIMIT = *value;
+					if((*value >= 0) && (*value <= 65535))
+						motorConfig[motor].ffSlopeGain = *value;
 					else
 						errors = REPLY_INVALID_VALUE;
-				}
-				else if (command == TMCL_GAP)
-				{
-					*value = tosvConfig[motor].pLIMIT;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].ffSlopeGain;
 				} else if (command == TMCL_STAP) {
-					motorConfig[0].pLIMIT = tosvConfig[motor].pLIMIT;
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pLIMIT-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].pLIMIT, sizeof(motorConfig[motor].pLIMIT));
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ffSlopeGain-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ffSlopeGain, sizeof(motorConfig[motor].ffSlopeGain));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pLIMIT-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].pLIMIT, sizeof(motorConfig[motor].pLIMIT));
-					tosvConfig[motor].pLIMIT = motorConfig[motor].pLIMIT;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ffSlopeGain-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ffSlopeGain, sizeof(motorConfig[motor].ffSlopeGain));
 				}
 				break;
-			case 109: // PEEP pressure
+			case 72: // feed forward flow gain [mA per 1024 ml/min]
 				if (command == TMCL_SAP)
 				{
-					if ((*value >= 0) && (*value <= MAX_PRESSURE))
-						tosvConfig[motor].pPEEP = *value;
+					if((*value >= 0) && (*value <= 65535))
+						motorConfig[motor].ffFlowGain = *value;
 					else
 						errors = REPLY_INVALID_VALUE;
-				}
-				else if (command == TMCL_GAP)
-				{
-					*value = tosvConfig[motor].pPEEP;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].ffFlowGain;
 				} else if (command == TMCL_STAP) {
-					motorConfig[0].pPEEP = tosvConfig[motor].pPEEP;
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pPEEP-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].pPEEP, sizeof(motorConfig[motor].pPEEP));
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ffFlowGain-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ffFlowGain, sizeof(motorConfig[motor].ffFlowGain));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pPEEP-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].pPEEP, sizeof(motorConfig[motor].pPEEP));
-					tosvConfig[motor].pPEEP = motorConfig[motor].pPEEP;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ffFlowGain-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ffFlowGain, sizeof(motorConfig[motor].ffFlowGain));
 				}
 				break;
-
-			case 110: // actual flow
+			case 73: // actual feed forward torque [mA]
 				if (command == TMCL_GAP)
 				{
-					*value = tosv_getFlowValue();
+					*value = bldc_getPressureFeedForward(motor);
 				}
 				break;
-			case 111: // zero flow
+
+			// ===== pressure regulator gain scheduling =====
+
+			case 74: // pressure gain scheduling enable
 				if (command == TMCL_SAP)
 				{
-					tosv_zeroFlow();
+					if((*value >= 0) && (*value <= 1))
+					{
+						motorConfig[motor].pidPressureScheduleEnable = *value;
+						bldc_updateRegulatorSettings(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pidPressureScheduleEnable;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureScheduleEnable-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureScheduleEnable, sizeof(motorConfig[motor].pidPressureScheduleEnable));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureScheduleEnable-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureScheduleEnable, sizeof(motorConfig[motor].pidPressureScheduleEnable));
+					bldc_updateRegulatorSettings(motor);
 				}
 				break;
-			case 112:
+			case 75: // gain blend time on a TOSV state change [ms]
 				if (command == TMCL_SAP)
 				{
-					if(!bldc_setTargetVolume(motor, *value))
+					if((*value >= 0) && (*value <= 65535))
+						motorConfig[motor].pidPressureScheduleBlendTime = *value;
+					else
 						errors = REPLY_INVALID_VALUE;
 				} else if (command == TMCL_GAP) {
-					*value = bldc_getTargetVolume(motor);
+					*value = motorConfig[motor].pidPressureScheduleBlendTime;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureScheduleBlendTime-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureScheduleBlendTime, sizeof(motorConfig[motor].pidPressureScheduleBlendTime));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureScheduleBlendTime-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureScheduleBlendTime, sizeof(motorConfig[motor].pidPressureScheduleBlendTime));
 				}
 				break;
-			case 113: // actual volume
-				if (command == TMCL_GAP)
+			case 76: // gain set index (TOSV state)
+				if (command == TMCL_SAP)
 				{
-					*value = bldc_getActualVolume(motor);
+					if ((*value >= 0) && (*value < PRESSURE_GAIN_SETS))
+						pressureGainIndex = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = pressureGainIndex;
 				}
 				break;
-			case 114: // max volume
+			case 77: // gain set pressure P
 				if (command == TMCL_SAP)
 				{
-					if ((*value >= 0) && (*value <= MAX_VOLUME))
-						tosvConfig[motor].volumeMax = *value;
+					if((*value >= 0) && (*value <= 32767))
+						motorConfig[motor].pidPressureSchedule_P_param[pressureGainIndex] = *value;
 					else
 						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pidPressureSchedule_P_param[pressureGainIndex];
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureSchedule_P_param[pressureGainIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureSchedule_P_param[pressureGainIndex], sizeof(motorConfig[motor].pidPressureSchedule_P_param[pressureGainIndex]));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureSchedule_P_param[pressureGainIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureSchedule_P_param[pressureGainIndex], sizeof(motorConfig[motor].pidPressureSchedule_P_param[pressureGainIndex]));
+				}
+				break;
+			case 78: // gain set pressure I
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 32767))
+						motorConfig[motor].pidPressureSchedule_I_param[pressureGainIndex] = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pidPressureSchedule_I_param[pressureGainIndex];
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureSchedule_I_param[pressureGainIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureSchedule_I_param[pressureGainIndex], sizeof(motorConfig[motor].pidPressureSchedule_I_param[pressureGainIndex]));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureSchedule_I_param[pressureGainIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureSchedule_I_param[pressureGainIndex], sizeof(motorConfig[motor].pidPressureSchedule_I_param[pressureGainIndex]));
+				}
+				break;
+			case 79: // actual pressure P
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getPressurePParam(motor);
+				}
+				break;
+			case 80: // actual pressure I
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getPressureIParam(motor);
+				}
+				break;
+
+			// ===== regulator autotuning =====
+
+			case 81: // autotune state
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getAutotune(motor)->state;
+				}
+				break;
+			case 82: // autotune ultimate period [ms]
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getAutotune(motor)->ultimatePeriod;
+				}
+				break;
+			case 83: // autotune ultimate amplitude (peak to peak)
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getAutotune(motor)->ultimateAmplitude;
+				}
+				break;
+			case 84: // autotune plant gain [1/1000]
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getAutotune(motor)->plantGain;
+				}
+				break;
+			case 85: // autotune plant time constant [ms]
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getAutotune(motor)->timeConstant;
+				}
+				break;
+			case 86: // autotune plant dead time [ms]
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getAutotune(motor)->deadTime;
+				}
+				break;
+			case 87: // autotune P
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getAutotune(motor)->pParam;
+				}
+				break;
+			case 88: // autotune I
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getAutotune(motor)->iParam;
+				}
+				break;
+			case 89: // autotune output step [mA] (pressure) / [Pa] (volume)
+				if (command == TMCL_SAP)
+				{
+					if((*value > 0) && (*value <= 65535))
+						motorConfig[motor].autotuneAmplitude = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].autotuneAmplitude;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].autotuneAmplitude-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].autotuneAmplitude, sizeof(motorConfig[motor].autotuneAmplitude));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].autotuneAmplitude-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].autotuneAmplitude, sizeof(motorConfig[motor].autotuneAmplitude));
+				}
+				break;
+			case 90: // autotune relay hysteresis [Pa] (pressure) / [ml] (volume)
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 65535))
+						motorConfig[motor].autotuneHysteresis = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].autotuneHysteresis;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].autotuneHysteresis-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].autotuneHysteresis, sizeof(motorConfig[motor].autotuneHysteresis));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].autotuneHysteresis-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].autotuneHysteresis, sizeof(motorConfig[motor].autotuneHysteresis));
+				}
+				break;
+			case 91: // autotune settle time per operating point [ms]
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 2) && (*value <= 65535))
+						motorConfig[motor].autotuneSettleTime = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].autotuneSettleTime;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].autotuneSettleTime-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].autotuneSettleTime, sizeof(motorConfig[motor].autotuneSettleTime));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].autotuneSettleTime-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].autotuneSettleTime, sizeof(motorConfig[motor].autotuneSettleTime));
+				}
+				break;
+
+			// ===== brake chopper settings  =====
+			case 95: // enable brake chopper
+				if (command == TMCL_SAP) {
+					motorConfig[motor].brakeChopperEnabled = (*value) ? 1:0;
+					bldc_updateBrakeChopperConfig(motor);
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].brakeChopperEnabled;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperEnabled-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].brakeChopperEnabled, sizeof(motorConfig[motor].brakeChopperEnabled));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperEnabled-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].brakeChopperEnabled, sizeof(motorConfig[motor].brakeChopperEnabled));
+				}
+				break;
+			case 96: // brake chopper voltage limit
+				if (command == TMCL_SAP) {
+					motorConfig[motor].brakeChopperVoltage = *value;
+					bldc_updateBrakeChopperConfig(motor);
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].brakeChopperVoltage;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperVoltage-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].brakeChopperVoltage, sizeof(motorConfig[motor].brakeChopperVoltage));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperVoltage-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].brakeChopperVoltage, sizeof(motorConfig[motor].brakeChopperVoltage));
+				}
+				break;
+			case 97: // brake chopper hysteresis
+				if (command == TMCL_SAP) {
+					motorConfig[motor].brakeChopperHysteresis = *value;
+					bldc_updateBrakeChopperConfig(motor);
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].brakeChopperHysteresis;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperHysteresis-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].brakeChopperHysteresis, sizeof(motorConfig[motor].brakeChopperHysteresis));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].brakeChopperHysteresis-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].brakeChopperHysteresis, sizeof(motorConfig[motor].brakeChopperHysteresis));
+				}
+				break;
+
+			// ===== tosv settings =====
+			case 99: // TOSV mode
+				if (command == TMCL_SAP)
+				{
+					// 0: pressure control, 1: volume control, 2: pressure support, 3: PRVC, 4: flow control
+					if (!tosv_setMode(&tosvConfig[motor], *value))
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].mode;
+				}
+				break;
+			case 100: // enable tosv
+				if (command == TMCL_SAP)
+				{
+					// todo: add value check for enable:  *value==0x1234
+					// todo: add value check for disable: *value==0x4321
+					tosv_enableVentilator(&tosvConfig[motor], *value);
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosv_isVentilatorEnabled(&tosvConfig[motor]);
+				}
+				break;
+			case 101: // actual state
+				if(command==TMCL_GAP)
+				{
+					*value = tosvConfig[motor].actualState;
+				}
+				break;
+			case 102: // timer
+				if(command==TMCL_GAP)
+				{
+					*value = tosvConfig[motor].timer;
+				}
+				break;
+			case 103: // startup time
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 65535))
+					{
+						tosvConfig[motor].tStartup = *value;
+						tosv_updateConversions(&tosvConfig[motor]);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].tStartup;
+				} else if (command == TMCL_STAP) {
+					motorConfig[0].tStartup = tosvConfig[motor].tStartup;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tStartup-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].tStartup, sizeof(motorConfig[motor].tStartup));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tStartup-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].tStartup, sizeof(motorConfig[motor].tStartup));
+					tosvConfig[motor].tStartup = motorConfig[motor].tStartup;
+					tosv_updateConversions(&tosvConfig[motor]);
+				}
+				break;
+			case 104: // inhalation rise time
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 65535))
+					{
+						tosvConfig[motor].tInhalationRise = *value;
+						tosv_updateConversions(&tosvConfig[motor]);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].tInhalationRise;
+				} else if (command == TMCL_STAP) {
+					motorConfig[0].tInhalationRise = tosvConfig[motor].tInhalationRise;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tInhalationRise-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].tInhalationRise, sizeof(motorConfig[motor].tInhalationRise));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tInhalationRise-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].tInhalationRise, sizeof(motorConfig[motor].tInhalationRise));
+					tosvConfig[motor].tInhalationRise = motorConfig[motor].tInhalationRise;
+					tosv_updateConversions(&tosvConfig[motor]);
+				}
+				break;
+			case 105: // inhalation pause time
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 65535))
+						tosvConfig[motor].tInhalationPause = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].tInhalationPause;
+				} else if (command == TMCL_STAP) {
+					motorConfig[0].tInhalationPause = tosvConfig[motor].tInhalationPause;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tInhalationPause-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].tInhalationPause, sizeof(motorConfig[motor].tInhalationPause));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tInhalationPause-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].tInhalationPause, sizeof(motorConfig[motor].tInhalationPause));
+					tosvConfig[motor].tInhalationPause = motorConfig[motor].tInhalationPause;
+				}
+				break;
+			case 106: // exhalation fall time
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 65535))
+					{
+						tosvConfig[motor].tExhalationFall = *value;
+						tosv_updateConversions(&tosvConfig[motor]);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].tExhalationFall;
+				} else if (command == TMCL_STAP) {
+					motorConfig[0].tExhalationFall = tosvConfig[motor].tExhalationFall;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tExhalationFall-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].tExhalationFall, sizeof(motorConfig[motor].tExhalationFall));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tExhalationFall-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].tExhalationFall, sizeof(motorConfig[motor].tExhalationFall));
+					tosvConfig[motor].tExhalationFall = motorConfig[motor].tExhalationFall;
+					tosv_updateConversions(&tosvConfig[motor]);
+				}
+				break;
+			case 107: // exhalation pause time
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 65535))
+						tosvConfig[motor].tExhalationPause = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].tExhalationPause;
+				} else if (command == TMCL_STAP) {
+					motorConfig[0].tExhalationPause = tosvConfig[motor].tExhalationPause;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tExhalationPause-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].tExhalationPause, sizeof(motorConfig[motor].tExhalationPause));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].tExhalationPause-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].tExhalationPause, sizeof(motorConfig[motor].tExhalationPause));
+					tosvConfig[motor].tExhalationPause = motorConfig[motor].tExhalationPause;
+				}
+				break;
+			case 108: // LIMIT pressure
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 0) && (*value <= MAX_PRESSURE))
+						tosvConfig[motor].pLIMIT = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].pLIMIT;
+				} else if (command == TMCL_STAP) {
+					motorConfig[0].pLIMIT = tosvConfig[motor].pLIMIT;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pLIMIT-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pLIMIT, sizeof(motorConfig[motor].pLIMIT));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pLIMIT-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pLIMIT, sizeof(motorConfig[motor].pLIMIT));
+					tosvConfig[motor].pLIMIT = motorConfig[motor].pLIMIT;
+				}
+				break;
+			case 109: // PEEP pressure
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 0) && (*value <= MAX_PRESSURE))
+						tosvConfig[motor].pPEEP = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].pPEEP;
+				} else if (command == TMCL_STAP) {
+					motorConfig[0].pPEEP = tosvConfig[motor].pPEEP;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pPEEP-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pPEEP, sizeof(motorConfig[motor].pPEEP));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pPEEP-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pPEEP, sizeof(motorConfig[motor].pPEEP));
+					tosvConfig[motor].pPEEP = motorConfig[motor].pPEEP;
+				}
+				break;
+
+			case 110: // actual flow
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getFlowValue();
+				}
+				break;
+			case 111: // zero flow
+				if (command == TMCL_SAP)
+				{
+					tosv_zeroFlow();
+				}
+				break;
+			case 112:
+				if (command == TMCL_SAP)
+				{
+					if(!bldc_setTargetVolume(motor, *value))
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = bldc_getTargetVolume(motor);
+				}
+				break;
+			case 113: // actual volume
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getActualVolume(motor);
+				}
+				break;
+			case 114: // max volume
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 0) && (*value <= MAX_VOLUME))
+						tosvConfig[motor].volumeMax = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].volumeMax;
+				} else if (command == TMCL_STAP) {
+					motorConfig[0].volumeMax = tosvConfig[motor].volumeMax;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].volumeMax-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].volumeMax, sizeof(motorConfig[motor].volumeMax));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].volumeMax-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].volumeMax, sizeof(motorConfig[motor].volumeMax));
+					tosvConfig[motor].volumeMax = motorConfig[motor].volumeMax;
+				}
+				break;
+			case 120: // ASB enable
+				if (command == TMCL_SAP)
+				{
+					if (*value == 0)
+						tosvConfig[motor].asbEnable = false;
+					else
+						tosvConfig[motor].asbEnable = true;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].asbEnable;
+				} else if (command == TMCL_STAP) {
+					motorConfig[0].asbEnable = tosvConfig[motor].asbEnable;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbEnable-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbEnable, sizeof(motorConfig[motor].asbEnable));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbEnable-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbEnable, sizeof(motorConfig[motor].asbEnable));
+					tosvConfig[motor].asbEnable = motorConfig[motor].asbEnable;
+				}
+				break;
+			case 121: // ASB threshold
+				if (command == TMCL_SAP)
+				{
+					tosvConfig[motor].asbThreshold = *value;
+					tosv_updateConversions(&tosvConfig[motor]);
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].asbThreshold;
+				} else if (command == TMCL_STAP) {
+					motorConfig[0].asbThreshold = tosvConfig[motor].asbThreshold;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbThreshold-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbThreshold, sizeof(motorConfig[motor].asbThreshold));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbThreshold-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbThreshold, sizeof(motorConfig[motor].asbThreshold));
+					tosvConfig[motor].asbThreshold = motorConfig[motor].asbThreshold;
+					tosv_updateConversions(&tosvConfig[motor]);
+				}
+				break;
+			case 122: // ASB volume condition
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 0) && (*value) <= 100)
+						tosvConfig[motor].asbVolumeCondition = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].asbVolumeCondition;
+				} else if (command == TMCL_STAP) {
+					motorConfig[0].asbVolumeCondition = tosvConfig[motor].asbVolumeCondition;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbVolumeCondition-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbVolumeCondition, sizeof(motorConfig[motor].asbVolumeCondition));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbVolumeCondition-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbVolumeCondition, sizeof(motorConfig[motor].asbVolumeCondition));
+					tosvConfig[motor].asbVolumeCondition = motorConfig[motor].asbVolumeCondition;
+				}
+				break;
+			case 123: // flow offset
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getFlowOffset();
+				}
+				break;
+			case 124: // flow zero tracking update count
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getFlowZeroUpdateCount();
+				}
+				break;
+			case 125: // flow zero tracking enable
+				if (command == TMCL_SAP)
+				{
+					tosvConfig[motor].flowZeroTrackingEnable = (*value) ? true : false;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].flowZeroTrackingEnable;
+				} else if (command == TMCL_STAP) {
+					motorConfig[motor].flowZeroTrackingEnable = tosvConfig[motor].flowZeroTrackingEnable;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowZeroTrackingEnable-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowZeroTrackingEnable, sizeof(motorConfig[motor].flowZeroTrackingEnable));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowZeroTrackingEnable-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowZeroTrackingEnable, sizeof(motorConfig[motor].flowZeroTrackingEnable));
+					tosvConfig[motor].flowZeroTrackingEnable = motorConfig[motor].flowZeroTrackingEnable;
+				}
+				break;
+			case 126: // flow zero tracking variance limit
+				if (command == TMCL_SAP)
+				{
+					if (*value >= 0)
+						tosvConfig[motor].flowZeroVarianceLimit = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].flowZeroVarianceLimit;
+				} else if (command == TMCL_STAP) {
+					motorConfig[motor].flowZeroVarianceLimit = tosvConfig[motor].flowZeroVarianceLimit;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowZeroVarianceLimit-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowZeroVarianceLimit, sizeof(motorConfig[motor].flowZeroVarianceLimit));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowZeroVarianceLimit-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowZeroVarianceLimit, sizeof(motorConfig[motor].flowZeroVarianceLimit));
+					tosvConfig[motor].flowZeroVarianceLimit = motorConfig[motor].flowZeroVarianceLimit;
+				}
+				break;
+			case 127: // ASB flow derivative threshold [ml/min per ms] (0: off)
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 0) && (*value <= 65535))
+					{
+						tosvConfig[motor].asbSlopeThreshold = *value;
+						tosv_updateConversions(&tosvConfig[motor]);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].asbSlopeThreshold;
+				} else if (command == TMCL_STAP) {
+					motorConfig[motor].asbSlopeThreshold = tosvConfig[motor].asbSlopeThreshold;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbSlopeThreshold-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbSlopeThreshold, sizeof(motorConfig[motor].asbSlopeThreshold));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbSlopeThreshold-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbSlopeThreshold, sizeof(motorConfig[motor].asbSlopeThreshold));
+					tosvConfig[motor].asbSlopeThreshold = motorConfig[motor].asbSlopeThreshold;
+					tosv_updateConversions(&tosvConfig[motor]);
+				}
+				break;
+			case 128: // ASB blower load disturbance threshold [mA] (0: off)
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 0) && (*value <= 65535))
+					{
+						tosvConfig[motor].asbTorqueThreshold = *value;
+						tosv_updateConversions(&tosvConfig[motor]);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].asbTorqueThreshold;
+				} else if (command == TMCL_STAP) {
+					motorConfig[motor].asbTorqueThreshold = tosvConfig[motor].asbTorqueThreshold;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbTorqueThreshold-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbTorqueThreshold, sizeof(motorConfig[motor].asbTorqueThreshold));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbTorqueThreshold-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbTorqueThreshold, sizeof(motorConfig[motor].asbTorqueThreshold));
+					tosvConfig[motor].asbTorqueThreshold = motorConfig[motor].asbTorqueThreshold;
+					tosv_updateConversions(&tosvConfig[motor]);
+				}
+				break;
+			case 129: // ASB trigger score (1024: trigger)
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getAsbScore();
+				}
+				break;
+			case 130: // volume sensor reinit
+				if (command == TMCL_SAP)
+				{
+					tosv_reInitFlowSensor();
+				}
+				break;
+
+			case 131: // flow calibration point index
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 0) && (*value < FLOW_CAL_POINTS))
+						flowCalIndex = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = flowCalIndex;
+				}
+				break;
+			case 132: // flow calibration point sensor counts
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= -32768) && (*value <= 32767))
+					{
+						motorConfig[motor].flowCalCounts[flowCalIndex] = *value;
+						tosv_updateFlowCalibration();
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].flowCalCounts[flowCalIndex];
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowCalCounts[flowCalIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowCalCounts[flowCalIndex], sizeof(motorConfig[motor].flowCalCounts[flowCalIndex]));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowCalCounts[flowCalIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowCalCounts[flowCalIndex], sizeof(motorConfig[motor].flowCalCounts[flowCalIndex]));
+					tosv_updateFlowCalibration();
+				}
+				break;
+			case 133: // flow calibration point flow
+				if (command == TMCL_SAP)
+				{
+					motorConfig[motor].flowCalFlow[flowCalIndex] = *value;
+					tosv_updateFlowCalibration();
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].flowCalFlow[flowCalIndex];
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowCalFlow[flowCalIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowCalFlow[flowCalIndex], sizeof(motorConfig[motor].flowCalFlow[flowCalIndex]));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowCalFlow[flowCalIndex]-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowCalFlow[flowCalIndex], sizeof(motorConfig[motor].flowCalFlow[flowCalIndex]));
+					tosv_updateFlowCalibration();
+				}
+				break;
+			case 134: // flow calibration reference temperature
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= -32768) && (*value <= 32767))
+						motorConfig[motor].flowCalTempRef = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].flowCalTempRef;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowCalTempRef-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowCalTempRef, sizeof(motorConfig[motor].flowCalTempRef));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowCalTempRef-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowCalTempRef, sizeof(motorConfig[motor].flowCalTempRef));
+				}
+				break;
+			case 135: // flow calibration temperature coefficient
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= -32768) && (*value <= 32767))
+						motorConfig[motor].flowCalTempCoeff = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].flowCalTempCoeff;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowCalTempCoeff-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowCalTempCoeff, sizeof(motorConfig[motor].flowCalTempCoeff));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowCalTempCoeff-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowCalTempCoeff, sizeof(motorConfig[motor].flowCalTempCoeff));
+				}
+				break;
+			case 136: // flow sensor raw temperature
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getFlowSensorTemperature();
+				}
+				break;
+			case 137: // flow sensor raw pressure
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getFlowSensorPressure();
+				}
+				break;
+			case 138: // flow sensor status word
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getFlowSensorStatus();
+				}
+				break;
+			case 139: // flow sensor rejected samples
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getFlowSensorRejectedSamples();
+				}
+				break;
+			case 140: // breath to breath learning enable
+				if (command == TMCL_SAP)
+				{
+					tosvConfig[motor].ilcEnable = (*value) ? true : false;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].ilcEnable;
+				} else if (command == TMCL_STAP) {
+					motorConfig[motor].ilcEnable = tosvConfig[motor].ilcEnable;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ilcEnable-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ilcEnable, sizeof(motorConfig[motor].ilcEnable));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ilcEnable-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ilcEnable, sizeof(motorConfig[motor].ilcEnable));
+					tosvConfig[motor].ilcEnable = motorConfig[motor].ilcEnable;
+				}
+				break;
+			case 141: // learning gain [mA per mA feedback torque, q16]
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 0) && (*value <= 65535))
+						tosvConfig[motor].ilcGain = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].ilcGain;
+				} else if (command == TMCL_STAP) {
+					motorConfig[motor].ilcGain = tosvConfig[motor].ilcGain;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ilcGain-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ilcGain, sizeof(motorConfig[motor].ilcGain));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ilcGain-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ilcGain, sizeof(motorConfig[motor].ilcGain));
+					tosvConfig[motor].ilcGain = motorConfig[motor].ilcGain;
+				}
+				break;
+			case 142: // max learned torque [mA]
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 0) && (*value <= 65535))
+						tosvConfig[motor].ilcMaxTorque = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].ilcMaxTorque;
+				} else if (command == TMCL_STAP) {
+					motorConfig[motor].ilcMaxTorque = tosvConfig[motor].ilcMaxTorque;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ilcMaxTorque-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ilcMaxTorque, sizeof(motorConfig[motor].ilcMaxTorque));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].ilcMaxTorque-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].ilcMaxTorque, sizeof(motorConfig[motor].ilcMaxTorque));
+					tosvConfig[motor].ilcMaxTorque = motorConfig[motor].ilcMaxTorque;
+				}
+				break;
+			case 143: // actual learned torque [mA]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getLearnedTorque();
+				}
+				break;
+			case 144: // learned breaths (SAP: reset learned torque)
+				if (command == TMCL_SAP)
+				{
+					tosv_resetLearning();
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosv_getLearnedBreaths();
+				}
+				break;
+
+			// ===== state estimation =====
+
+			case 145: // pressure regulator feedback (0: raw, 1: PT1, 2: estimated)
+				if (command == TMCL_SAP)
+				{
+					if((*value >= FEEDBACK_SIGNAL_RAW) && (*value <= FEEDBACK_SIGNAL_ESTIMATED))
+						motorConfig[motor].pressureSignal = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pressureSignal;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pressureSignal-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pressureSignal, sizeof(motorConfig[motor].pressureSignal));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pressureSignal-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pressureSignal, sizeof(motorConfig[motor].pressureSignal));
+				}
+				break;
+			case 146: // feed forward flow and volume regulator feedback (0: raw, 1: PT1, 2: estimated)
+				if (command == TMCL_SAP)
+				{
+					if((*value >= FEEDBACK_SIGNAL_RAW) && (*value <= FEEDBACK_SIGNAL_ESTIMATED))
+						motorConfig[motor].flowSignal = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].flowSignal;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowSignal-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowSignal, sizeof(motorConfig[motor].flowSignal));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowSignal-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowSignal, sizeof(motorConfig[motor].flowSignal));
+				}
+				break;
+			case 147: // pressure estimator tracking index [1/1000]
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 1) && (*value <= 65535))
+					{
+						motorConfig[motor].estPressureNoiseRatio = *value;
+						bldc_updateEstimatorSettings(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].estPressureNoiseRatio;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].estPressureNoiseRatio-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].estPressureNoiseRatio, sizeof(motorConfig[motor].estPressureNoiseRatio));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].estPressureNoiseRatio-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].estPressureNoiseRatio, sizeof(motorConfig[motor].estPressureNoiseRatio));
+					bldc_updateEstimatorSettings(motor);
+				}
+				break;
+			case 148: // flow estimator tracking index [1/1000]
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 1) && (*value <= 65535))
+					{
+						motorConfig[motor].estFlowNoiseRatio = *value;
+						bldc_updateEstimatorSettings(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].estFlowNoiseRatio;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].estFlowNoiseRatio-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].estFlowNoiseRatio, sizeof(motorConfig[motor].estFlowNoiseRatio));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].estFlowNoiseRatio-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].estFlowNoiseRatio, sizeof(motorConfig[motor].estFlowNoiseRatio));
+					bldc_updateEstimatorSettings(motor);
+				}
+				break;
+			case 149: // blower pressure at 10000 rpm [Pa] (0: no speed input)
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 65535))
+					{
+						motorConfig[motor].estBlowerPressure = *value;
+						bldc_updateEstimatorSettings(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].estBlowerPressure;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].estBlowerPressure-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].estBlowerPressure, sizeof(motorConfig[motor].estBlowerPressure));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].estBlowerPressure-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].estBlowerPressure, sizeof(motorConfig[motor].estBlowerPressure));
+					bldc_updateEstimatorSettings(motor);
+				}
+				break;
+			case 150: // estimated pressure [Pa]
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getEstimatedPressure(motor);
+				}
+				break;
+			case 151: // estimated pressure slope [Pa/s]
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getEstimatedPressureSlope(motor);
+				}
+				break;
+			case 152: // estimated flow [ml/min]
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getEstimatedFlow(motor);
+				}
+				break;
+			case 153: // volume of the estimated flow [ml]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getEstimatedVolume();
+				}
+				break;
+
+			// ===== lung mechanics =====
+
+			case 154: // lung resistance [Pa/(l/s)]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getLungResistance();
+				}
+				break;
+			case 155: // lung compliance [ml/kPa]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getLungCompliance();
+				}
+				break;
+			case 156: // total PEEP [Pa]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getTotalPeep();
+				}
+				break;
+			case 157: // intrinsic PEEP [Pa]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getTotalPeep() - (int32_t)tosvConfig[motor].pPEEP;
+				}
+				break;
+			case 158: // lung mechanics updates (SAP: reset estimation)
+				if (command == TMCL_SAP)
+				{
+					tosv_resetLungMechanics();
 				}
 				else if (command == TMCL_GAP)
 				{
-					*value = tosvConfig[motor].volumeMax;
+					*value = tosv_getLungMechanicsUpdates();
+				}
+				break;
+
+			// ===== patient trigger statistics =====
+
+			case 159: // ASB triggers (SAP: reset statistics)
+				if (command == TMCL_SAP)
+				{
+					tosv_resetAsbStatistics();
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosv_getAsbTriggerCount();
+				}
+				break;
+			case 160: // ASB last trigger latency [ms]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getAsbLastLatency();
+				}
+				break;
+			case 161: // ASB mean trigger latency [ms]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getAsbMeanLatency();
+				}
+				break;
+			case 162: // ASB max trigger latency [ms]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getAsbMaxLatency();
+				}
+				break;
+
+			// ===== pressure support =====
+
+			case 163: // pressure support cycling flow [% of the peak flow]
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 1) && (*value <= 99))
+						tosvConfig[motor].psCycleThreshold = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].psCycleThreshold;
 				} else if (command == TMCL_STAP) {
-					motorConfig[0].volumeMax = tosvConfig[motor].volumeMax;
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].volumeMax-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].volumeMax, sizeof(motorConfig[motor].volumeMax));
+					motorConfig[motor].psCycleThreshold = tosvConfig[motor].psCycleThreshold;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].psCycleThreshold-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].psCycleThreshold, sizeof(motorConfig[motor].psCycleThreshold));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].volumeMax-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].volumeMax, sizeof(motorConfig[motor].volumeMax));
-					tosvConfig[motor].volumeMax = motorConfig[motor].volumeMax;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].psCycleThreshold-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].psCycleThreshold, sizeof(motorConfig[motor].psCycleThreshold));
+					tosvConfig[motor].psCycleThreshold = motorConfig[motor].psCycleThreshold;
 				}
 				break;
-			case 120: // ASB enable
+			case 164: // pressure support apnea backup time [ms]
 				if (command == TMCL_SAP)
 				{
-					if (*value == 0)
-						tosvConfig[motor].asbEnable = false;
+					if ((*value >= 1000) && (*value <= 65535))
+						tosvConfig[motor].psApneaTime = *value;
 					else
-						tosvConfig[motor].asbEnable = true;
+						errors = REPLY_INVALID_VALUE;
 				}
 				else if (command == TMCL_GAP)
 				{
-					*value = tosvConfig[motor].asbEnable;
+					*value = tosvConfig[motor].psApneaTime;
 				} else if (command == TMCL_STAP) {
-					motorConfig[0].asbEnable = tosvConfig[motor].asbEnable;
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbEnable-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].asbEnable, sizeof(motorConfig[motor].asbEnable));
+					motorConfig[motor].psApneaTime = tosvConfig[motor].psApneaTime;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].psApneaTime-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].psApneaTime, sizeof(motorConfig[motor].psApneaTime));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbEnable-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].asbEnable, sizeof(motorConfig[motor].asbEnable));
-					tosvConfig[motor].asbEnable = motorConfig[motor].asbEnable;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].psApneaTime-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].psApneaTime, sizeof(motorConfig[motor].psApneaTime));
+					tosvConfig[motor].psApneaTime = motorConfig[motor].psApneaTime;
 				}
 				break;
-			case 121: // ASB threshold
+			case 165: // pressure support peak flow of the last breath [ml/min]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getPsPeakFlow();
+				}
+				break;
+			case 166: // pressure support duration of the last inhalation [ms]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getPsInhalationTime();
+				}
+				break;
+			case 167: // pressure support backup breaths (SAP: reset)
 				if (command == TMCL_SAP)
 				{
-					tosvConfig[motor].asbThreshold = *value;
+					tosv_resetPsApneaCount();
 				}
 				else if (command == TMCL_GAP)
 				{
-					*value = tosvConfig[motor].asbThreshold;
+					*value = tosv_getPsApneaCount();
+				}
+				break;
+
+			// ===== pressure regulated volume control =====
+
+			case 168: // PRVC max. inspiratory pressure change per breath [Pa]
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 10) && (*value <= 5000))
+						tosvConfig[motor].prvcMaxStep = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].prvcMaxStep;
 				} else if (command == TMCL_STAP) {
-					motorConfig[0].asbThreshold = tosvConfig[motor].asbThreshold;
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbThreshold-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].asbThreshold, sizeof(motorConfig[motor].asbThreshold));
+					motorConfig[motor].prvcMaxStep = tosvConfig[motor].prvcMaxStep;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].prvcMaxStep-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].prvcMaxStep, sizeof(motorConfig[motor].prvcMaxStep));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbThreshold-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].asbThreshold, sizeof(motorConfig[motor].asbThreshold));
-					tosvConfig[motor].asbThreshold = motorConfig[motor].asbThreshold;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].prvcMaxStep-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].prvcMaxStep, sizeof(motorConfig[motor].prvcMaxStep));
+					tosvConfig[motor].prvcMaxStep = motorConfig[motor].prvcMaxStep;
 				}
 				break;
-			case 122: // ASB volume condition
+			case 169: // PRVC actual inspiratory pressure [Pa]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getPrvcPressure(&tosvConfig[motor]);
+				}
+				break;
+			case 170: // PRVC tidal volume of the last breath [ml]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getPrvcTidalVolume();
+				}
+				break;
+			case 171: // PRVC volume error of the last breath [ml]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getPrvcVolumeError();
+				}
+				break;
+			case 172: // PRVC consecutive breaths within 5% of the target volume
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getPrvcConvergedBreaths();
+				}
+				break;
+			case 173: // PRVC adapted breaths
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getPrvcBreaths();
+				}
+				break;
+
+			// ===== flow control =====
+
+			case 174: // flow regulator output (0: pressure regulator, 1: torque)
 				if (command == TMCL_SAP)
 				{
-					if ((*value >= 0) && (*value) <= 100)
-						tosvConfig[motor].asbVolumeCondition = *value;
+					// not while the flow regulator is running on the selected output
+					if (((*value == FLOW_OUTPUT_PRESSURE) || (*value == FLOW_OUTPUT_TORQUE)) && !flags_isStatusFlagSet(motor, FLOW_MODE))
+					{
+						motorConfig[motor].pidFlowOutput = *value;
+						bldc_updateRegulatorSettings(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pidFlowOutput;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidFlowOutput-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidFlowOutput, sizeof(motorConfig[motor].pidFlowOutput));
+				} else if (command == TMCL_RSAP) {
+					if (!flags_isStatusFlagSet(motor, FLOW_MODE))
+					{
+						eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidFlowOutput-(u32)&motorConfig[motor],
+								(u8 *)&motorConfig[motor].pidFlowOutput, sizeof(motorConfig[motor].pidFlowOutput));
+						bldc_updateRegulatorSettings(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				break;
+			case 175: // inspiratory flow profile (0: constant, 1: decelerating)
+				if (command == TMCL_SAP)
+				{
+					if ((*value == TOSV_FLOW_PROFILE_CONSTANT) || (*value == TOSV_FLOW_PROFILE_DECELERATING))
+						tosvConfig[motor].flowProfile = *value;
 					else
 						errors = REPLY_INVALID_VALUE;
 				}
 				else if (command == TMCL_GAP)
 				{
-					*value = tosvConfig[motor].asbVolumeCondition;
+					*value = tosvConfig[motor].flowProfile;
 				} else if (command == TMCL_STAP) {
-					motorConfig[0].asbVolumeCondition = tosvConfig[motor].asbVolumeCondition;
-					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbVolumeCondition-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].asbVolumeCondition, sizeof(motorConfig[motor].asbVolumeCondition));
+					motorConfig[motor].flowProfile = tosvConfig[motor].flowProfile;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowProfile-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowProfile, sizeof(motorConfig[motor].flowProfile));
 				} else if (command == TMCL_RSAP) {
-					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbVolumeCondition-(u32)&motorConfig[motor],
-							(u8 *)&motorConfig[motor].asbVolumeCondition, sizeof(motorConfig[motor].asbVolumeCondition));
-					tosvConfig[motor].asbVolumeCondition = motorConfig[motor].asbVolumeCondition;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].flowProfile-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].flowProfile, sizeof(motorConfig[motor].flowProfile));
+					tosvConfig[motor].flowProfile = motorConfig[motor].flowProfile;
 				}
 				break;
-			case 130: // volume sensor reinit
+			case 176: // inspiratory flow target of the flow control mode [ml/min]
+				if (command == TMCL_GAP)
+				{
+					*value = tosv_getInspiratoryFlowTarget();
+				}
+				break;
+			case 177: // flow I-Sum
+				if (command == TMCL_GAP)
+				{
+					*value = bldc_getFlowErrorSum(motor);
+				}
+				break;
+
+			// ===== pressure regulator cascade =====
+
+			case 178: // inner loop of the pressure regulator (0: torque, 1: velocity)
 				if (command == TMCL_SAP)
 				{
-					tosv_reInitFlowSensor();
+					// not while the pressure regulator is running
+					if (!bldc_setPressureCascade(motor, *value))
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pressureCascade;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pressureCascade-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pressureCascade, sizeof(motorConfig[motor].pressureCascade));
+				} else if (command == TMCL_RSAP) {
+					uint8_t cascade;
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pressureCascade-(u32)&motorConfig[motor],
+							(u8 *)&cascade, sizeof(cascade));
+					if (!bldc_setPressureCascade(motor, cascade))
+						errors = REPLY_INVALID_VALUE;
+				}
+				break;
+			case 179: // pressure P (velocity cascade)
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 32767))
+					{
+						motorConfig[motor].pidPressureVelocity_P_param = *value;
+						bldc_updateRegulatorSettings(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pidPressureVelocity_P_param;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureVelocity_P_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureVelocity_P_param, sizeof(motorConfig[motor].pidPressureVelocity_P_param));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureVelocity_P_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureVelocity_P_param, sizeof(motorConfig[motor].pidPressureVelocity_P_param));
+					bldc_updateRegulatorSettings(motor);
+				}
+				break;
+			case 180: // pressure I (velocity cascade)
+				if (command == TMCL_SAP)
+				{
+					if((*value >= 0) && (*value <= 32767))
+					{
+						motorConfig[motor].pidPressureVelocity_I_param = *value;
+						bldc_updateRegulatorSettings(motor);
+					}
+					else
+						errors = REPLY_INVALID_VALUE;
+				} else if (command == TMCL_GAP) {
+					*value = motorConfig[motor].pidPressureVelocity_I_param;
+				} else if (command == TMCL_STAP) {
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureVelocity_I_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureVelocity_I_param, sizeof(motorConfig[motor].pidPressureVelocity_I_param));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressureVelocity_I_param-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].pidPressureVelocity_I_param, sizeof(motorConfig[motor].pidPressureVelocity_I_param));
+					bldc_updateRegulatorSettings(motor);
+				}
+				break;
+
+			case 186: // ASB blower inertia [mA per rpm/ms] (disturbance observer of the blower load)
+				if (command == TMCL_SAP)
+				{
+					if ((*value >= 0) && (*value <= 65535))
+						tosvConfig[motor].asbBlowerInertia = *value;
+					else
+						errors = REPLY_INVALID_VALUE;
+				}
+				else if (command == TMCL_GAP)
+				{
+					*value = tosvConfig[motor].asbBlowerInertia;
+				} else if (command == TMCL_STAP) {
+					motorConfig[motor].asbBlowerInertia = tosvConfig[motor].asbBlowerInertia;
+					eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbBlowerInertia-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbBlowerInertia, sizeof(motorConfig[motor].asbBlowerInertia));
+				} else if (command == TMCL_RSAP) {
+					eeprom_readConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].asbBlowerInertia-(u32)&motorConfig[motor],
+							(u8 *)&motorConfig[motor].asbBlowerInertia, sizeof(motorConfig[motor].asbBlowerInertia));
+					tosvConfig[motor].asbBlowerInertia = motorConfig[motor].asbBlowerInertia;
 				}
 				break;
 
@@ -1515,6 +2815,16 @@ uint32_t tmcl_handleAxisParameter(uint8_t motor, uint8_t command, uint8_t type,
 				if (command == TMCL_GAP)
 					*value = systemInfo_getCommunicationsPerSecond();
 				break;
+			case 253: // cpu cycles of the last regulation tick
+				if (command == TMCL_GAP)
+					*value = systemInfo_getCycles();
+				break;
+			case 254: // max. cpu cycles of a regulation tick (SAP resets)
+				if (command == TMCL_SAP)
+					systemInfo_resetMaxCycles();
+				else if (command == TMCL_GAP)
+					*value = systemInfo_getMaxCycles();
+				break;
 
 			case 255: // enable/disable mc & driver
 				if (command == TMCL_SAP)
@@ -1652,7 +2962,10 @@ void tmcl_boot()
 		while(abs(systick_getTimer()-lastCheck) < 1000) {;}
 #endif
 
-#if BOARD_CPU==STM32F103
+#if defined(HOST_SIMULATION)
+		// no bootloader in the host simulation
+		return;
+#elif BOARD_CPU==STM32F103
 		asm volatile("CPSID I\n");
 		NVIC_DeInit();
 		SysTick->CTRL = 0;
@@ -1682,11 +2995,172 @@ void tmcl_softwareReset()
 		ResetRequested = true;
 }
 
+/* TMCL command autotune (type 0/1: start pressure/volume regulator with rule 0 SIMC/1 IMC, 2: abort,
+ * 3: state, 4: apply identified gains, value 1: and store them in EEPROM) */
+void tmcl_autotune()
+{
+	uint8_t motor = ActualCommand.Motor;
+
+	if (motor >= NUMBER_OF_MOTORS)
+	{
+		ActualReply.Status = REPLY_WRONG_TYPE;
+		return;
+	}
+
+	switch(ActualCommand.Type)
+	{
+		case 0:
+		case 1:
+			if (!bldc_startAutotune(motor, (ActualCommand.Type == 0) ? AUTOTUNE_LOOP_PRESSURE : AUTOTUNE_LOOP_VOLUME, ActualCommand.Value.Int32))
+				ActualReply.Status = REPLY_CMD_NOT_AVAILABLE;
+			break;
+		case 2:
+			bldc_abortAutotune(motor);
+			break;
+		case 3:
+			ActualReply.Value.Int32 = bldc_getAutotune(motor)->state;
+			break;
+		case 4:
+			if (!bldc_applyAutotune(motor))
+			{
+				ActualReply.Status = REPLY_CMD_NOT_AVAILABLE;
+			}
+			else if (ActualCommand.Value.Int32 == 1)
+			{
+				eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressure_P_param-(u32)&motorConfig[motor],
+						(u8 *)&motorConfig[motor].pidPressure_P_param, sizeof(motorConfig[motor].pidPressure_P_param));
+				eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidPressure_I_param-(u32)&motorConfig[motor],
+						(u8 *)&motorConfig[motor].pidPressure_I_param, sizeof(motorConfig[motor].pidPressure_I_param));
+				eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidVolume_P_param-(u32)&motorConfig[motor],
+						(u8 *)&motorConfig[motor].pidVolume_P_param, sizeof(motorConfig[motor].pidVolume_P_param));
+				eeprom_writeConfigBlock(TMCM_ADDR_MOTOR_CONFIG+motor*TMCM_MOTOR_CONFIG_SIZE+(u32)&motorConfig[motor].pidVolume_I_param-(u32)&motorConfig[motor],
+						(u8 *)&motorConfig[motor].pidVolume_I_param, sizeof(motorConfig[motor].pidVolume_I_param));
+			}
+			break;
+		default:
+			ActualReply.Status = REPLY_WRONG_TYPE;
+			break;
+	}
+}
+
+/* capture of the control loop inputs (type 5: read 4 byte of the recording at the byte index in value) */
+void tmcl_recorder()
+{
+	switch(ActualCommand.Type)
+	{
+		case 0:
+			recorder_start(tmcl_visitState);
+			break;
+		case 1:
+			recorder_stop();
+			break;
+		case 2:
+			ActualReply.Value.Int32 = recorder_getState();
+			break;
+		case 3:
+			ActualReply.Value.Int32 = recorder_getLength();
+			break;
+		case 4:
+			ActualReply.Value.Int32 = recorder_getTicks();
+			break;
+		case 5:
+			if (!recorder_read(ActualCommand.Value.Int32, &ActualReply.Value.Int32))
+				ActualReply.Status = REPLY_INVALID_VALUE;
+			break;
+		default:
+			ActualReply.Status = REPLY_WRONG_TYPE;
+			break;
+	}
+}
+
+/* State for the header of a recording: the motor configuration in the EEPROM, the selected table
+ * points and the configuration and control state of the axes. A replay visits the same blocks with
+ * the values of the recording and restores the EEPROM where it differs.
+ */
+void tmcl_visitState(Recorder_StateVisitor visit)
+{
+	uint8_t storedBlock[32];
+	uint8_t block[32];
+
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+	{
+		for (uint32_t offset = 0; offset < TMCM_MOTOR_CONFIG_SIZE; offset += sizeof(block))
+		{
+			uint32_t address = TMCM_ADDR_MOTOR_CONFIG + motor*TMCM_MOTOR_CONFIG_SIZE + offset;
+			uint32_t size = TMCM_MOTOR_CONFIG_SIZE - offset;
+			if (size > sizeof(block))
+				size = sizeof(block);
+
+			eeprom_readConfigBlock(address, storedBlock, size);
+			for (uint32_t i = 0; i < size; i++)
+				block[i] = storedBlock[i];
+
+			visit(block, size);
+
+			for (uint32_t i = 0; i < size; i++)
+			{
+				if (block[i] != storedBlock[i])
+				{
+					eeprom_writeConfigBlock(address, block, size);
+					break;
+				}
+			}
+		}
+	}
+
+	visit(&flowCalIndex, sizeof(flowCalIndex));
+	visit(&pressureCalIndex, sizeof(pressureCalIndex));
+	visit(&pressureGainIndex, sizeof(pressureGainIndex));
+
+	bldc_visitState(visit);
+}
+
+/* cpu cycles of a control loop kernel (type), value 0: min. cycles, 1: mean cycles */
+void tmcl_benchmark()
+{
+	uint32_t minCycles, meanCycles;
+
+	// the benchmark blocks the main loop with the control tick: not while the ventilator or a regulator runs
+	if (tosv_isVentilatorEnabled(&tosvConfig[0]))
+	{
+		ActualReply.Status = REPLY_CMD_NOT_AVAILABLE;
+		return;
+	}
+
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+	{
+		if (flags_isStatusFlagSet(motor, PRESSURE_MODE | VOLUME_MODE | FLOW_MODE | VELOCITY_MODE))
+		{
+			ActualReply.Status = REPLY_CMD_NOT_AVAILABLE;
+			return;
+		}
+	}
+
+	if (ActualCommand.Value.Int32 < 0 || ActualCommand.Value.Int32 > 1)
+	{
+		ActualReply.Status = REPLY_INVALID_VALUE;
+		return;
+	}
+
+	if (!benchmark_run(ActualCommand.Type, &minCycles, &meanCycles))
+	{
+		ActualReply.Status = REPLY_WRONG_TYPE;
+		return;
+	}
+
+	ActualReply.Value.Int32 = (ActualCommand.Value.Int32 == 0) ? minCycles : meanCycles;
+}
+
 /* Reset CPU with or without peripherals */
 void tmcl_resetCPU(uint8_t resetPeripherals)
 {
+#if defined(HOST_SIMULATION)
+	// the host simulation is restarted by simulation_init()
+	(void)resetPeripherals;
+#else
 	if(resetPeripherals)
 		SCB->AIRCR = AIRCR_VECTKEY_MASK | (uint32_t)0x04;
 	else
 		SCB->AIRCR = AIRCR_VECTKEY_MASK | (uint32_t)0x01;
+#endif
 }
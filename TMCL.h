@@ -11,9 +11,13 @@
 	#include "Definitions.h"
 	#include "BLDC.h"
 	#include "hal/modules/SelectModule.h"
+	#include "hal/tmcl/TMCL-Defines.h"
 
 	void tmcl_init();
 	void tmcl_processCommand();
+	void tmcl_executeActualCommand();
+	bool tmcl_parseFrame(const uint8_t *frame, TTMCLCommand *command);
 	void tmcl_resetCPU(uint8_t resetPeripherals);
+	void tmcl_visitState(Recorder_StateVisitor visit);
 
 #endif
@@ -7,25 +7,256 @@
 
 #include "TOSV.h"
 #include "BLDC.h"
+#include "Calibration.h"
+#include "LungMechanics.h"
+#include "Estimator.h"
+#include "hal/comm/I2C.h"
+#include "hal/system/Recorder.h"
 
 // private variables
 
-int32_t gActualFlowValue = 0;
-int32_t gActualFlowValuePT1 = 0;
-int64_t gActualFlowValueAccu = 0;
-int32_t gAcutalVolume = 0;
-int32_t gFlowOffset = 0;
-int64_t gFlowSum = 0;
-int32_t gVolumeMax = 0;
+INSTANCE_STATE int32_t gActualFlowValue = 0;
+INSTANCE_STATE int32_t gActualFlowValuePT1 = 0;
+INSTANCE_STATE int64_t gActualFlowValueAccu = 0;
+INSTANCE_STATE int32_t gAcutalVolume = 0;
+INSTANCE_STATE int32_t gFlowOffset = 0;
+INSTANCE_STATE int64_t gFlowSum = 0;
+INSTANCE_STATE int32_t gVolumeMax = 0;
+INSTANCE_STATE int64_t gEstimatedFlowSum = 0;
+INSTANCE_STATE int32_t gEstimatedVolume = 0;
 
-bool gIsFlowSensorPresent = false; // don't crash the system if pressure sensor for flow measurement is not present
+INSTANCE_STATE bool gIsFlowSensorPresent = false; // don't crash the system if pressure sensor for flow measurement is not present
+
+// SM9333 flow sensor
+#define SM9333_REG_DSP_T				0x2E	// temperature, followed by DSP_S (0x30) and STATUS_SYNC (0x32)
+
+#define SM9333_STATUS_DSP_S_UPDATED		0x0008
+#define SM9333_STATUS_BS_FAIL			0x0080
+#define SM9333_STATUS_BC_FAIL			0x0100
+#define SM9333_STATUS_DSP_SAT			0x0400
+#define SM9333_STATUS_COM_CRC_ERROR		0x0800
+#define SM9333_STATUS_ERROR_MASK		(SM9333_STATUS_BS_FAIL | SM9333_STATUS_BC_FAIL | SM9333_STATUS_DSP_SAT | SM9333_STATUS_COM_CRC_ERROR)
+
+INSTANCE_STATE int16_t gFlowSensorTemperature = 0;
+INSTANCE_STATE int16_t gFlowSensorPressure = 0;
+INSTANCE_STATE uint16_t gFlowSensorStatus = 0;
+INSTANCE_STATE uint32_t gFlowSensorRejectedSamples = 0;
+INSTANCE_STATE int32_t gFlowCalSlope[FLOW_CAL_POINTS-1];	// q16 [ml/min per count]
+
+// automatic flow zero tracking
+#define FLOW_ZERO_WINDOW_SHIFT		6		// 64 samples per observation window
+#define FLOW_ZERO_WINDOW_SIZE		(1 << FLOW_ZERO_WINDOW_SHIFT)
+#define FLOW_ZERO_SETTLE_TIME		200		// [ms] skipped at the beginning of the exhalation pause
+#define FLOW_ZERO_MAX_STEP			4		// [ml/min] max offset change per breath
+#define FLOW_ZERO_MAX_DRIFT			200		// [ml/min] max tracked change from the zero at the ventilator start
+
+INSTANCE_STATE int64_t gFlowZeroSum = 0;
+INSTANCE_STATE int64_t gFlowZeroSquareSum = 0;
+INSTANCE_STATE uint32_t gFlowZeroSampleCount = 0;
+INSTANCE_STATE uint32_t gFlowZeroUpdateCount = 0;
+INSTANCE_STATE int32_t gFlowZeroReference = 0;			// offset at the ventilator start [ml/min]
+INSTANCE_STATE int32_t gFlowZeroWindowMean = 0;			// last quiet window of the exhalation pause
+INSTANCE_STATE bool gIsFlowZeroWindowValid = false;
+
+// iterative learning control of the pressure feed forward torque
+#define ILC_BIN_SHIFT				5		// 32 ms per table entry
+#define ILC_BINS					128		// covers 4096 ms of the breath
+#define ILC_LEAD_BINS				1		// apply the learned torque one entry ahead (blower lag)
+#define ILC_FORGET_SHIFT			6		// learned torque decays by 1/64 per breath
+
+INSTANCE_STATE int32_t gIlcTorque[ILC_BINS];	// learned torque per breath phase [mA]
+INSTANCE_STATE int32_t gIlcActualTorque = 0;
+INSTANCE_STATE int32_t gIlcFeedbackSum = 0;
+INSTANCE_STATE int32_t gIlcLastFeedback[2];	// mean feedback torque of the two previous table entries
+INSTANCE_STATE uint16_t gIlcBreathTime = 0;
+INSTANCE_STATE uint8_t gIlcLastState = TOSV_STATE_STOPPED;
+INSTANCE_STATE uint32_t gIlcBreaths = 0;
+
+// breath settings the learned torque belongs to
+typedef struct
+{
+	uint16_t tInhalationRise;
+	uint16_t tInhalationPause;
+	uint16_t tExhalationFall;
+	uint16_t tExhalationPause;
+	uint32_t pLIMIT;
+	uint32_t pPEEP;
+} ILC_BreathSettings;
+
+INSTANCE_STATE ILC_BreathSettings gIlcBreathSettings = { 0, 0, 0, 0, 0, 0 };
+
+// patient trigger detection
+#define ASB_SCORE_TRIGGER			1024	// trigger score of a single criterion at its threshold
+#define ASB_SCORE_ONSET				128		// no patient effort below this score
+#define ASB_LOCKOUT_TIME			100		// [ms] no trigger at the beginning of the exhalation pause
+#define ASB_SCORE_HOLD				512		// the blower load baseline is held from this score on
+#define ASB_BASELINE_NOISE_RATIO	5		// tracking index of the blower load baseline [1/1000]
+#define ASB_VELOCITY_NOISE_RATIO	50		// tracking index of the blower velocity [1/1000]
+#define ASB_SETTLED_ACCELERATION	2		// [rpm/ms] blower acceleration of a settled exhalation pause
+
+INSTANCE_STATE int32_t gAsbScore = 0;
+INSTANCE_STATE AlphaBetaFilter gAsbTorqueBaseline;
+INSTANCE_STATE AlphaBetaFilter gAsbVelocity;
+INSTANCE_STATE uint16_t gAsbOnsetTime = 0;
+INSTANCE_STATE uint32_t gAsbTriggerCount = 0;
+INSTANCE_STATE uint32_t gAsbLatencySum = 0;
+INSTANCE_STATE uint16_t gAsbLastLatency = 0;
+INSTANCE_STATE uint16_t gAsbMaxLatency = 0;
+INSTANCE_STATE Reciprocal gAsbTimeConstantReciprocal = { 0, 0 };	// passive exhalation time constant R*C [ms]
+
+// pressure support
+INSTANCE_STATE int32_t gPsPeakFlow = 0;			// running peak flow of the actual inhalation [ml/min]
+INSTANCE_STATE int32_t gPsLastPeakFlow = 0;
+INSTANCE_STATE uint16_t gPsInhalationTime = 0;		// [ms] actual / last supported inhalation
+INSTANCE_STATE uint16_t gPsLastInhalationTime = 0;
+INSTANCE_STATE uint32_t gPsBreathTime = 0;			// [ms] since the start of the last breath
+INSTANCE_STATE uint32_t gPsApneaCount = 0;
+
+// pressure regulated volume control
+#define PRVC_TEST_PRESSURE			1000	// [Pa] above PEEP for the first breath
+#define PRVC_TOLERANCE				5		// [%] of the target volume
+
+INSTANCE_STATE uint32_t gPrvcPressure = 0;			// adapted inspiratory pressure [Pa]
+INSTANCE_STATE int32_t gPrvcTidalVolume = 0;		// [ml] of the last breath
+INSTANCE_STATE int32_t gPrvcVolumeError = 0;		// [ml] target - tidal volume
+INSTANCE_STATE uint32_t gPrvcConvergedBreaths = 0;	// consecutive breaths within the tolerance
+INSTANCE_STATE uint32_t gPrvcBreaths = 0;			// breaths since the start
+
+// flow control
+INSTANCE_STATE int32_t gFlowProfilePeak = 0;		// [ml/min] inspiratory flow at the start of the inhalation
+INSTANCE_STATE int64_t gFlowProfileSlope = 0;		// q16 [ml/min per ms] decrease of the decelerating flow
+INSTANCE_STATE int32_t gFlowTarget = 0;			// [ml/min] actual inspiratory flow target
+INSTANCE_STATE int32_t gFlowPlateauPressure = 0;	// [Pa] start of the exhalation ramp
+
+// estimation of the lung mechanics
+INSTANCE_STATE LungMechanics gLungMechanics;
+INSTANCE_STATE uint8_t gLungLastState = TOSV_STATE_STOPPED;
 
 // private function declarations
 
-void tosv_process_pressure_control(TOSV_Config *config);
-void tosv_process_volume_control(TOSV_Config *config);
+int32_t tosv_calculateFlow(int16_t pressure, int16_t temperature);
+
+uint32_t tosv_getInspiratoryPressure(TOSV_Config *config);
+void tosv_resetPrvc(TOSV_Config *config);
+uint32_t tosv_limitPrvcPressure(TOSV_Config *config);
+
+void tosv_stopped(TOSV_Config *config);
+void tosv_pressureStartup(TOSV_Config *config);
+void tosv_pressureRise(TOSV_Config *config);
+void tosv_pressurePlateau(TOSV_Config *config);
+void tosv_pressureFall(TOSV_Config *config);
+void tosv_peep(TOSV_Config *config);
+void tosv_startBreath(TOSV_Config *config);
+
+void tosv_volumeStartup(TOSV_Config *config);
+void tosv_volumeRise(TOSV_Config *config);
+void tosv_volumePlateau(TOSV_Config *config);
+void tosv_volumeFall(TOSV_Config *config);
+void tosv_volumeZero(TOSV_Config *config);
+
+void tosv_startPrvcBreath(TOSV_Config *config);
+void tosv_updatePrvc(TOSV_Config *config);
+
+void tosv_flowRise(TOSV_Config *config);
+void tosv_flowPlateau(TOSV_Config *config);
+void tosv_flowFall(TOSV_Config *config);
+void tosv_endFlowInhalation(TOSV_Config *config);
+void tosv_startFlowExhalation(TOSV_Config *config);
+void tosv_startFlowBreath(TOSV_Config *config);
+void tosv_startFlowProfile(TOSV_Config *config);
+
+void tosv_psRise(TOSV_Config *config);
+void tosv_psPlateau(TOSV_Config *config);
+void tosv_psFall(TOSV_Config *config);
+void tosv_psPeep(TOSV_Config *config);
+bool tosv_isPsCycled(TOSV_Config *config);
+bool tosv_isPsBreathDue(TOSV_Config *config);
+void tosv_startPsWaiting(TOSV_Config *config);
+void tosv_endPsInhalation(TOSV_Config *config);
+void tosv_startPsBreath(TOSV_Config *config);
 
 bool tosv_hasAsbTrigger(TOSV_Config *config);
+void tosv_updateFlowZeroTracking(TOSV_Config *config);
+void tosv_updateLearning(TOSV_Config *config);
+void tosv_updateLungMechanics(TOSV_Config *config);
+
+// breath phase tables (const, in flash)
+
+/* pressure control: pressure ramps between PEEP and pLIMIT */
+const TOSV_Phase gPressureControlPhases[TOSV_PHASES] =
+{
+	//                                 setpoint               duration                                condition            action                next
+	[TOSV_STATE_STOPPED]           = { tosv_stopped,          TOSV_PHASE_UNTIMED,                     NULL,                NULL,                 TOSV_STATE_STOPPED },
+	[TOSV_STATE_STARTUP]           = { tosv_pressureStartup,  TOSV_PHASE_TIME(tStartup),              NULL,                NULL,                 TOSV_STATE_INHALATION_RISE },
+	[TOSV_STATE_INHALATION_RISE]   = { tosv_pressureRise,     TOSV_PHASE_TIME(tInhalationRise),       NULL,                NULL,                 TOSV_STATE_INHALATION_PAUSE },
+	[TOSV_STATE_INHALATION_PAUSE]  = { tosv_pressurePlateau,  TOSV_PHASE_TIME(tInhalationPause),      NULL,                NULL,                 TOSV_STATE_EXHALATION_FALL },
+	[TOSV_STATE_EXHALATION_FALL]   = { tosv_pressureFall,     TOSV_PHASE_TIME(tExhalationFall),       NULL,                NULL,                 TOSV_STATE_EXHALATION_PAUSE },
+	[TOSV_STATE_EXHALATION_PAUSE]  = { tosv_peep,             TOSV_PHASE_TIME(tExhalationPause),      tosv_hasAsbTrigger,  tosv_startBreath,     TOSV_STATE_INHALATION_RISE },
+};
+
+/* PRVC: as pressure control, the inspiratory pressure is adapted at the start of each breath */
+const TOSV_Phase gPrvcPhases[TOSV_PHASES] =
+{
+	[TOSV_STATE_STOPPED]           = { tosv_stopped,          TOSV_PHASE_UNTIMED,                     NULL,                NULL,                 TOSV_STATE_STOPPED },
+	[TOSV_STATE_STARTUP]           = { tosv_pressureStartup,  TOSV_PHASE_TIME(tStartup),              NULL,                NULL,                 TOSV_STATE_INHALATION_RISE },
+	[TOSV_STATE_INHALATION_RISE]   = { tosv_pressureRise,     TOSV_PHASE_TIME(tInhalationRise),       NULL,                NULL,                 TOSV_STATE_INHALATION_PAUSE },
+	[TOSV_STATE_INHALATION_PAUSE]  = { tosv_pressurePlateau,  TOSV_PHASE_TIME(tInhalationPause),      NULL,                NULL,                 TOSV_STATE_EXHALATION_FALL },
+	[TOSV_STATE_EXHALATION_FALL]   = { tosv_pressureFall,     TOSV_PHASE_TIME(tExhalationFall),       NULL,                NULL,                 TOSV_STATE_EXHALATION_PAUSE },
+	[TOSV_STATE_EXHALATION_PAUSE]  = { tosv_peep,             TOSV_PHASE_TIME(tExhalationPause),      tosv_hasAsbTrigger,  tosv_startPrvcBreath, TOSV_STATE_INHALATION_RISE },
+};
+
+/* volume control: volume ramps between 0 and volumeMax */
+const TOSV_Phase gVolumeControlPhases[TOSV_PHASES] =
+{
+	[TOSV_STATE_STOPPED]           = { tosv_stopped,          TOSV_PHASE_UNTIMED,                     NULL,                NULL,                 TOSV_STATE_STOPPED },
+	[TOSV_STATE_STARTUP]           = { tosv_volumeStartup,    TOSV_PHASE_TIME(tStartup),              NULL,                NULL,                 TOSV_STATE_INHALATION_RISE },
+	[TOSV_STATE_INHALATION_RISE]   = { tosv_volumeRise,       TOSV_PHASE_TIME(tInhalationRise),       NULL,                NULL,                 TOSV_STATE_INHALATION_PAUSE },
+	[TOSV_STATE_INHALATION_PAUSE]  = { tosv_volumePlateau,    TOSV_PHASE_TIME(tInhalationPause),      NULL,                NULL,                 TOSV_STATE_EXHALATION_FALL },
+	[TOSV_STATE_EXHALATION_FALL]   = { tosv_volumeFall,       TOSV_PHASE_TIME(tExhalationFall),       NULL,                NULL,                 TOSV_STATE_EXHALATION_PAUSE },
+	[TOSV_STATE_EXHALATION_PAUSE]  = { tosv_volumeZero,       TOSV_PHASE_TIME(tExhalationPause),      tosv_hasAsbTrigger,  tosv_startBreath,     TOSV_STATE_INHALATION_RISE },
+};
+
+/*
+ * flow control: the tidal volume volumeMax is delivered within tInhalationRise by the flow regulator, with
+ * constant or decelerating (from twice the mean flow to zero) flow. The inhalation pause holds zero flow
+ * (plateau), the exhalation is a pressure ramp from the plateau pressure to PEEP.
+ */
+const TOSV_Phase gFlowControlPhases[TOSV_PHASES] =
+{
+	[TOSV_STATE_STOPPED]           = { tosv_stopped,          TOSV_PHASE_UNTIMED,                     NULL,                NULL,                     TOSV_STATE_STOPPED },
+	[TOSV_STATE_STARTUP]           = { tosv_pressureStartup,  TOSV_PHASE_TIME(tStartup),              NULL,                tosv_startFlowProfile,    TOSV_STATE_INHALATION_RISE },
+	[TOSV_STATE_INHALATION_RISE]   = { tosv_flowRise,         TOSV_PHASE_TIME(tInhalationRise),       NULL,                tosv_endFlowInhalation,   TOSV_STATE_INHALATION_PAUSE },
+	[TOSV_STATE_INHALATION_PAUSE]  = { tosv_flowPlateau,      TOSV_PHASE_TIME(tInhalationPause),      NULL,                tosv_startFlowExhalation, TOSV_STATE_EXHALATION_FALL },
+	[TOSV_STATE_EXHALATION_FALL]   = { tosv_flowFall,         TOSV_PHASE_TIME(tExhalationFall),       NULL,                NULL,                     TOSV_STATE_EXHALATION_PAUSE },
+	[TOSV_STATE_EXHALATION_PAUSE]  = { tosv_peep,             TOSV_PHASE_TIME(tExhalationPause),      tosv_hasAsbTrigger,  tosv_startFlowBreath,     TOSV_STATE_INHALATION_RISE },
+};
+
+/*
+ * pressure support: every breath is started by the patient trigger, the pressure rises to pLIMIT within
+ * tInhalationRise. The inhalation ends when the flow has decayed to psCycleThreshold percent of the peak
+ * flow of the breath (the peak is tracked every tick, so the cycling reacts within one tick) or at the
+ * latest after tInhalationPause. Without a trigger for psApneaTime since the last breath start a backup
+ * breath starts.
+ */
+const TOSV_Phase gPressureSupportPhases[TOSV_PHASES] =
+{
+	[TOSV_STATE_STOPPED]           = { tosv_stopped,          TOSV_PHASE_UNTIMED,                     NULL,                NULL,                     TOSV_STATE_STOPPED },
+	[TOSV_STATE_STARTUP]           = { tosv_pressureStartup,  TOSV_PHASE_TIME(tStartup),              NULL,                tosv_startPsWaiting,      TOSV_STATE_EXHALATION_PAUSE },
+	[TOSV_STATE_INHALATION_RISE]   = { tosv_psRise,           TOSV_PHASE_TIME(tInhalationRise),       NULL,                NULL,                     TOSV_STATE_INHALATION_PAUSE },
+	[TOSV_STATE_INHALATION_PAUSE]  = { tosv_psPlateau,        TOSV_PHASE_TIME(tInhalationPause),      tosv_isPsCycled,     tosv_endPsInhalation,     TOSV_STATE_EXHALATION_FALL },
+	[TOSV_STATE_EXHALATION_FALL]   = { tosv_psFall,           TOSV_PHASE_TIME(tExhalationFall),       NULL,                NULL,                     TOSV_STATE_EXHALATION_PAUSE },
+	[TOSV_STATE_EXHALATION_PAUSE]  = { tosv_psPeep,           TOSV_PHASE_UNTIMED,                     tosv_isPsBreathDue,  tosv_startPsBreath,       TOSV_STATE_INHALATION_RISE },
+};
+
+/* phase table per TOSV_Mode */
+const TOSV_Phase * const gModePhases[] =
+{
+	[TOSV_MODE_PRESSURE_CONTROL]	= gPressureControlPhases,
+	[TOSV_MODE_VOLUME_CONTROL]		= gVolumeControlPhases,
+	[TOSV_MODE_PRESSURE_SUPPORT]	= gPressureSupportPhases,
+	[TOSV_MODE_PRVC]				= gPrvcPhases,
+	[TOSV_MODE_FLOW_CONTROL]		= gFlowControlPhases,
+};
 
 // public function implementations
 
@@ -44,6 +275,35 @@ void tosv_init(TOSV_Config *config)
 	config->asbEnable 			= false;
 	config->asbThreshold        = 500;
 	config->asbVolumeCondition  = 70;
+	config->asbSlopeThreshold   = 0;
+	config->asbTorqueThreshold  = 0;
+	config->asbBlowerInertia    = 17;
+	config->psCycleThreshold    = 25;
+	config->psApneaTime         = 20000;
+	config->prvcMaxStep         = 300;
+	config->flowProfile         = TOSV_FLOW_PROFILE_CONSTANT;
+	config->flowZeroTrackingEnable = false;
+	config->flowZeroVarianceLimit = 2500;
+	config->ilcEnable			= false;
+	config->ilcGain				= 32000;
+	config->ilcMaxTorque		= 1000;
+	tosv_updateConversions(config);
+
+	estimator_setNoiseRatio(&gAsbTorqueBaseline, ASB_BASELINE_NOISE_RATIO);
+	estimator_setNoiseRatio(&gAsbVelocity, ASB_VELOCITY_NOISE_RATIO);
+}
+
+/* update the cached reciprocals of the ramp times and trigger thresholds (call on every change) */
+void tosv_updateConversions(TOSV_Config *config)
+{
+	conversion_setDivisor(&config->tStartupReciprocal, config->tStartup);
+	conversion_setDivisor(&config->tInhalationRiseReciprocal, config->tInhalationRise);
+	conversion_setDivisor(&config->tExhalationFallReciprocal, config->tExhalationFall);
+
+	// a threshold of 0 disables its part of the trigger score
+	conversion_setDivisor(&config->asbThresholdReciprocal, (config->asbThreshold > 0) ? config->asbThreshold : 0);
+	conversion_setDivisor(&config->asbSlopeThresholdReciprocal, config->asbSlopeThreshold);
+	conversion_setDivisor(&config->asbTorqueThresholdReciprocal, config->asbTorqueThreshold);
 }
 
 void tosv_initFlowSensor()
@@ -65,6 +325,9 @@ void tosv_enableVentilator(TOSV_Config *config, bool enable)
 		{
 			config->actualState = TOSV_STATE_STARTUP;
 			tosv_zeroFlow();
+			tosv_resetLearning();
+			tosv_resetLungMechanics();
+			tosv_resetPrvc(config);
 		}
 	} else {
 		config->actualState = TOSV_STATE_STOPPED;
@@ -77,19 +340,110 @@ bool tosv_isVentilatorEnabled(TOSV_Config *config)
 	return (config->actualState != TOSV_STATE_STOPPED);
 }
 
-void tosv_process(TOSV_Config *config)
+/* Change the ventilation mode, returns false for an unknown mode.
+ * The PRVC adaptation restarts from the test pressure, also when changed while running.
+ */
+bool tosv_setMode(TOSV_Config *config, uint32_t mode)
 {
-	switch (config->mode)
+	if (mode > TOSV_MODE_FLOW_CONTROL)
+		return false;
+
+	if (mode != config->mode)
 	{
-		case TOSV_MODE_PRESSURE_CONTROL:
-			tosv_process_pressure_control(config);
-			break;
-		case TOSV_MODE_VOLUME_CONTROL:
-			tosv_process_volume_control(config);
-			break;
-		default:
-			break;
+		config->mode = mode;
+		tosv_resetPrvc(config);
 	}
+
+	return true;
+}
+
+/* state of the ventilator for the header of a recording */
+void tosv_visitState(Recorder_StateVisitor visit)
+{
+	// flow and volume
+	visit(&gActualFlowValue, sizeof(gActualFlowValue));
+	visit(&gActualFlowValuePT1, sizeof(gActualFlowValuePT1));
+	visit(&gActualFlowValueAccu, sizeof(gActualFlowValueAccu));
+	visit(&gAcutalVolume, sizeof(gAcutalVolume));
+	visit(&gFlowOffset, sizeof(gFlowOffset));
+	visit(&gFlowSum, sizeof(gFlowSum));
+	visit(&gVolumeMax, sizeof(gVolumeMax));
+	visit(&gEstimatedFlowSum, sizeof(gEstimatedFlowSum));
+	visit(&gEstimatedVolume, sizeof(gEstimatedVolume));
+	visit(&gIsFlowSensorPresent, sizeof(gIsFlowSensorPresent));
+
+	// SM9333 flow sensor
+	visit(&gFlowSensorTemperature, sizeof(gFlowSensorTemperature));
+	visit(&gFlowSensorPressure, sizeof(gFlowSensorPressure));
+	visit(&gFlowSensorStatus, sizeof(gFlowSensorStatus));
+	visit(&gFlowSensorRejectedSamples, sizeof(gFlowSensorRejectedSamples));
+	visit(gFlowCalSlope, sizeof(gFlowCalSlope));
+
+	// automatic flow zero tracking
+	visit(&gFlowZeroSum, sizeof(gFlowZeroSum));
+	visit(&gFlowZeroSquareSum, sizeof(gFlowZeroSquareSum));
+	visit(&gFlowZeroSampleCount, sizeof(gFlowZeroSampleCount));
+	visit(&gFlowZeroUpdateCount, sizeof(gFlowZeroUpdateCount));
+	visit(&gFlowZeroReference, sizeof(gFlowZeroReference));
+	visit(&gFlowZeroWindowMean, sizeof(gFlowZeroWindowMean));
+	visit(&gIsFlowZeroWindowValid, sizeof(gIsFlowZeroWindowValid));
+
+	// iterative learning control of the pressure feed forward torque
+	visit(gIlcTorque, sizeof(gIlcTorque));
+	visit(&gIlcActualTorque, sizeof(gIlcActualTorque));
+	visit(&gIlcFeedbackSum, sizeof(gIlcFeedbackSum));
+	visit(gIlcLastFeedback, sizeof(gIlcLastFeedback));
+	visit(&gIlcBreathTime, sizeof(gIlcBreathTime));
+	visit(&gIlcLastState, sizeof(gIlcLastState));
+	visit(&gIlcBreaths, sizeof(gIlcBreaths));
+	visit(&gIlcBreathSettings, sizeof(gIlcBreathSettings));
+
+	// patient trigger detection
+	visit(&gAsbScore, sizeof(gAsbScore));
+	visit(&gAsbTorqueBaseline, sizeof(gAsbTorqueBaseline));
+	visit(&gAsbVelocity, sizeof(gAsbVelocity));
+	visit(&gAsbOnsetTime, sizeof(gAsbOnsetTime));
+	visit(&gAsbTriggerCount, sizeof(gAsbTriggerCount));
+	visit(&gAsbLatencySum, sizeof(gAsbLatencySum));
+	visit(&gAsbLastLatency, sizeof(gAsbLastLatency));
+	visit(&gAsbMaxLatency, sizeof(gAsbMaxLatency));
+	visit(&gAsbTimeConstantReciprocal, sizeof(gAsbTimeConstantReciprocal));
+
+	// pressure support
+	visit(&gPsPeakFlow, sizeof(gPsPeakFlow));
+	visit(&gPsLastPeakFlow, sizeof(gPsLastPeakFlow));
+	visit(&gPsInhalationTime, sizeof(gPsInhalationTime));
+	visit(&gPsLastInhalationTime, sizeof(gPsLastInhalationTime));
+	visit(&gPsBreathTime, sizeof(gPsBreathTime));
+	visit(&gPsApneaCount, sizeof(gPsApneaCount));
+
+	// pressure regulated volume control
+	visit(&gPrvcPressure, sizeof(gPrvcPressure));
+	visit(&gPrvcTidalVolume, sizeof(gPrvcTidalVolume));
+	visit(&gPrvcVolumeError, sizeof(gPrvcVolumeError));
+	visit(&gPrvcConvergedBreaths, sizeof(gPrvcConvergedBreaths));
+	visit(&gPrvcBreaths, sizeof(gPrvcBreaths));
+
+	// flow control
+	visit(&gFlowProfilePeak, sizeof(gFlowProfilePeak));
+	visit(&gFlowProfileSlope, sizeof(gFlowProfileSlope));
+	visit(&gFlowTarget, sizeof(gFlowTarget));
+	visit(&gFlowPlateauPressure, sizeof(gFlowPlateauPressure));
+
+	// estimation of the lung mechanics
+	visit(&gLungMechanics, sizeof(gLungMechanics));
+	visit(&gLungLastState, sizeof(gLungLastState));
+
+}
+
+void tosv_process(TOSV_Config *config)
+{
+	if ((uint32_t)config->mode < sizeof(gModePhases)/sizeof(gModePhases[0]))
+		tosv_processPhase(config, gModePhases[config->mode]);
+
+	tosv_updateFlowZeroTracking(config);
+	tosv_updateLearning(config);
+	tosv_updateLungMechanics(config);
 }
 
 int32_t tosv_getFlowValue()
@@ -97,16 +451,42 @@ int32_t tosv_getFlowValue()
 	return gActualFlowValuePT1;
 }
 
+/* unfiltered flow value [ml/min] */
+int32_t tosv_getActualFlowValue()
+{
+	return gActualFlowValue-gFlowOffset;
+}
+
 
 void tosv_zeroFlow()
 {
 	gFlowOffset = gActualFlowValue;
+	gFlowZeroReference = gFlowOffset;
+	gIsFlowZeroWindowValid = false;
+}
+
+int32_t tosv_getFlowOffset()
+{
+	return gFlowOffset;
+}
+
+uint32_t tosv_getFlowZeroUpdateCount()
+{
+	return gFlowZeroUpdateCount;
 }
 
 void tosv_resetVolumeIntegration()
 {
 	gFlowSum = 0;
 	gVolumeMax = 0;
+	gEstimatedFlowSum = 0;
+	gEstimatedVolume = 0;
+}
+
+/* volume integrated from the estimated flow [ml] */
+int32_t tosv_getEstimatedVolume()
+{
+	return gEstimatedVolume;
 }
 
 
@@ -115,41 +495,93 @@ void tosv_reInitFlowSensor()
 	tosv_initFlowSensor();
 }
 
-/* Read out SM9333 I2C pressure sensor value and calculate flow value from it.
- *
- * In the first step the address (0x30) to be read from is send to the sensor via write.
- * Then the pressure sensor value (0x30) and sync'ed status word (0x32) is retrieved via read.
- * For now the status word is not processed in any way.
+/* Read out SM9333 I2C pressure sensor values and calculate flow value from it.
  *
- * The SM9333 comprises also a temperature sensor for temperature compensation if necessary.
+ * In the first step the start address (0x2E) is send to the sensor via write. Then temperature (0x2E),
+ * pressure (0x30) and the sync'ed status word (0x32) are retrieved in one burst read.
  *
  * https://www.si-micro.com/fileadmin/00_smi_relaunch/products/digital/datasheet/SM933X_datasheet.pdf
  *
- * We constantly filled a 120 liter garbage bag for rough calibration. It took 2 minutes until
- * filled with air and we read a sensor count of 32000 during filling, thus we
- * approximate 1 count to 2 ml/min.
+ * Samples with a failed transfer, a sensor error or a pressure value that has not been updated
+ * are rejected. In that case the last valid flow value is kept for volume integration.
  *
- * Please beware that this is not very accurate!
+ * The pressure count is temperature compensated and converted to flow by the piecewise linear
+ * calibration table from the motor configuration (see tosv_updateFlowCalibration()).
+ *
+ * Returns true if a new valid flow value has been read.
  */
-void tosv_updateFlowSensor()
+bool tosv_updateFlowSensor()
 {
+	bool isSampleValid = false;
+
 	if (gIsFlowSensorPresent)
 	{
-		uint8_t writeData[] = {0x30};
-		uint16_t readData[1];
-		uint8_t isI2cWriteSuccessful;
+		uint8_t writeData[] = {SM9333_REG_DSP_T};
+		uint16_t readData[3];
 
-		isI2cWriteSuccessful = I2C_Master_BufferWrite(I2C1, writeData, sizeof(writeData), 0xD8);
-
-		if (isI2cWriteSuccessful)
+		if (I2C_Master_BufferWrite(I2C1, writeData, sizeof(writeData), 0xD8))
 		{
-			I2C_Master_BufferRead(I2C1, (uint8_t*)readData, sizeof(readData), 0xD8);
+			if (I2C_Master_BufferRead(I2C1, (uint8_t*)readData, sizeof(readData), 0xD8))
+			{
+				gFlowSensorTemperature = readData[0];
+				gFlowSensorPressure    = readData[1];
+				gFlowSensorStatus      = readData[2];
+
+				recorder_setTickFlag(RECORDER_TICK_FLOW_SAMPLE);
+				recorder_addInput(RECORDER_INPUT_FLOW_TEMPERATURE, gFlowSensorTemperature);
+				recorder_addInput(RECORDER_INPUT_FLOW_PRESSURE, gFlowSensorPressure);
+				recorder_addInput(RECORDER_INPUT_FLOW_STATUS, gFlowSensorStatus);
 
-			int16_t pressureSensorCount = readData[0];
-			gActualFlowValue = (int32_t)pressureSensorCount * 2;
+				isSampleValid = ((gFlowSensorStatus & SM9333_STATUS_DSP_S_UPDATED) && !(gFlowSensorStatus & SM9333_STATUS_ERROR_MASK));
+			}
+		}
+
+		if (isSampleValid)
+		{
+			gActualFlowValue = tosv_calculateFlow(gFlowSensorPressure, gFlowSensorTemperature);
 			gActualFlowValuePT1 = tmc_filterPT1(&gActualFlowValueAccu, (gActualFlowValue-gFlowOffset), gActualFlowValuePT1, 5, 8);
 		}
+		else
+		{
+			gFlowSensorRejectedSamples++;
+		}
 	}
+
+	return isSampleValid;
+}
+
+/* Precalculate the segment slopes of the flow calibration table.
+ *
+ * The table maps sensor counts to flow [ml/min]. The counts of the calibration points have to be
+ * ascending. Slopes are stored in q16 format to avoid divisions in the regulation loop.
+ *
+ * The firmware default table reproduces the former rough calibration of 1 count = 2 ml/min
+ * (120 liter garbage bag filled in 2 minutes at a sensor count of about 32000).
+ */
+void tosv_updateFlowCalibration()
+{
+	// one flow sensor for all motors
+	calibration_updateSlopes(motorConfig[0].flowCalCounts, motorConfig[0].flowCalFlow, gFlowCalSlope, FLOW_CAL_POINTS);
+}
+
+int16_t tosv_getFlowSensorTemperature()
+{
+	return gFlowSensorTemperature;
+}
+
+int16_t tosv_getFlowSensorPressure()
+{
+	return gFlowSensorPressure;
+}
+
+uint16_t tosv_getFlowSensorStatus()
+{
+	return gFlowSensorStatus;
+}
+
+uint32_t tosv_getFlowSensorRejectedSamples()
+{
+	return gFlowSensorRejectedSamples;
 }
 
 /* Volume is given in ml.
@@ -158,17 +590,15 @@ void tosv_updateFlowSensor()
  */
 int32_t tosv_updateVolume(uint8_t motor)
 {
-	UNUSED(motor);
-
 	if (gIsFlowSensorPresent)
 	{
-		gFlowSum += (gActualFlowValue-gFlowOffset);
-
-		gAcutalVolume = gFlowSum / 60000;
+		gAcutalVolume = tosv_integrateVolume(&gFlowSum, gActualFlowValue-gFlowOffset);
 
 		if (gAcutalVolume > gVolumeMax)
 			gVolumeMax = gAcutalVolume;
 
+		gEstimatedVolume = tosv_integrateVolume(&gEstimatedFlowSum, bldc_getEstimatedFlow(motor));
+
 		return gAcutalVolume;
 	}
 	else
@@ -177,138 +607,701 @@ int32_t tosv_updateVolume(uint8_t motor)
 	}
 }
 
+/* add the flow [ml/min] of one tick, returns the volume [ml] */
+int32_t tosv_integrateVolume(int64_t *flowSum, int32_t flow)
+{
+	*flowSum += flow;
+	return *flowSum / 60000;
+}
+
 // private function implementations
 
 /*
- * state machine for pressure based control
+ * breath phase engine
+ *
+ * Every mode is a const table of phase descriptors, indexed by the state. Per tick the setpoint of the
+ * actual phase is updated, the phase ends after its time or by its condition (the time is checked first,
+ * so the condition is not evaluated anymore after the timeout). The action of the phase is executed on
+ * leaving it, before the next phase starts with timer 0.
+ *
+ * The phase time is read from the configuration at the offset stored in the table, so a timed phase
+ * without condition costs a single indirect call (the setpoint) per tick.
  */
-void tosv_process_pressure_control(TOSV_Config *config)
+void tosv_processPhase(TOSV_Config *config, const TOSV_Phase *phases)
 {
+	const TOSV_Phase *phase = &phases[config->actualState];
+
 	config->timer++;
+	phase->setpoint(config);
+
+	bool isTimeElapsed = (phase->duration != TOSV_PHASE_UNTIMED)
+			&& (config->timer >= *(const uint16_t *)((const uint8_t *)config + phase->duration));
 
-	switch(config->actualState)
+	if (isTimeElapsed || ((phase->condition != NULL) && phase->condition(config)))
 	{
-		case TOSV_STATE_STOPPED:
-			// reset timer
-			config->timer = 0;
-			tosv_resetVolumeIntegration();
-			break;
-		case TOSV_STATE_STARTUP:
-			bldc_setTargetPressure(0, 0 + (config->pPEEP*config->timer)/config->tStartup);
-			tosv_resetVolumeIntegration();
-			if (config->timer >= config->tStartup)
-			{
-				config->actualState = TOSV_STATE_INHALATION_RISE;
-				config->timer = 0;
-			}
-			break;
-		case TOSV_STATE_INHALATION_RISE:
-			bldc_setTargetPressure(0, config->pPEEP + ((config->pLIMIT-config->pPEEP)*config->timer)/config->tInhalationRise);
-			if (config->timer >= config->tInhalationRise)
-			{
-				config->actualState = TOSV_STATE_INHALATION_PAUSE;
-				config->timer = 0;
-			}
-			break;
-		case TOSV_STATE_INHALATION_PAUSE:
-			bldc_setTargetPressure(0, config->pLIMIT);
-			if (config->timer >= config->tInhalationPause)
-			{
-				config->actualState = TOSV_STATE_EXHALATION_FALL;
-				config->timer = 0;
-			}
-			break;
-		case TOSV_STATE_EXHALATION_FALL:
-			bldc_setTargetPressure(0, config->pPEEP + ((config->pLIMIT-config->pPEEP)*(config->tExhalationFall-config->timer))/config->tExhalationFall);
-			if (config->timer >= config->tExhalationFall)
-			{
-				config->actualState = TOSV_STATE_EXHALATION_PAUSE;
-				config->timer = 0;
-			}
-			break;
-		case TOSV_STATE_EXHALATION_PAUSE:
-			bldc_setTargetPressure(0, config->pPEEP);
-			if ((config->timer >= config->tExhalationPause) || (tosv_hasAsbTrigger(config)))
-			{
-				config->actualState = TOSV_STATE_INHALATION_RISE;
-				config->timer = 0;
-				tosv_resetVolumeIntegration();
-			}
-			break;
+		if (phase->action != NULL)
+			phase->action(config);
+
+		config->actualState = phase->next;
+		config->timer = 0;
 	}
 }
 
+/* In PRVC mode the inspiratory pressure is adapted breath to breath (limited by pLIMIT). */
+uint32_t tosv_getInspiratoryPressure(TOSV_Config *config)
+{
+	return (config->mode == TOSV_MODE_PRVC) ? tosv_limitPrvcPressure(config) : config->pLIMIT;
+}
 
-/*
- * state machine for volume based control
+void tosv_stopped(TOSV_Config *config)
+{
+	// reset timer
+	config->timer = 0;
+	tosv_resetVolumeIntegration();
+}
+
+// ===== pressure phases =====
+
+void tosv_pressureStartup(TOSV_Config *config)
+{
+	bldc_setTargetPressureRamp(0, conversion_divide(config->pPEEP*config->timer, &config->tStartupReciprocal));
+	tosv_resetVolumeIntegration();
+}
+
+void tosv_pressureRise(TOSV_Config *config)
+{
+	bldc_setTargetPressureRamp(0, config->pPEEP + conversion_divide((tosv_getInspiratoryPressure(config)-config->pPEEP)*config->timer, &config->tInhalationRiseReciprocal));
+}
+
+void tosv_pressurePlateau(TOSV_Config *config)
+{
+	bldc_setTargetPressure(0, tosv_getInspiratoryPressure(config));
+}
+
+void tosv_pressureFall(TOSV_Config *config)
+{
+	bldc_setTargetPressureRamp(0, config->pPEEP + conversion_divide((tosv_getInspiratoryPressure(config)-config->pPEEP)*(config->tExhalationFall-config->timer), &config->tExhalationFallReciprocal));
+}
+
+void tosv_peep(TOSV_Config *config)
+{
+	bldc_setTargetPressure(0, config->pPEEP);
+}
+
+void tosv_startBreath(TOSV_Config *config)
+{
+	tosv_resetVolumeIntegration();
+}
+
+// ===== volume phases =====
+
+void tosv_volumeStartup(TOSV_Config *config)
+{
+	bldc_setTargetVolume(0, 0);
+	tosv_resetVolumeIntegration();
+}
+
+void tosv_volumeRise(TOSV_Config *config)
+{
+	bldc_setTargetVolume(0, conversion_divide(config->volumeMax*config->timer, &config->tInhalationRiseReciprocal));
+}
+
+void tosv_volumePlateau(TOSV_Config *config)
+{
+	bldc_setTargetVolume(0, config->volumeMax);
+}
+
+void tosv_volumeFall(TOSV_Config *config)
+{
+	bldc_setTargetVolume(0, conversion_divide(config->volumeMax*(config->tExhalationFall-config->timer), &config->tExhalationFallReciprocal));
+}
+
+void tosv_volumeZero(TOSV_Config *config)
+{
+	bldc_setTargetVolume(0, 0);
+}
+
+// ===== pressure regulated volume control =====
+
+/* first pressure regulated breath with the test pressure */
+void tosv_resetPrvc(TOSV_Config *config)
+{
+	gPrvcPressure = config->pPEEP + PRVC_TEST_PRESSURE;
+	gPrvcPressure = tosv_limitPrvcPressure(config);
+	gPrvcTidalVolume = 0;
+	gPrvcVolumeError = 0;
+	gPrvcConvergedBreaths = 0;
+	gPrvcBreaths = 0;
+}
+
+/* adapted pressure within pPEEP and pLIMIT, which can be changed any time */
+uint32_t tosv_limitPrvcPressure(TOSV_Config *config)
+{
+	return tmc_limitInt(gPrvcPressure, config->pPEEP, config->pLIMIT);
+}
+
+void tosv_startPrvcBreath(TOSV_Config *config)
+{
+	tosv_updatePrvc(config);
+	tosv_resetVolumeIntegration();
+}
+
+/* Adapt the inspiratory pressure of the next breath to the tidal volume of the finished breath.
+ *
+ * The delivered volume is proportional to the driving pressure (compliance of the last breath), so the
+ * pressure is scaled by the volume ratio. The change per breath is limited to prvcMaxStep, the pressure
+ * stays between pPEEP and pLIMIT. Calculated once per breath, the ticks in between only follow the ramps.
  */
-void tosv_process_volume_control(TOSV_Config *config)
+void tosv_updatePrvc(TOSV_Config *config)
 {
-	config->timer++;
+	int32_t drivingPressure = tosv_limitPrvcPressure(config) - config->pPEEP;
+	int32_t step;
+
+	gPrvcTidalVolume = gVolumeMax;
+	gPrvcVolumeError = (int32_t)config->volumeMax - gPrvcTidalVolume;
+	gPrvcBreaths++;
+
+	if (gPrvcTidalVolume > 0)
+		step = ((int64_t)gPrvcVolumeError * drivingPressure) / gPrvcTidalVolume;
+	else
+		step = config->prvcMaxStep;	// no volume (e.g. no flow sensor): increase carefully
+
+	step = tmc_limitInt(step, -config->prvcMaxStep, config->prvcMaxStep);
+	gPrvcPressure = tmc_limitInt((int32_t)config->pPEEP + drivingPressure + step, config->pPEEP, config->pLIMIT);
+
+	if ((int64_t)abs(gPrvcVolumeError)*100 <= (int64_t)config->volumeMax*PRVC_TOLERANCE)
+		gPrvcConvergedBreaths++;
+	else
+		gPrvcConvergedBreaths = 0;
+}
+
+/* adapted inspiratory pressure [Pa] */
+int32_t tosv_getPrvcPressure(TOSV_Config *config)
+{
+	return tosv_limitPrvcPressure(config);
+}
+
+/* tidal volume of the last breath [ml] */
+int32_t tosv_getPrvcTidalVolume()
+{
+	return gPrvcTidalVolume;
+}
+
+/* target volume - tidal volume of the last breath [ml] */
+int32_t tosv_getPrvcVolumeError()
+{
+	return gPrvcVolumeError;
+}
+
+/* consecutive breaths within the volume tolerance */
+uint32_t tosv_getPrvcConvergedBreaths()
+{
+	return gPrvcConvergedBreaths;
+}
+
+/* adapted breaths since the start */
+uint32_t tosv_getPrvcBreaths()
+{
+	return gPrvcBreaths;
+}
 
-	switch(config->actualState)
+
+// ===== flow control phases =====
+
+void tosv_flowRise(TOSV_Config *config)
+{
+	if (config->flowProfile == TOSV_FLOW_PROFILE_DECELERATING)
+		gFlowTarget = gFlowProfilePeak - ((gFlowProfileSlope * config->timer) >> 16);
+	bldc_setTargetFlow(0, gFlowTarget);
+}
+
+void tosv_flowPlateau(TOSV_Config *config)
+{
+	bldc_setTargetFlow(0, 0);
+}
+
+void tosv_flowFall(TOSV_Config *config)
+{
+	bldc_setTargetPressureRamp(0, config->pPEEP + conversion_divide((gFlowPlateauPressure-(int32_t)config->pPEEP)*(config->tExhalationFall-config->timer), &config->tExhalationFallReciprocal));
+}
+
+void tosv_endFlowInhalation(TOSV_Config *config)
+{
+	gFlowTarget = 0;
+}
+
+void tosv_startFlowExhalation(TOSV_Config *config)
+{
+	gFlowPlateauPressure = bldc_getActualPressure(0);
+}
+
+void tosv_startFlowBreath(TOSV_Config *config)
+{
+	tosv_resetVolumeIntegration();
+	tosv_startFlowProfile(config);
+}
+
+/* calculate the flow profile of the next inhalation (once per breath) */
+void tosv_startFlowProfile(TOSV_Config *config)
+{
+	// mean flow [ml/min] = volume [ml] * 60000 / time [ms]
+	int32_t meanFlow = ((int64_t)config->volumeMax * 60000) / ((config->tInhalationRise > 0) ? config->tInhalationRise : 1);
+
+	if (config->flowProfile == TOSV_FLOW_PROFILE_DECELERATING)
 	{
-		case TOSV_STATE_STOPPED:
-			// reset timer
-			config->timer = 0;
-			tosv_resetVolumeIntegration();
-			break;
-		case TOSV_STATE_STARTUP:
-			bldc_setTargetVolume(0, 0);
-			tosv_resetVolumeIntegration();
-			if (config->timer >= config->tStartup)
-			{
-				config->actualState = TOSV_STATE_INHALATION_RISE;
-				config->timer = 0;
-			}
-			break;
-		case TOSV_STATE_INHALATION_RISE:
-			bldc_setTargetVolume(0, (config->volumeMax*config->timer)/config->tInhalationRise);
-			if (config->timer >= config->tInhalationRise)
-			{
-				config->actualState = TOSV_STATE_INHALATION_PAUSE;
-				config->timer = 0;
-			}
-			break;
-		case TOSV_STATE_INHALATION_PAUSE:
-			bldc_setTargetVolume(0, config->volumeMax);
-			if (config->timer >= config->tInhalationPause)
-			{
-				config->actualState = TOSV_STATE_EXHALATION_FALL;
-				config->timer = 0;
-			}
-			break;
-		case TOSV_STATE_EXHALATION_FALL:
-			bldc_setTargetVolume(0, (config->volumeMax)*(config->tExhalationFall-config->timer)/config->tExhalationFall);
-			if (config->timer >= config->tExhalationFall)
-			{
-				config->actualState = TOSV_STATE_EXHALATION_PAUSE;
-				config->timer = 0;
-			}
-			break;
-		case TOSV_STATE_EXHALATION_PAUSE:
-			bldc_setTargetVolume(0, 0);
-			if ((config->timer >= config->tExhalationPause) || (tosv_hasAsbTrigger(config)))
-			{
-				config->actualState = TOSV_STATE_INHALATION_RISE;
-				config->timer = 0;
-				tosv_resetVolumeIntegration();
-			}
-			break;
+		gFlowProfilePeak = 2 * meanFlow;
+		gFlowProfileSlope = ((int64_t)gFlowProfilePeak << 16) / ((config->tInhalationRise > 0) ? config->tInhalationRise : 1);
 	}
+	else
+	{
+		gFlowProfilePeak = meanFlow;
+		gFlowProfileSlope = 0;
+	}
+
+	gFlowTarget = gFlowProfilePeak;
+}
+
+/* inspiratory flow target of the flow control mode [ml/min] */
+int32_t tosv_getInspiratoryFlowTarget()
+{
+	return gFlowTarget;
 }
 
 
+// ===== pressure support phases =====
+
+void tosv_psRise(TOSV_Config *config)
+{
+	int32_t flow = bldc_getEstimatedFlow(0);
+
+	gPsBreathTime++;
+	gPsInhalationTime++;
+	if (flow > gPsPeakFlow)
+		gPsPeakFlow = flow;
+	tosv_pressureRise(config);
+}
+
+void tosv_psPlateau(TOSV_Config *config)
+{
+	int32_t flow = bldc_getEstimatedFlow(0);
+
+	gPsBreathTime++;
+	gPsInhalationTime++;
+	if (flow > gPsPeakFlow)
+		gPsPeakFlow = flow;
+	tosv_pressurePlateau(config);
+}
+
+void tosv_psFall(TOSV_Config *config)
+{
+	gPsBreathTime++;
+	tosv_pressureFall(config);
+}
+
+void tosv_psPeep(TOSV_Config *config)
+{
+	gPsBreathTime++;
+	tosv_peep(config);
+}
+
+/* flow cycling: flow <= psCycleThreshold % of the peak flow (after the flow has peaked) */
+bool tosv_isPsCycled(TOSV_Config *config)
+{
+	int32_t flow = bldc_getEstimatedFlow(0);
+
+	return (flow < gPsPeakFlow) && ((int64_t)flow*100 <= (int64_t)gPsPeakFlow*config->psCycleThreshold);
+}
+
+/* patient trigger or backup breath after psApneaTime */
+bool tosv_isPsBreathDue(TOSV_Config *config)
+{
+	return tosv_hasAsbTrigger(config) || (gPsBreathTime >= config->psApneaTime);
+}
+
+/* wait for the first patient trigger */
+void tosv_startPsWaiting(TOSV_Config *config)
+{
+	gPsBreathTime = 0;
+}
+
+void tosv_endPsInhalation(TOSV_Config *config)
+{
+	gPsLastPeakFlow = gPsPeakFlow;
+	gPsLastInhalationTime = gPsInhalationTime;
+}
+
+void tosv_startPsBreath(TOSV_Config *config)
+{
+	if (gPsBreathTime >= config->psApneaTime)
+		gPsApneaCount++;
+
+	gPsBreathTime = 0;
+	gPsPeakFlow = 0;
+	gPsInhalationTime = 0;
+	tosv_resetVolumeIntegration();
+}
+
+/* peak flow of the last supported inhalation [ml/min] */
+int32_t tosv_getPsPeakFlow()
+{
+	return gPsLastPeakFlow;
+}
+
+/* duration of the last supported inhalation [ms] */
+uint16_t tosv_getPsInhalationTime()
+{
+	return gPsLastInhalationTime;
+}
+
+/* number of backup breaths */
+uint32_t tosv_getPsApneaCount()
+{
+	return gPsApneaCount;
+}
+
+void tosv_resetPsApneaCount()
+{
+	gPsApneaCount = 0;
+}
+
+int32_t tosv_calculateFlow(int16_t pressure, int16_t temperature)
+{
+	TMotorConfig *config = &motorConfig[0];
+
+	// temperature compensation of the zero point (coefficient in counts per 256 temperature counts)
+	int32_t counts = pressure - (((int32_t)config->flowCalTempCoeff * ((int32_t)temperature - config->flowCalTempRef)) >> 8);
+
+	return calibration_interpolate(counts, config->flowCalCounts, config->flowCalFlow, gFlowCalSlope, FLOW_CAL_POINTS);
+}
+
+/* Detect the inspiratory effort of the patient in the exhalation pause.
+ *
+ * Three criteria add up to a trigger score, each contributes 1024 at its threshold:
+ * - estimated flow (asbThreshold)
+ * - estimated flow derivative (asbSlopeThreshold)
+ * - blower load disturbance: the load torque above its baseline trend at PEEP (asbTorqueThreshold),
+ *   the effort changes the blower load before the flow through the sensor has settled
+ * Weak evidence of several criteria triggers earlier than a single one. A threshold of 0 disables
+ * its criterion. The flow derivative is compensated for the passive exhalation (lung mechanics).
+ *
+ * The load torque is observed as the motor torque minus the torque accelerating the blower
+ * (asbBlowerInertia), so the regulator speeding the blower up to PEEP is no patient effort.
+ * The flow derivative and the load only count while the blower runs at a steady speed: before,
+ * the airway pressure is still changing and the passive exhalation model does not hold.
+ *
+ * The trigger latency is measured from the last tick without effort (score below the onset score).
+ */
 bool tosv_hasAsbTrigger(TOSV_Config *config)
 {
-	if (config->asbEnable)
+	// in pressure support every breath is patient triggered
+	if (!config->asbEnable && (config->mode != TOSV_MODE_PRESSURE_SUPPORT))
+		return false;
+
+	// disturbance observer: blower load = motor torque - blower inertia * acceleration
+	if (config->timer <= 1)
+		estimator_reset(&gAsbVelocity, bldc_getActualVelocity(0));
+	estimator_update(&gAsbVelocity, bldc_getActualVelocity(0), true, 0);
+	int32_t acceleration = estimator_getSlope(&gAsbVelocity);		// q16 [rpm/ms]
+	int32_t torque = bldc_getActualMotorCurrent(0) - (((int64_t)config->asbBlowerInertia * acceleration) >> 16);
+	bool isBlowerSettled = (abs(acceleration) <= (ASB_SETTLED_ACCELERATION << 16));
+
+	// lockout: the exhalation flow and the blower load settle
+	if (config->timer <= ASB_LOCKOUT_TIME)
+	{
+		estimator_reset(&gAsbTorqueBaseline, torque);
+		gAsbOnsetTime = config->timer;
+		gAsbScore = 0;
+		return false;
+	}
+
+	int32_t flow = bldc_getEstimatedFlow(0);
+	int32_t slope = bldc_getEstimatedFlowSlope(0) >> 6;		// q10 [ml/min per ms]
+	int32_t disturbance = torque - estimator_getValue(&gAsbTorqueBaseline);
+
+	// the passive exhalation flow decays towards zero with the time constant R*C,
+	// only the slope above this decay is patient effort (without lung model only at non negative flow)
+	if (flow < 0)
+		slope = (gLungMechanics.updates > 0) ? (slope + conversion_divide(flow << 10, &gAsbTimeConstantReciprocal)) : 0;
+
+	gAsbScore = 0;
+	if (flow > 0)
+		gAsbScore += conversion_divide(flow << 10, &config->asbThresholdReciprocal);
+	if ((slope > 0) && isBlowerSettled)
+		gAsbScore += conversion_divide(slope, &config->asbSlopeThresholdReciprocal);
+	if ((disturbance > 0) && isBlowerSettled)
+		gAsbScore += conversion_divide(disturbance << 10, &config->asbTorqueThresholdReciprocal);
+
+	// no clear effort: the baseline follows the load trend of the passive exhalation,
+	// with effort it is extrapolated
+	estimator_update(&gAsbTorqueBaseline, torque, !isBlowerSettled || (gAsbScore < ASB_SCORE_HOLD), 0);
+	if (gAsbScore < ASB_SCORE_ONSET)
+		gAsbOnsetTime = config->timer;
+
+	// volume condition: actual volume <= asbVolumeCondition percent of the max. volume of the breath
+	bool isVolumeConditionMet = ((int64_t)gAcutalVolume*100 <= (int64_t)config->asbVolumeCondition*gVolumeMax);
+
+	if ((gAsbScore >= ASB_SCORE_TRIGGER) && isVolumeConditionMet)
+	{
+		gAsbLastLatency = config->timer - gAsbOnsetTime;
+		gAsbLatencySum += gAsbLastLatency;
+		if (gAsbLastLatency > gAsbMaxLatency)
+			gAsbMaxLatency = gAsbLastLatency;
+		gAsbTriggerCount++;
+		return true;
+	}
+
+	return false;
+}
+
+int32_t tosv_getAsbScore()
+{
+	return gAsbScore;
+}
+
+void tosv_resetAsbStatistics()
+{
+	gAsbTriggerCount = 0;
+	gAsbLatencySum = 0;
+	gAsbLastLatency = 0;
+	gAsbMaxLatency = 0;
+}
+
+uint32_t tosv_getAsbTriggerCount()
+{
+	return gAsbTriggerCount;
+}
+
+/* [ms] from effort onset to trigger */
+uint16_t tosv_getAsbLastLatency()
+{
+	return gAsbLastLatency;
+}
+
+uint16_t tosv_getAsbMeanLatency()
+{
+	return (gAsbTriggerCount > 0) ? (gAsbLatencySum / gAsbTriggerCount) : 0;
+}
+
+uint16_t tosv_getAsbMaxLatency()
+{
+	return gAsbMaxLatency;
+}
+
+/* Track the flow sensor offset to compensate thermal drift of the SM9333.
+ *
+ * While the ventilator holds PEEP in the exhalation pause there is no flow through the sensor.
+ * After a settle time the raw flow is collected in windows of 64 samples. A window whose variance
+ * is below the configured limit (no patient activity, no leakage transients) is quiet. At the end
+ * of the pause the last quiet window is end-expiratory, the offset is moved towards its mean by at
+ * most FLOW_ZERO_MAX_STEP per breath.
+ *
+ * A steady leak between sensor and patient looks like an offset as well. Thermal drift is slow
+ * and small, so the tracked offset stays within FLOW_ZERO_MAX_DRIFT of the zero taken at the
+ * ventilator start: a leak is only absorbed up to this limit and never within a few breaths.
+ *
+ * Only already sampled flow values are used (no additional I2C transfer) and the per tick work
+ * is constant: two accumulations and a compare. The variance is calculated once per window.
+ */
+void tosv_updateFlowZeroTracking(TOSV_Config *config)
+{
+	if (!config->flowZeroTrackingEnable || !gIsFlowSensorPresent)
 	{
-		uint32_t acutalVolumePercent = gAcutalVolume*100/gVolumeMax;
+		gFlowZeroSum = 0;
+		gFlowZeroSquareSum = 0;
+		gFlowZeroSampleCount = 0;
+		gIsFlowZeroWindowValid = false;
+		return;
+	}
 
-		return ((gActualFlowValue > config->asbThreshold) && (acutalVolumePercent <= config->asbVolumeCondition));
+	if ((config->actualState != TOSV_STATE_EXHALATION_PAUSE) || (config->timer < FLOW_ZERO_SETTLE_TIME))
+	{
+		// end of the exhalation pause
+		if (gIsFlowZeroWindowValid)
+		{
+			int32_t offset = gFlowOffset + tmc_limitInt(gFlowZeroWindowMean-gFlowOffset, -FLOW_ZERO_MAX_STEP, FLOW_ZERO_MAX_STEP);
+			gFlowOffset = tmc_limitInt(offset, gFlowZeroReference-FLOW_ZERO_MAX_DRIFT, gFlowZeroReference+FLOW_ZERO_MAX_DRIFT);
+			gFlowZeroUpdateCount++;
+			gIsFlowZeroWindowValid = false;
+		}
+
+		// only use uninterrupted windows
+		gFlowZeroSum = 0;
+		gFlowZeroSquareSum = 0;
+		gFlowZeroSampleCount = 0;
+		return;
 	}
-	else
+
+	gFlowZeroSum += gActualFlowValue;
+	gFlowZeroSquareSum += (int64_t)gActualFlowValue * gActualFlowValue;
+	gFlowZeroSampleCount++;
+
+	if (gFlowZeroSampleCount >= FLOW_ZERO_WINDOW_SIZE)
 	{
-		return false;
+		int32_t mean = gFlowZeroSum >> FLOW_ZERO_WINDOW_SHIFT;
+		int64_t variance = (gFlowZeroSquareSum >> FLOW_ZERO_WINDOW_SHIFT) - (int64_t)mean * mean;
+
+		// a window with patient activity invalidates the earlier ones
+		gFlowZeroWindowMean = mean;
+		gIsFlowZeroWindowValid = (variance <= (int64_t)config->flowZeroVarianceLimit);
+
+		gFlowZeroSum = 0;
+		gFlowZeroSquareSum = 0;
+		gFlowZeroSampleCount = 0;
 	}
 }
+
+/* Breath to breath iterative learning control of the pressure feed forward torque.
+ *
+ * Breaths in pressure control repeat, so do the tracking errors of the regulators. The breath
+ * (from the start of the inhalation rise) is divided into entries of 32 ms. The learning signal
+ * is the pressure tracking error filtered by the pressure PID, i.e. the feedback torque (feedback
+ * error learning). The mean feedback torque of each entry is smoothed with its neighbours
+ * ([1 2 1]/4) and added to the learned torque of that entry, which is applied one entry ahead on
+ * the next breath. The learned torque takes over from the PID until the feedback torque and so
+ * the tracking error vanish. Learning the plain pressure error instead lets learned torque and
+ * PID integral drift against each other.
+ *
+ * An entry is updated when the following entry is complete, so the per tick work is constant.
+ * The learned torque decays slowly, is limited to ilcMaxTorque and the table is cleared when the
+ * ventilator starts or the breath settings change.
+ */
+void tosv_updateLearning(TOSV_Config *config)
+{
+	if (!config->ilcEnable || (config->mode != TOSV_MODE_PRESSURE_CONTROL)
+	 || (config->actualState == TOSV_STATE_STOPPED) || (config->actualState == TOSV_STATE_STARTUP))
+	{
+		gIlcActualTorque = 0;
+		gIlcLastState = config->actualState;
+		return;
+	}
+
+	// new breath
+	if ((config->actualState == TOSV_STATE_INHALATION_RISE) && (gIlcLastState != TOSV_STATE_INHALATION_RISE))
+	{
+		// learned torque is only valid for the same breath settings
+		if ((config->tInhalationRise != gIlcBreathSettings.tInhalationRise) || (config->tInhalationPause != gIlcBreathSettings.tInhalationPause)
+		 || (config->tExhalationFall != gIlcBreathSettings.tExhalationFall) || (config->tExhalationPause != gIlcBreathSettings.tExhalationPause)
+		 || (config->pLIMIT != gIlcBreathSettings.pLIMIT) || (config->pPEEP != gIlcBreathSettings.pPEEP))
+		{
+			tosv_resetLearning();
+			gIlcBreathSettings.tInhalationRise = config->tInhalationRise;
+			gIlcBreathSettings.tInhalationPause = config->tInhalationPause;
+			gIlcBreathSettings.tExhalationFall = config->tExhalationFall;
+			gIlcBreathSettings.tExhalationPause = config->tExhalationPause;
+			gIlcBreathSettings.pLIMIT = config->pLIMIT;
+			gIlcBreathSettings.pPEEP = config->pPEEP;
+		}
+
+		gIlcBreathTime = 0;
+		gIlcFeedbackSum = 0;
+		gIlcLastFeedback[0] = 0;
+		gIlcLastFeedback[1] = 0;
+		gIlcBreaths++;
+	}
+	gIlcLastState = config->actualState;
+
+	uint16_t bin = gIlcBreathTime >> ILC_BIN_SHIFT;
+	if (bin >= ILC_BINS)
+	{
+		gIlcActualTorque = 0;
+		return;
+	}
+
+	gIlcFeedbackSum += bldc_getPressureFeedbackTorque(0);
+	gIlcBreathTime++;
+
+	// entry complete: update the previous entry with the smoothed feedback torque
+	if ((gIlcBreathTime & ((1 << ILC_BIN_SHIFT)-1)) == 0)
+	{
+		int32_t feedback = gIlcFeedbackSum >> ILC_BIN_SHIFT;
+
+		if (bin > 0)
+		{
+			int32_t smoothedFeedback = (gIlcLastFeedback[1] + 2*gIlcLastFeedback[0] + feedback) / 4;
+			int32_t torque = gIlcTorque[bin-1];
+			torque -= torque >> ILC_FORGET_SHIFT;
+			torque += ((int64_t)config->ilcGain * smoothedFeedback) >> 16;
+			gIlcTorque[bin-1] = tmc_limitInt(torque, -(int32_t)config->ilcMaxTorque, config->ilcMaxTorque);
+		}
+
+		gIlcLastFeedback[1] = gIlcLastFeedback[0];
+		gIlcLastFeedback[0] = feedback;
+		gIlcFeedbackSum = 0;
+	}
+
+	gIlcActualTorque = ((bin + ILC_LEAD_BINS) < ILC_BINS) ? gIlcTorque[bin + ILC_LEAD_BINS] : 0;
+}
+
+void tosv_resetLearning()
+{
+	for (int i = 0; i < ILC_BINS; i++)
+		gIlcTorque[i] = 0;
+
+	gIlcActualTorque = 0;
+	gIlcBreaths = 0;
+}
+
+/* learned feed forward torque of the actual breath phase [mA] */
+int32_t tosv_getLearnedTorque()
+{
+	return gIlcActualTorque;
+}
+
+/* number of breaths since the last reset of the learned torque */
+uint32_t tosv_getLearnedBreaths()
+{
+	return gIlcBreaths;
+}
+
+/* Estimate the lung mechanics from the estimated pressure, flow and volume of every tick of the breaths.
+ * The results are updated when the next breath starts (the volume integration restarts there).
+ */
+void tosv_updateLungMechanics(TOSV_Config *config)
+{
+	if (gIsFlowSensorPresent && (config->actualState >= TOSV_STATE_INHALATION_RISE))
+	{
+		if ((config->actualState == TOSV_STATE_INHALATION_RISE) && (gLungLastState == TOSV_STATE_EXHALATION_PAUSE))
+		{
+			if (lungMechanics_update(&gLungMechanics))
+			{
+				// [Pa/(l/s)] * [ml/kPa] = [us]
+				int64_t timeConstant = ((int64_t)gLungMechanics.resistance * gLungMechanics.compliance) / 1000;
+				conversion_setDivisor(&gAsbTimeConstantReciprocal, (timeConstant > 0) ? tmc_limitS64(timeConstant, 1, 60000) : 0);
+			}
+		}
+
+		lungMechanics_addSample(&gLungMechanics, bldc_getEstimatedPressure(0), bldc_getEstimatedFlow(0), gEstimatedVolume);
+	}
+
+	gLungLastState = config->actualState;
+}
+
+void tosv_resetLungMechanics()
+{
+	lungMechanics_reset(&gLungMechanics);
+	conversion_setDivisor(&gAsbTimeConstantReciprocal, 0);
+}
+
+/* [Pa/(l/s)] */
+int32_t tosv_getLungResistance()
+{
+	return gLungMechanics.resistance;
+}
+
+/* [ml/kPa] */
+int32_t tosv_getLungCompliance()
+{
+	return gLungMechanics.compliance;
+}
+
+/* end expiratory alveolar pressure [Pa] */
+int32_t tosv_getTotalPeep()
+{
+	return gLungMechanics.totalPeep;
+}
+
+/* number of breaths with valid results since the last reset */
+uint32_t tosv_getLungMechanicsUpdates()
+{
+	return gLungMechanics.updates;
+}
@@ -8,14 +8,26 @@
 #ifndef TOSV_H
 #define TOSV_H
 
+	#include <stddef.h>
 	#include "TMC-API/tmc/helpers/API_Header.h"
+	#include "Conversion.h"
+	#include "hal/system/Recorder.h"
 
 	typedef enum
 	{
 	  TOSV_MODE_PRESSURE_CONTROL,
 	  TOSV_MODE_VOLUME_CONTROL,
+	  TOSV_MODE_PRESSURE_SUPPORT,
+	  TOSV_MODE_PRVC,
+	  TOSV_MODE_FLOW_CONTROL,
 	} TOSV_Mode;
 
+	typedef enum
+	{
+	  TOSV_FLOW_PROFILE_CONSTANT,
+	  TOSV_FLOW_PROFILE_DECELERATING,
+	} TOSV_FlowProfile;
+
 	typedef struct
 	{
 		uint8_t  actualState;
@@ -30,8 +42,26 @@
 		uint32_t volumeMax;
 		TOSV_Mode mode;
 		bool asbEnable; // early state machine reset on spontaneous flow
-		int32_t asbThreshold;
+		int32_t asbThreshold;			// [ml/min]
 		uint32_t asbVolumeCondition;
+		uint16_t asbSlopeThreshold;		// [ml/min per ms] flow derivative
+		uint16_t asbTorqueThreshold;	// [mA] blower load disturbance
+		uint16_t asbBlowerInertia;		// [mA per rpm/ms] torque accelerating the blower
+		uint8_t psCycleThreshold;		// [%] of the peak flow, end of the supported inhalation
+		uint16_t psApneaTime;			// [ms] backup breath without patient trigger
+		uint16_t prvcMaxStep;			// [Pa] max. change of the inspiratory pressure per breath
+		uint8_t flowProfile;			// inspiratory flow of the flow control mode (TOSV_FlowProfile)
+		bool flowZeroTrackingEnable; // automatic flow offset update in exhalation pause
+		uint32_t flowZeroVarianceLimit;
+		bool ilcEnable; // breath to breath learning of the pressure feed forward torque
+		uint16_t ilcGain;
+		uint16_t ilcMaxTorque;
+		Reciprocal tStartupReciprocal;		// cached reciprocals of the ramp times
+		Reciprocal tInhalationRiseReciprocal;
+		Reciprocal tExhalationFallReciprocal;
+		Reciprocal asbThresholdReciprocal;	// cached reciprocals of the trigger thresholds
+		Reciprocal asbSlopeThresholdReciprocal;
+		Reciprocal asbTorqueThresholdReciprocal;
 	} TOSV_Config;
 
 	#define TOSV_STATE_STOPPED				0
@@ -41,17 +71,69 @@
 	#define TOSV_STATE_EXHALATION_FALL	    4
 	#define TOSV_STATE_EXHALATION_PAUSE	    5
 
+	// breath phase engine
+	#define TOSV_PHASES					6		// one phase per TOSV_STATE_*
+	#define TOSV_PHASE_TIME(time)		offsetof(TOSV_Config, time)
+	#define TOSV_PHASE_UNTIMED			0		// the phase only ends by its condition
+
+	typedef struct
+	{
+		void (*setpoint)(TOSV_Config *config);		// every tick: regulator setpoint of the phase
+		uint16_t duration;							// TOSV_PHASE_TIME() of the phase [ms] (or TOSV_PHASE_UNTIMED)
+		bool (*condition)(TOSV_Config *config);		// early end of the phase (optional)
+		void (*action)(TOSV_Config *config);		// on leaving the phase (optional)
+		uint8_t next;								// following state
+	} TOSV_Phase;
+
 	void tosv_init(TOSV_Config *config);
+	void tosv_updateConversions(TOSV_Config *config);
+	void tosv_resetLearning();
+	int32_t tosv_getLearnedTorque();
+	uint32_t tosv_getLearnedBreaths();
+	int32_t tosv_getAsbScore();
+	void tosv_resetAsbStatistics();
+	uint32_t tosv_getAsbTriggerCount();
+	uint16_t tosv_getAsbLastLatency();
+	uint16_t tosv_getAsbMeanLatency();
+	uint16_t tosv_getAsbMaxLatency();
+	void tosv_resetLungMechanics();
+	int32_t tosv_getLungResistance();
+	int32_t tosv_getLungCompliance();
+	int32_t tosv_getTotalPeep();
+	uint32_t tosv_getLungMechanicsUpdates();
+	int32_t tosv_getPsPeakFlow();
+	uint16_t tosv_getPsInhalationTime();
+	uint32_t tosv_getPsApneaCount();
+	void tosv_resetPsApneaCount();
+	int32_t tosv_getPrvcPressure(TOSV_Config *config);
+	int32_t tosv_getPrvcTidalVolume();
+	int32_t tosv_getPrvcVolumeError();
+	uint32_t tosv_getPrvcConvergedBreaths();
+	uint32_t tosv_getPrvcBreaths();
+	int32_t tosv_getInspiratoryFlowTarget();
 	void tosv_initFlowSensor();
 	void tosv_process(TOSV_Config *config);
+	void tosv_processPhase(TOSV_Config *config, const TOSV_Phase *phases);
 	void tosv_enableVentilator(TOSV_Config *config, bool enable);
 	bool tosv_isVentilatorEnabled(TOSV_Config *config);
+	bool tosv_setMode(TOSV_Config *config, uint32_t mode);
+	void tosv_visitState(Recorder_StateVisitor visit);
 
 	void tosv_zeroFlow();
+	int32_t tosv_getFlowOffset();
+	uint32_t tosv_getFlowZeroUpdateCount();
 	void tosv_resetVolumeIntegration();
 	int32_t tosv_getFlowValue();
+	int32_t tosv_getActualFlowValue();
 	void tosv_reInitFlowSensor();
-	void tosv_updateFlowSensor();
+	bool tosv_updateFlowSensor();
+	void tosv_updateFlowCalibration();
+	int16_t tosv_getFlowSensorTemperature();
+	int16_t tosv_getFlowSensorPressure();
+	uint16_t tosv_getFlowSensorStatus();
+	uint32_t tosv_getFlowSensorRejectedSamples();
 	int32_t tosv_updateVolume(uint8_t motor);
+	int32_t tosv_integrateVolume(int64_t *flowSum, int32_t flow);
+	int32_t tosv_getEstimatedVolume();
 
 #endif
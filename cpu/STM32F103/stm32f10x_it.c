@@ -277,7 +277,7 @@ void EXTI4_IRQHandler(void)
 * Output         : None
 * Return         : None
 *******************************************************************************/
-void DMA1_Channel1_IRQHandler(void)
+void __attribute__ ((weak)) DMA1_Channel1_IRQHandler(void)
 {
 }
 
@@ -7,7 +7,7 @@
 
 #include "Flags.h"
 
-volatile uint32_t statusFlags[NUMBER_OF_MOTORS]; // error and status flags (Overvoltage, Overcurrent,...)
+INSTANCE_STATE volatile uint32_t statusFlags[NUMBER_OF_MOTORS]; // error and status flags (Overvoltage, Overcurrent,...)
 
 void flags_init(uint8_t motor)
 {
@@ -71,3 +71,9 @@ uint32_t flags_getErrorFlags(uint8_t motor)
 	flags_resetErrorFlags(motor);
     return flags;
 }
+
+/* status flags of all axes for the header of a recording */
+void flags_visitState(Recorder_StateVisitor visit)
+{
+	visit((uint32_t *)statusFlags, sizeof(statusFlags));
+}
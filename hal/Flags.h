@@ -8,7 +8,8 @@
 #ifndef FLAGS_H
 #define FLAGS_H
 
-	#include "HAL_Definitions.h"
+	#include "Hal_Definitions.h"
+	#include "system/Recorder.h"
 
 	// error- and status flags
 	#define OVERCURRENT             0x00000001	// 0
@@ -31,11 +32,14 @@
 	#define POSITION_END            0x00004000	// 14
 	#define MODULE_INITIALIZED		0x00008000	// 15
 
+	#define FLOW_MODE				0x00010000	// 16
+
 	void flags_init(uint8_t motor);
 	void flags_setStatusFlag(uint8_t motor, uint32_t flag);
 	void flags_clearStatusFlag(uint8_t motor, uint32_t flag);
 	void flags_setStatusFlagEnabled(uint8_t motor, uint32_t flag, bool enabled);
 	uint8_t flags_isStatusFlagSet(uint8_t motor, uint32_t flag);
+	void flags_visitState(Recorder_StateVisitor visit);
 	void flags_resetErrorFlags(uint8_t motor);
 	uint32_t flags_getAllStatusFlags(uint8_t motor);
 	uint32_t flags_getErrorFlags(uint8_t motor);
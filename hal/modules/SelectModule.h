@@ -15,10 +15,15 @@
 	// define module type
 	#define STARTRAMPE_TOSV_V10				1
 	#define TMC4671_TMC6100_TOSV_REF_V10	2
+	#define SIMULATION_TOSV_V10				3
 
 	// select the actual module
+#ifdef HOST_SIMULATION
+	#define DEVICE SIMULATION_TOSV_V10
+#else
 //	#define DEVICE STARTRAMPE_TOSV_V10
 	#define DEVICE TMC4671_TMC6100_TOSV_REF_V10
+#endif
 
 #if DEVICE == STARTRAMPE_TOSV_V10
 
@@ -30,6 +35,11 @@
 	/* device configuration for TOSV reference board (STM32F103 128k) */
 	#include "TMC4671-TMC6100-TOSV-REF_v1.0.h"
 
+#elif DEVICE == SIMULATION_TOSV_V10
+
+	/* host simulation of the TOSV reference board (see host/) */
+	#include "Simulation-TOSV_v1.0.h"
+
 #else
 
 	/* device not found */
@@ -0,0 +1,386 @@
+/*
+ * Simulation-TOSV_v1.0.c
+ *
+ *  Host simulation of the TOSV reference board. The TMC4671, TMC6200, EEPROM and SM9333 are emulated
+ *  behind the SPI and I2C functions by the host (see host/Chips.c), the ADC inputs are set by the
+ *  simulated plant once per control tick.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Simulation-TOSV_v1.0.h"
+#include "BLDC.h"
+#include "hal/system/SysTick.h"
+
+#if DEVICE==SIMULATION_TOSV_V10
+
+// general module settings
+const char *VersionString="0020V111";
+
+// ADC inputs (AIN0..AIN2, unused, MOT_TEMP) as sum of the 16 conversions of a control tick
+#define ADC_PINS			5
+#define ADC_OVERSAMPLING	16
+static INSTANCE_STATE uint16_t ADCValueOversampled[ADC_PINS];
+static INSTANCE_STATE uint8_t ADCSampleReady = false;
+
+static INSTANCE_STATE uint8_t driverEnabled[NUMBER_OF_MOTORS];
+static INSTANCE_STATE uint8_t outputPins;
+
+// ADC1
+uint8_t	ADC_VOLTAGE = 3;
+uint8_t ADC_MOT_TEMP = 4;
+
+// configuration and control state of the module
+INSTANCE_STATE TModuleConfig moduleConfig;
+INSTANCE_STATE TMotorConfig motorConfig[NUMBER_OF_MOTORS];
+INSTANCE_STATE TMC_LinearRamp rampGenerator[NUMBER_OF_MOTORS];
+INSTANCE_STATE TOSV_Config tosvConfig[NUMBER_OF_MOTORS];
+
+void tmcm_initModuleConfig()
+{
+	moduleConfig.baudrate 				= 7; // UART 115200bps
+	moduleConfig.serialModuleAddress 	= 1;
+	moduleConfig.serialHostAddress		= 2;
+}
+
+void tmcm_initMotorConfig()
+{
+	// firmware default values (as on the reference board)
+
+	motorConfig[0].absMaxPositiveCurrent 	= 3000;
+	motorConfig[0].absMaxNegativeCurrent	= 800;
+	motorConfig[0].maxVelocity 				= 80000;
+	motorConfig[0].acceleration				= 20000;
+	motorConfig[0].maxPressure				= 50000;
+
+	// pressure sensor calibration: former fixed conversion ADC*25000/517-20000 (12 bit ADC)
+	for (int i = 0; i < PRESSURE_CAL_POINTS; i++)
+	{
+		motorConfig[0].pressureCalAdc[i]		= (i * 65535) / (PRESSURE_CAL_POINTS-1);
+		motorConfig[0].pressureCalPressure[i]	= (motorConfig[0].pressureCalAdc[i] * 25000) / (517*16) - 20000;
+	}
+	motorConfig[0].pressureCalOffset		= 0;
+	motorConfig[0].useVelocityRamp			= true;
+	motorConfig[0].openLoopCurrent			= 1000;
+	motorConfig[0].motorType				= TMC4671_THREE_PHASE_BLDC;
+	motorConfig[0].motorPolePairs			= 2;
+	motorConfig[0].commutationMode			= COMM_MODE_FOC_DISABLED;
+	motorConfig[0].adc_I0_offset			= 33200;
+	motorConfig[0].adc_I1_offset			= 33200;
+
+	motorConfig[0].hallPolarity 			= 0;
+	motorConfig[0].hallDirection			= 0;
+	motorConfig[0].hallInterpolation		= 1;
+	motorConfig[0].hallPhiEOffset			= 0;
+
+	motorConfig[0].dualShuntFactor			= 135;
+	motorConfig[0].shaftBit					= 1;
+
+	motorConfig[0].pidTorque_P_param		= 300;
+	motorConfig[0].pidTorque_I_param		= 1000;
+	motorConfig[0].pidVelocity_P_param		= 500;
+	motorConfig[0].pidVelocity_I_param		= 100;
+
+	motorConfig[0].pidPressure_P_param		= 1000;
+	motorConfig[0].pidPressure_I_param		= 3000;
+
+	motorConfig[0].pidVolume_P_param		= 2000;
+	motorConfig[0].pidVolume_I_param		= 2000;
+
+	motorConfig[0].pidPressure_D_param		= 0;
+	motorConfig[0].pidVolume_D_param		= 0;
+	motorConfig[0].pidPressureSetpointWeight= 256;
+	motorConfig[0].pidVolumeSetpointWeight	= 256;
+	motorConfig[0].pidFlow_P_param			= 30;
+	motorConfig[0].pidFlow_I_param			= 1000;
+	motorConfig[0].pidFlowOutput			= FLOW_OUTPUT_PRESSURE;
+	motorConfig[0].pressureCascade			= PRESSURE_CASCADE_TORQUE;
+	motorConfig[0].pidPressureVelocity_P_param	= 512;
+	motorConfig[0].pidPressureVelocity_I_param	= 4000;
+	motorConfig[0].maxTorqueStep			= 0;
+
+	motorConfig[0].ffEnable					= false;
+	motorConfig[0].ffPressureGain			= 0;
+	motorConfig[0].ffSlopeGain				= 0;
+	motorConfig[0].ffFlowGain				= 0;
+
+	motorConfig[0].ilcEnable				= false;
+	motorConfig[0].ilcGain					= 32000;
+	motorConfig[0].ilcMaxTorque				= 1000;
+
+	motorConfig[0].pidPressureScheduleEnable	= false;
+	motorConfig[0].pidPressureScheduleBlendTime	= 50;
+	for (int i = 0; i < PRESSURE_GAIN_SETS; i++)
+	{
+		motorConfig[0].pidPressureSchedule_P_param[i]	= motorConfig[0].pidPressure_P_param;
+		motorConfig[0].pidPressureSchedule_I_param[i]	= motorConfig[0].pidPressure_I_param;
+	}
+
+	motorConfig[0].autotuneAmplitude		= 300;
+	motorConfig[0].autotuneHysteresis		= 20;
+	motorConfig[0].autotuneSettleTime		= 2000;
+
+	motorConfig[0].pressureSignal			= FEEDBACK_SIGNAL_RAW;
+	motorConfig[0].flowSignal				= FEEDBACK_SIGNAL_PT1;
+	motorConfig[0].estPressureNoiseRatio	= 50;
+	motorConfig[0].estFlowNoiseRatio		= 20;
+	motorConfig[0].estBlowerPressure		= 0;
+
+	motorConfig[0].brakeChopperEnabled		= 0;
+	motorConfig[0].brakeChopperHysteresis	= 5;
+	motorConfig[0].brakeChopperVoltage		= 260;
+
+	motorConfig[0].pwm_freq 				= 100000;
+
+	motorConfig[0].tStartup					= 1000;
+	motorConfig[0].tInhalationRise			= 500;
+	motorConfig[0].tInhalationPause			= 1000;
+	motorConfig[0].tExhalationFall			= 500;
+	motorConfig[0].tExhalationPause			= 1500;
+	motorConfig[0].pLIMIT					= 5000;
+	motorConfig[0].pPEEP					= 1500;
+	motorConfig[0].volumeMax				= 150;
+	motorConfig[0].asbEnable                = false;
+	motorConfig[0].asbThreshold             = 500;
+	motorConfig[0].asbVolumeCondition       = 70;
+	motorConfig[0].asbSlopeThreshold        = 0;
+	motorConfig[0].asbTorqueThreshold       = 0;
+	motorConfig[0].asbBlowerInertia         = 17;
+	motorConfig[0].psCycleThreshold         = 25;
+	motorConfig[0].psApneaTime              = 20000;
+	motorConfig[0].prvcMaxStep              = 300;
+	motorConfig[0].flowProfile              = TOSV_FLOW_PROFILE_CONSTANT;
+	motorConfig[0].flowZeroTrackingEnable   = false;
+	motorConfig[0].flowZeroVarianceLimit    = 2500;
+
+	// flow sensor calibration: 1 count = 2 ml/min
+	for (int i = 0; i < FLOW_CAL_POINTS; i++)
+	{
+		motorConfig[0].flowCalCounts[i]		= -32000 + i*8000;
+		motorConfig[0].flowCalFlow[i]		= motorConfig[0].flowCalCounts[i] * 2;
+	}
+	motorConfig[0].flowCalTempRef			= 0;
+	motorConfig[0].flowCalTempCoeff			= 0;
+
+
+	// all blowers use the same defaults
+	for (int motor = 1; motor < NUMBER_OF_MOTORS; motor++)
+		motorConfig[motor] = motorConfig[0];
+
+	// init ramp generator
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+		tmc_linearRamp_init(&rampGenerator[motor]);
+
+	// tosv control
+	tosv_init(&tosvConfig[0]);
+}
+
+void tmcm_updateConfig()
+{
+	// the emulated ICs need no power up delay
+
+	// use motor config to update tosv values with EEPROM stored values
+	tosvConfig[0].tStartup 			= motorConfig[0].tStartup;
+	tosvConfig[0].tInhalationRise 	= motorConfig[0].tInhalationRise;
+	tosvConfig[0].tInhalationPause 	= motorConfig[0].tInhalationPause;
+	tosvConfig[0].tExhalationFall 	= motorConfig[0].tExhalationFall;
+	tosvConfig[0].tExhalationPause 	= motorConfig[0].tExhalationPause;
+	tosvConfig[0].pLIMIT 			= motorConfig[0].pLIMIT;
+	tosvConfig[0].pPEEP 			= motorConfig[0].pPEEP;
+	tosvConfig[0].volumeMax         = motorConfig[0].volumeMax;
+	tosvConfig[0].asbEnable 		= motorConfig[0].asbEnable;
+	tosvConfig[0].asbThreshold      = motorConfig[0].asbThreshold;
+	tosvConfig[0].asbVolumeCondition= motorConfig[0].asbVolumeCondition;
+	tosvConfig[0].asbSlopeThreshold = motorConfig[0].asbSlopeThreshold;
+	tosvConfig[0].asbTorqueThreshold= motorConfig[0].asbTorqueThreshold;
+	tosvConfig[0].asbBlowerInertia= motorConfig[0].asbBlowerInertia;
+	tosvConfig[0].psCycleThreshold  = motorConfig[0].psCycleThreshold;
+	tosvConfig[0].psApneaTime       = motorConfig[0].psApneaTime;
+	tosvConfig[0].prvcMaxStep       = motorConfig[0].prvcMaxStep;
+	tosvConfig[0].flowProfile       = motorConfig[0].flowProfile;
+	tosvConfig[0].flowZeroTrackingEnable = motorConfig[0].flowZeroTrackingEnable;
+	tosvConfig[0].flowZeroVarianceLimit  = motorConfig[0].flowZeroVarianceLimit;
+	tosvConfig[0].ilcEnable         = motorConfig[0].ilcEnable;
+	tosvConfig[0].ilcGain           = motorConfig[0].ilcGain;
+	tosvConfig[0].ilcMaxTorque      = motorConfig[0].ilcMaxTorque;
+	tosv_updateConversions(&tosvConfig[0]);
+	tosv_updateFlowCalibration();
+
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+	{
+		// === configure linear ramp generator
+		rampGenerator[motor].maxVelocity  = motorConfig[motor].maxVelocity;
+		rampGenerator[motor].acceleration = motorConfig[motor].acceleration;
+		rampGenerator[motor].rampEnabled  = motorConfig[motor].useVelocityRamp;
+
+		// === configure TMC6200 ===
+		tmc6200_writeInt(motor, TMC6200_GCONF, 0);	// normal pwm control
+		tmc6200_writeInt(motor, TMC6200_DRV_CONF, 0);	// BBM_OFF and DRVSTRENGTH to weak
+
+		// === configure TMC4671 ===
+
+		// Motor type &  PWM configuration
+		tmc4671_writeInt(motor, TMC4671_MOTOR_TYPE_N_POLE_PAIRS, ((u32)motorConfig[motor].motorType << TMC4671_MOTOR_TYPE_SHIFT) | motorConfig[motor].motorPolePairs);
+		tmc4671_writeInt(motor, TMC4671_ADC_I0_SCALE_OFFSET, 0x01000000 | motorConfig[motor].adc_I0_offset);
+		tmc4671_writeInt(motor, TMC4671_ADC_I1_SCALE_OFFSET, 0x01000000 | motorConfig[motor].adc_I1_offset);
+
+		// hall configuration
+		bldc_updateHallSettings(motor);
+
+		// pressure sensor calibration
+		bldc_updatePressureCalibration(motor);
+
+		// cached regulator settings
+		bldc_updateRegulatorSettings(motor);
+
+		// cached reciprocals
+		bldc_updateConversions(motor);
+
+		// state estimation
+		bldc_updateEstimatorSettings(motor);
+
+		// PI configuration
+		tmc4671_setTorqueFluxPI(motor, motorConfig[motor].pidTorque_P_param, motorConfig[motor].pidTorque_I_param);
+		tmc4671_setVelocityPI(motor, motorConfig[motor].pidVelocity_P_param, motorConfig[motor].pidVelocity_I_param);
+
+		// limit configuration
+		tmc4671_writeInt(motor, TMC4671_PID_VELOCITY_LIMIT, motorConfig[motor].maxVelocity * motorConfig[motor].motorPolePairs);
+		tmc4671_setTorqueFluxLimit_mA(motor, motorConfig[motor].dualShuntFactor, motorConfig[motor].absMaxPositiveCurrent);
+
+		// reset target values
+		tmc4671_writeInt(motor, TMC4671_UQ_UD_EXT, 0);
+		tmc4671_writeInt(motor, TMC4671_PIDIN_TORQUE_TARGET_FLUX_TARGET, 0);
+		tmc4671_writeInt(motor, TMC4671_PIDIN_VELOCITY_TARGET, 0);
+		tmc4671_writeInt(motor, TMC4671_OPENLOOP_VELOCITY_TARGET, 0);
+	}
+}
+
+void tmcm_initModuleSpecificIO()
+{
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+		driverEnabled[motor] = true;
+
+	outputPins = 0;
+}
+
+/* The simulation sets the ADC inputs and the sample ready flag once per control tick. */
+void tmcm_initModuleSpecificADC()
+{
+	for (int pin = 0; pin < ADC_PINS; pin++)
+		ADCValueOversampled[pin] = 0;
+
+	ADCSampleReady = false;
+}
+
+/* set the sum of the 16 conversions of the next control tick */
+void tmcm_setSimulatedADCValue(uint8_t pin, uint16_t oversampledValue)
+{
+	if (pin < ADC_PINS)
+		ADCValueOversampled[pin] = oversampledValue;
+}
+
+/* all inputs of the control tick are set */
+void tmcm_setSimulatedADCSampleReady()
+{
+	ADCSampleReady = true;
+}
+
+void tmcm_led_run_toggle()
+{
+}
+
+void tmcm_enableDriver(uint8_t motor)
+{
+	if (motor < NUMBER_OF_MOTORS)
+		driverEnabled[motor] = true;
+}
+
+void tmcm_disableDriver(uint8_t motor)
+{
+	if (motor < NUMBER_OF_MOTORS)
+		driverEnabled[motor] = false;
+}
+
+uint8_t tmcm_getDriverState(uint8_t motor)
+{
+	if (motor < NUMBER_OF_MOTORS)
+		return driverEnabled[motor];
+
+	return 0;
+}
+
+// chip selects are part of the emulated SPI transfers
+void tmcm_enableCsWeasel(uint8_t motor){}
+void tmcm_disableCsWeasel(uint8_t motor){}
+void tmcm_enableCsDragon(uint8_t motor){}
+void tmcm_disableCsDragon(uint8_t motor){}
+void tmcm_enableCsMem(){}
+void tmcm_disableCsMem(){}
+
+// UART configuration
+void tmcm_setUartToSendMode(){}
+void tmcm_setUartToReceiveMode(){}
+uint8_t tmcm_isUartSending(){ return false; }
+
+// RS485 configuration
+void tmcm_setRS485ToSendMode(){}
+void tmcm_setRS485ToReceiveMode(){}
+uint8_t tmcm_isRS485Sending(){ return false; }
+
+void tmcm_clearModuleSpecificIOPin(uint8_t pin)
+{
+	if (pin <= 5)
+		outputPins &= ~(1 << pin);
+}
+
+void tmcm_setModuleSpecificIOPin(uint8_t pin)
+{
+	if (pin <= 5)
+		outputPins |= (1 << pin);
+}
+
+uint8_t tmcm_getModuleSpecificIOPin(uint8_t pin)
+{
+	return 0;
+}
+
+uint8_t tmcm_getModuleSpecificIOPinStatus(uint8_t pin)
+{
+	if (pin <= 5)
+		return (outputPins & (1 << pin)) ? 1:0;
+
+	return 0;
+}
+
+/* sum of the 16 conversions of the last control tick (ADC_AIN0..ADC_AIN2 and ADC_MOT_TEMP) */
+uint16_t tmcm_getModuleSpecificOversampledADCValue(uint8_t pin)
+{
+	if ((pin < ADC_PINS) && (pin != ADC_VOLTAGE))
+		return ADCValueOversampled[pin];
+
+	return 0;
+}
+
+/* true once per control tick when new ADC values are available */
+uint8_t tmcm_getADCSampleReady()
+{
+	if (ADCSampleReady)
+	{
+		ADCSampleReady = false;
+		return true;
+	}
+	return false;
+}
+
+uint16_t tmcm_getModuleSpecificADCValue(uint8_t pin)
+{
+	if (pin == ADC_VOLTAGE)
+		return (tmc4671_readFieldWithDependency(DEFAULT_MC, TMC4671_ADC_RAW_DATA, TMC4671_ADC_RAW_ADDR, 1, TMC4671_ADC_VM_RAW_MASK, TMC4671_ADC_VM_RAW_SHIFT) - VOLTAGE_OFFSET);
+
+	if (pin < ADC_PINS)
+		return ADCValueOversampled[pin] / ADC_OVERSAMPLING;
+
+	return 0;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Simulation-TOSV_v1.0.h
+ *
+ *  Host simulation of the TOSV reference board (see host/)
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef SIMULATION_TOSV_V10_H
+#define SIMULATION_TOSV_V10_H
+
+	#include "SelectModule.h"
+
+#if DEVICE==SIMULATION_TOSV_V10
+
+	// same cpu as the reference board, the peripherals are emulated by the host
+	#define BOARD_CPU STM32F103
+
+	// number of simulated blowers (axis 0 ventilates, further axes hold a pressure on their own sensor)
+	#ifndef SIMULATION_MOTORS
+		#define SIMULATION_MOTORS	1
+	#endif
+	#define NUMBER_OF_MOTORS 		SIMULATION_MOTORS
+
+	// no cpu headers, the peripherals of the module are emulated in Simulation-TOSV_v1.0.c
+	// and host/Chips.c, only the handles used by the shared code are declared
+	#include <stdint.h>
+	typedef struct { uint32_t reserved; } I2C_TypeDef;
+	#define I2C1	((I2C_TypeDef *) 0)
+
+	#define MAX_VELOCITY 				(int32_t)200000
+	#define MAX_ACCELERATION			(int32_t)100000
+
+	#define MAX_CURRENT 				(int32_t)6000		// RMS current
+	#define MAX_PRESSURE				(int32_t)70000
+	#define MAX_VOLUME				    (int32_t)70000
+	#define MAX_FLOW				    (int32_t)300000		// [ml/min]
+
+	#define RECORDER_BUFFER_SIZE		65536	// [byte] recordings of some seconds for the replay tests
+
+	#define TMCM_USE_IIC_INTERFACE
+	#define I2C_PRESSURE_SENSOR_SM9333
+	#define DIFF_PRESSURE_SENSOR_SM9333
+
+	// no communication interfaces, TMCL commands are executed by the host directly
+
+	#include "../../Definitions.h"
+	#include "../Hal_Definitions.h"
+	#include "../Flags.h"
+	#include "../../TOSV.h"
+
+	#include "TMC-API/tmc/ic/TMC4671/TMC4671.h"
+	#include "TMC-API/tmc/ic/TMC4671/TMC4671_Variants.h"
+	#include "TMC-API/tmc/ic/TMC6200/TMC6200.h"
+	#include "TMC-API/tmc/ramp/LinearRamp.h"
+
+	// module number in HEX (0020)
+	#define SW_TYPE_HIGH 		0x00
+	#define SW_TYPE_LOW  		0x14
+
+	#define SW_VERSION_HIGH 	1
+	#define SW_VERSION_LOW  	11
+
+	#define TMCM_EEPROM_MAGIC	(uint8_t)0x7D	// 125
+
+	extern INSTANCE_STATE TMC_LinearRamp rampGenerator[NUMBER_OF_MOTORS];
+	extern INSTANCE_STATE TOSV_Config tosvConfig[NUMBER_OF_MOTORS];
+
+	#define MIN_CRITICAL_TEMP     	100 // [C]
+	#define MAX_CRITICAL_TEMP     	120	// [C]
+
+	#define MAX_SUPPLY_VOLTAGE		3600 	// 36.0V
+	#define ON__SUPPLY_VOLTAGE		60 		// 6.0V
+	#define MIN_SUPPLY_VOLTAGE		60		// 6.0V
+	#define VOLTAGE_FAKTOR		   	79.2	// *10 because of [0,1V] TMC4671-LA
+	#define VOLTAGE_OFFSET		  	37100 	//TMC4671-LA
+
+	// one pressure sensor per blower (AIN0, AIN1, ...)
+	#define PRESSURE_SENSOR_PIN		0
+	#if NUMBER_OF_MOTORS == 2
+		#define PRESSURE_SENSOR_PINS	{ 0, 1 }
+	#elif NUMBER_OF_MOTORS > 2
+		#error "Simulation supports up to two blowers!"
+	#endif
+
+	// inputs set by the host simulation
+	void tmcm_setSimulatedADCValue(uint8_t pin, uint16_t oversampledValue);
+	void tmcm_setSimulatedADCSampleReady();
+
+#endif /* DEVICE==SIMULATION_TOSV_V10 */
+
+#endif /* SIMULATION_TOSV_V10_H */
@@ -18,12 +18,18 @@ uint32_t PLL_N = 120;
 // ADC configuration
 #define ADC1_DR_ADDRESS    	((uint32_t)0x4001204C)
 #define ADC1_CHANNELS		3
-static volatile uint16_t ADC1Value[ADC1_CHANNELS];	// array for analog values (filled by DMA)
+static INSTANCE_STATE volatile uint16_t ADC1Value[ADC1_CHANNELS];	// array for analog values (filled by DMA)
 
 // ADC1
 uint8_t	ADC_VOLTAGE = 0;	// unused
 uint8_t ADC_MOT_TEMP = 0;	// unused
 
+// configuration and control state of the module
+INSTANCE_STATE TModuleConfig moduleConfig;
+INSTANCE_STATE TMotorConfig motorConfig[NUMBER_OF_MOTORS];
+INSTANCE_STATE TMC_LinearRamp rampGenerator[NUMBER_OF_MOTORS];
+INSTANCE_STATE TOSV_Config tosvConfig[NUMBER_OF_MOTORS];
+
 void tmcm_initModuleConfig()
 {
 	moduleConfig.baudrate 				= 7; // UART 115200bps
@@ -36,6 +42,15 @@ void tmcm_initMotorConfig()
 	motorConfig[0].maximumCurrent 			= 2700;
 	motorConfig[0].maxVelocity		 		= 80000;
 	motorConfig[0].acceleration				= 20000;
+
+	// pressure sensor calibration: former fixed conversion ADC*25000/517-20000 (12 bit ADC)
+	for (int i = 0; i < PRESSURE_CAL_POINTS; i++)
+	{
+		motorConfig[0].pressureCalAdc[i]		= (i * 65535) / (PRESSURE_CAL_POINTS-1);
+		motorConfig[0].pressureCalPressure[i]	= (motorConfig[0].pressureCalAdc[i] * 25000) / (517*16) - 20000;
+	}
+	motorConfig[0].pressureCalOffset		= 0;
+
 	motorConfig[0].useVelocityRamp			= true;
 	motorConfig[0].openLoopCurrent			= 1000;
 	motorConfig[0].motorType				= TMC4671_THREE_PHASE_BLDC;
@@ -60,8 +75,66 @@ void tmcm_initMotorConfig()
 	motorConfig[0].pidPressure_P_param		= 3000;
 	motorConfig[0].pidPressure_I_param		= 3000;
 
+	motorConfig[0].pidPressure_D_param		= 0;
+	motorConfig[0].pidVolume_D_param		= 0;
+	motorConfig[0].pidPressureSetpointWeight= 256;
+	motorConfig[0].pidVolumeSetpointWeight	= 256;
+	motorConfig[0].pidFlow_P_param			= 30;
+	motorConfig[0].pidFlow_I_param			= 1000;
+	motorConfig[0].pidFlowOutput			= FLOW_OUTPUT_PRESSURE;
+	motorConfig[0].pressureCascade			= PRESSURE_CASCADE_TORQUE;
+	motorConfig[0].pidPressureVelocity_P_param	= 512;
+	motorConfig[0].pidPressureVelocity_I_param	= 4000;
+	motorConfig[0].maxTorqueStep			= 0;
+
+	motorConfig[0].ffEnable					= false;
+	motorConfig[0].ffPressureGain			= 0;
+	motorConfig[0].ffSlopeGain				= 0;
+	motorConfig[0].ffFlowGain				= 0;
+
+	motorConfig[0].ilcEnable				= false;
+	motorConfig[0].ilcGain					= 32000;
+	motorConfig[0].ilcMaxTorque				= 1000;
+
+	motorConfig[0].pidPressureScheduleEnable	= false;
+	motorConfig[0].pidPressureScheduleBlendTime	= 50;
+	for (int i = 0; i < PRESSURE_GAIN_SETS; i++)
+	{
+		motorConfig[0].pidPressureSchedule_P_param[i]	= motorConfig[0].pidPressure_P_param;
+		motorConfig[0].pidPressureSchedule_I_param[i]	= motorConfig[0].pidPressure_I_param;
+	}
+
+	motorConfig[0].autotuneAmplitude		= 300;
+	motorConfig[0].autotuneHysteresis		= 20;
+	motorConfig[0].autotuneSettleTime		= 2000;
+
+	motorConfig[0].pressureSignal			= FEEDBACK_SIGNAL_RAW;
+	motorConfig[0].flowSignal				= FEEDBACK_SIGNAL_PT1;
+	motorConfig[0].estPressureNoiseRatio	= 50;
+	motorConfig[0].estFlowNoiseRatio		= 20;
+	motorConfig[0].estBlowerPressure		= 0;
+
 	motorConfig[0].pwm_freq 				= 100000;
 
+	motorConfig[0].asbSlopeThreshold		= 0;
+	motorConfig[0].asbTorqueThreshold		= 0;
+	motorConfig[0].asbBlowerInertia			= 17;
+	motorConfig[0].psCycleThreshold			= 25;
+	motorConfig[0].psApneaTime				= 20000;
+	motorConfig[0].prvcMaxStep				= 300;
+	motorConfig[0].flowProfile				= TOSV_FLOW_PROFILE_CONSTANT;
+	motorConfig[0].flowZeroTrackingEnable	= false;
+	motorConfig[0].flowZeroVarianceLimit	= 2500;
+
+	// flow sensor calibration: 1 count = 2 ml/min
+	for (int i = 0; i < FLOW_CAL_POINTS; i++)
+	{
+		motorConfig[0].flowCalCounts[i]		= -32000 + i*8000;
+		motorConfig[0].flowCalFlow[i]		= motorConfig[0].flowCalCounts[i] * 2;
+	}
+	motorConfig[0].flowCalTempRef			= 0;
+	motorConfig[0].flowCalTempCoeff			= 0;
+
 	// init ramp generator
 	tmc_linearRamp_init(&rampGenerator[0]);
 
@@ -85,6 +158,20 @@ void tmcm_updateConfig()
 //	config->timeState4 = 1000;
 //	config->maxPressure = 2000;
 //	config->peepPressure = 1200;
+	tosvConfig[0].asbSlopeThreshold = motorConfig[0].asbSlopeThreshold;
+	tosvConfig[0].asbTorqueThreshold= motorConfig[0].asbTorqueThreshold;
+	tosvConfig[0].asbBlowerInertia= motorConfig[0].asbBlowerInertia;
+	tosvConfig[0].psCycleThreshold  = motorConfig[0].psCycleThreshold;
+	tosvConfig[0].psApneaTime       = motorConfig[0].psApneaTime;
+	tosvConfig[0].prvcMaxStep       = motorConfig[0].prvcMaxStep;
+	tosvConfig[0].flowProfile       = motorConfig[0].flowProfile;
+	tosvConfig[0].flowZeroTrackingEnable = motorConfig[0].flowZeroTrackingEnable;
+	tosvConfig[0].flowZeroVarianceLimit  = motorConfig[0].flowZeroVarianceLimit;
+	tosvConfig[0].ilcEnable         = motorConfig[0].ilcEnable;
+	tosvConfig[0].ilcGain           = motorConfig[0].ilcGain;
+	tosvConfig[0].ilcMaxTorque      = motorConfig[0].ilcMaxTorque;
+	tosv_updateConversions(&tosvConfig[0]);
+	tosv_updateFlowCalibration();
 
 	// === configure TMC6200 ===
 	tmc6200_writeInt(DEFAULT_DRV, TMC6200_GCONF, 0);	// normal pwm control
@@ -111,6 +198,18 @@ void tmcm_updateConfig()
 	// hall configuration
 	bldc_updateHallSettings(DEFAULT_MC);
 
+	// pressure sensor calibration
+	bldc_updatePressureCalibration(DEFAULT_MC);
+
+	// cached regulator settings
+	bldc_updateRegulatorSettings(DEFAULT_MC);
+
+	// cached reciprocals
+	bldc_updateConversions(DEFAULT_MC);
+
+	// state estimation
+	bldc_updateEstimatorSettings(DEFAULT_MC);
+
 	// PI configuration
 	tmc4671_setTorqueFluxPI(DEFAULT_MC, motorConfig[0].pidTorque_P_param, motorConfig[0].pidTorque_I_param);
 	tmc4671_setVelocityPI(DEFAULT_MC, motorConfig[0].pidVelocity_P_param, motorConfig[0].pidVelocity_I_param);
@@ -373,6 +472,17 @@ uint8_t tmcm_getModuleSpecificIOPinStatus(uint8_t pin)
 	return 0;
 }
 
+/* no oversampling on this board, scaled to the 16 bit range of the oversampled values */
+uint16_t tmcm_getModuleSpecificOversampledADCValue(uint8_t pin)
+{
+	return tmcm_getModuleSpecificADCValue(pin) << 4;
+}
+
+uint8_t tmcm_getADCSampleReady()
+{
+	return true;
+}
+
 uint16_t tmcm_getModuleSpecificADCValue(uint8_t pin)
 {
 	switch(pin)
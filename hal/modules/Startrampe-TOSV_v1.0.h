@@ -29,6 +29,8 @@
 	#define MAX_CURRENT 			(int32_t)5000
 	#define MAX_PRESSURE			(int32_t)10000
 
+	#define RECORDER_BUFFER_SIZE	16384	// [byte] capture of the control loop inputs (64k RAM)
+
 	#define EEPROM_SPI1_ON_PB3_PB4_PB5
 
 	// ===== UART configuration =====
@@ -59,13 +61,13 @@
 	#define SW_VERSION_HIGH 	1
 	#define SW_VERSION_LOW  	1
 
-	#define TMCM_EEPROM_MAGIC	(uint8_t)0x65	// 101
+	#define TMCM_EEPROM_MAGIC	(uint8_t)0x74	// 116
 
 	#define WEASEL_SPI3_ON_PC10_PC11_PC12
 	#define DRAGON_SPI3_ON_PC10_PC11_PC12
 
-	TMC_LinearRamp rampGenerator[NUMBER_OF_MOTORS];
-	TOSV_Config tosvConfig[NUMBER_OF_MOTORS];
+	extern INSTANCE_STATE TMC_LinearRamp rampGenerator[NUMBER_OF_MOTORS];
+	extern INSTANCE_STATE TOSV_Config tosvConfig[NUMBER_OF_MOTORS];
 
 	#define MIN_CRITICAL_TEMP     	100 //100C
 	#define MAX_CRITICAL_TEMP     	120	//120C
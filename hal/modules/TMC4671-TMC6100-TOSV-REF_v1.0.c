@@ -15,14 +15,26 @@
 const char *VersionString="0020V111";
 
 // ADC configuration
-#define ADC1_DR_ADDRESS    ((uint32_t)0x4001244C)
+#define ADC1_DR_ADDRESS    	((uint32_t)0x4001244C)
 #define ADC1_CHANNELS		4
-static volatile uint16_t ADC1Value[ADC1_CHANNELS];	// array for analog values (filled by DMA)
+#define ADC1_OVERSAMPLING	16		// scans per channel and control tick (TIM3 trigger with 16kHz)
+static INSTANCE_STATE volatile uint16_t ADC1Buffer[2][ADC1_OVERSAMPLING][ADC1_CHANNELS];	// double buffer (filled by DMA)
+static INSTANCE_STATE volatile uint16_t ADC1Value[ADC1_CHANNELS];				// mean value of the last control tick (12 bit)
+static INSTANCE_STATE volatile uint16_t ADC1ValueOversampled[ADC1_CHANNELS];	// sum of the last control tick (16 bit)
+static INSTANCE_STATE volatile uint8_t ADC1SampleReady = false;
+
+void __attribute__ ((interrupt)) DMA1_Channel1_IRQHandler(void);
 
 // ADC1
 uint8_t	ADC_VOLTAGE = 3;
 uint8_t ADC_MOT_TEMP = 4;
 
+// configuration and control state of the module
+INSTANCE_STATE TModuleConfig moduleConfig;
+INSTANCE_STATE TMotorConfig motorConfig[NUMBER_OF_MOTORS];
+INSTANCE_STATE TMC_LinearRamp rampGenerator[NUMBER_OF_MOTORS];
+INSTANCE_STATE TOSV_Config tosvConfig[NUMBER_OF_MOTORS];
+
 void tmcm_initModuleConfig()
 {
 	moduleConfig.baudrate 				= 7; // UART 115200bps
@@ -39,6 +51,14 @@ void tmcm_initMotorConfig()
 	motorConfig[0].maxVelocity 				= 80000;
 	motorConfig[0].acceleration				= 20000;
 	motorConfig[0].maxPressure				= 50000;
+
+	// pressure sensor calibration: former fixed conversion ADC*25000/517-20000 (12 bit ADC)
+	for (int i = 0; i < PRESSURE_CAL_POINTS; i++)
+	{
+		motorConfig[0].pressureCalAdc[i]		= (i * 65535) / (PRESSURE_CAL_POINTS-1);
+		motorConfig[0].pressureCalPressure[i]	= (motorConfig[0].pressureCalAdc[i] * 25000) / (517*16) - 20000;
+	}
+	motorConfig[0].pressureCalOffset		= 0;
 	motorConfig[0].useVelocityRamp			= true;
 	motorConfig[0].openLoopCurrent			= 1000;
 	motorConfig[0].motorType				= TMC4671_THREE_PHASE_BLDC;
@@ -66,6 +86,45 @@ void tmcm_initMotorConfig()
 	motorConfig[0].pidVolume_P_param		= 2000;
 	motorConfig[0].pidVolume_I_param		= 2000;
 
+	motorConfig[0].pidPressure_D_param		= 0;
+	motorConfig[0].pidVolume_D_param		= 0;
+	motorConfig[0].pidPressureSetpointWeight= 256;
+	motorConfig[0].pidVolumeSetpointWeight	= 256;
+	motorConfig[0].pidFlow_P_param			= 30;
+	motorConfig[0].pidFlow_I_param			= 1000;
+	motorConfig[0].pidFlowOutput			= FLOW_OUTPUT_PRESSURE;
+	motorConfig[0].pressureCascade			= PRESSURE_CASCADE_TORQUE;
+	motorConfig[0].pidPressureVelocity_P_param	= 512;
+	motorConfig[0].pidPressureVelocity_I_param	= 4000;
+	motorConfig[0].maxTorqueStep			= 0;
+
+	motorConfig[0].ffEnable					= false;
+	motorConfig[0].ffPressureGain			= 0;
+	motorConfig[0].ffSlopeGain				= 0;
+	motorConfig[0].ffFlowGain				= 0;
+
+	motorConfig[0].ilcEnable				= false;
+	motorConfig[0].ilcGain					= 32000;
+	motorConfig[0].ilcMaxTorque				= 1000;
+
+	motorConfig[0].pidPressureScheduleEnable	= false;
+	motorConfig[0].pidPressureScheduleBlendTime	= 50;
+	for (int i = 0; i < PRESSURE_GAIN_SETS; i++)
+	{
+		motorConfig[0].pidPressureSchedule_P_param[i]	= motorConfig[0].pidPressure_P_param;
+		motorConfig[0].pidPressureSchedule_I_param[i]	= motorConfig[0].pidPressure_I_param;
+	}
+
+	motorConfig[0].autotuneAmplitude		= 300;
+	motorConfig[0].autotuneHysteresis		= 20;
+	motorConfig[0].autotuneSettleTime		= 2000;
+
+	motorConfig[0].pressureSignal			= FEEDBACK_SIGNAL_RAW;
+	motorConfig[0].flowSignal				= FEEDBACK_SIGNAL_PT1;
+	motorConfig[0].estPressureNoiseRatio	= 50;
+	motorConfig[0].estFlowNoiseRatio		= 20;
+	motorConfig[0].estBlowerPressure		= 0;
+
 	motorConfig[0].brakeChopperEnabled		= 0;
 	motorConfig[0].brakeChopperHysteresis	= 5;
 	motorConfig[0].brakeChopperVoltage		= 260;
@@ -83,6 +142,24 @@ void tmcm_initMotorConfig()
 	motorConfig[0].asbEnable                = false;
 	motorConfig[0].asbThreshold             = 500;
 	motorConfig[0].asbVolumeCondition       = 70;
+	motorConfig[0].asbSlopeThreshold        = 0;
+	motorConfig[0].asbTorqueThreshold       = 0;
+	motorConfig[0].asbBlowerInertia         = 17;
+	motorConfig[0].psCycleThreshold         = 25;
+	motorConfig[0].psApneaTime              = 20000;
+	motorConfig[0].prvcMaxStep              = 300;
+	motorConfig[0].flowProfile              = TOSV_FLOW_PROFILE_CONSTANT;
+	motorConfig[0].flowZeroTrackingEnable   = false;
+	motorConfig[0].flowZeroVarianceLimit    = 2500;
+
+	// flow sensor calibration: 1 count = 2 ml/min
+	for (int i = 0; i < FLOW_CAL_POINTS; i++)
+	{
+		motorConfig[0].flowCalCounts[i]		= -32000 + i*8000;
+		motorConfig[0].flowCalFlow[i]		= motorConfig[0].flowCalCounts[i] * 2;
+	}
+	motorConfig[0].flowCalTempRef			= 0;
+	motorConfig[0].flowCalTempCoeff			= 0;
 
 
 	// init ramp generator
@@ -114,6 +191,20 @@ void tmcm_updateConfig()
 	tosvConfig[0].asbEnable 		= motorConfig[0].asbEnable;
 	tosvConfig[0].asbThreshold      = motorConfig[0].asbThreshold;
 	tosvConfig[0].asbVolumeCondition= motorConfig[0].asbVolumeCondition;
+	tosvConfig[0].asbSlopeThreshold = motorConfig[0].asbSlopeThreshold;
+	tosvConfig[0].asbTorqueThreshold= motorConfig[0].asbTorqueThreshold;
+	tosvConfig[0].asbBlowerInertia= motorConfig[0].asbBlowerInertia;
+	tosvConfig[0].psCycleThreshold  = motorConfig[0].psCycleThreshold;
+	tosvConfig[0].psApneaTime       = motorConfig[0].psApneaTime;
+	tosvConfig[0].prvcMaxStep       = motorConfig[0].prvcMaxStep;
+	tosvConfig[0].flowProfile       = motorConfig[0].flowProfile;
+	tosvConfig[0].flowZeroTrackingEnable = motorConfig[0].flowZeroTrackingEnable;
+	tosvConfig[0].flowZeroVarianceLimit  = motorConfig[0].flowZeroVarianceLimit;
+	tosvConfig[0].ilcEnable         = motorConfig[0].ilcEnable;
+	tosvConfig[0].ilcGain           = motorConfig[0].ilcGain;
+	tosvConfig[0].ilcMaxTorque      = motorConfig[0].ilcMaxTorque;
+	tosv_updateConversions(&tosvConfig[0]);
+	tosv_updateFlowCalibration();
 
 	// === configure TMC6200 ===
 	tmc6200_writeInt(DEFAULT_DRV, TMC6200_GCONF, 0);	// normal pwm control
@@ -143,6 +234,18 @@ void tmcm_updateConfig()
 	// hall configuration
 	bldc_updateHallSettings(DEFAULT_MC);
 
+	// pressure sensor calibration
+	bldc_updatePressureCalibration(DEFAULT_MC);
+
+	// cached regulator settings
+	bldc_updateRegulatorSettings(DEFAULT_MC);
+
+	// cached reciprocals
+	bldc_updateConversions(DEFAULT_MC);
+
+	// state estimation
+	bldc_updateEstimatorSettings(DEFAULT_MC);
+
 	// PI configuration
 	tmc4671_setTorqueFluxPI(DEFAULT_MC, motorConfig[0].pidTorque_P_param, motorConfig[0].pidTorque_I_param);
 	tmc4671_setVelocityPI(DEFAULT_MC, motorConfig[0].pidVelocity_P_param, motorConfig[0].pidVelocity_I_param);
@@ -224,19 +327,32 @@ void tmcm_initModuleSpecificIO()
 	GPIO_PinRemapConfig(GPIO_Remap_PD01, DISABLE);  // keep PD0 and PD1 as oscillator inputs
 }
 
+/* The ADC is triggered by TIM3 with 16kHz and converts all channels per trigger. The DMA fills a
+ * double buffer of 2x16 scans in circular mode. Each half is completed once per millisecond and
+ * decimated (boxcar) by the DMA interrupt while the other half is filled.
+ *
+ * TIM3 and the SysTick are both clocked by the 72MHz core clock. TIM3 is started right after a SysTick
+ * tick with its counter preloaded to the period, so the first trigger follows the tick immediately.
+ * The 16th scan of a half is triggered 937.5us after the tick and converted 13.7us later (4 channels
+ * x 41 ADC cycles at 12MHz). The half buffer is completed about 45us before the next control tick
+ * reads it. Without the preload the 16th trigger would coincide with the tick and the half buffer
+ * would be completed about 14us after it.
+ */
 void tmcm_initModuleSpecificADC()
 {
-	// enable clock for ADC and DMA
+	// enable clock for ADC (72MHz / 6 = 12MHz, max. 14MHz), DMA and trigger timer
+	RCC_ADCCLKConfig(RCC_PCLK2_Div6);
 	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_ADC1, ENABLE);
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM3, ENABLE);
 
 	// DMA configuration
 	DMA_InitTypeDef DMAInit;
 	DMA_DeInit(DMA1_Channel1);
 	DMAInit.DMA_PeripheralBaseAddr = ADC1_DR_ADDRESS;
-	DMAInit.DMA_MemoryBaseAddr = (u32)ADC1Value;
+	DMAInit.DMA_MemoryBaseAddr = (u32)ADC1Buffer;
 	DMAInit.DMA_DIR = DMA_DIR_PeripheralSRC;
-	DMAInit.DMA_BufferSize = ADC1_CHANNELS;
+	DMAInit.DMA_BufferSize = 2 * ADC1_OVERSAMPLING * ADC1_CHANNELS;
 	DMAInit.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
 	DMAInit.DMA_MemoryInc = DMA_MemoryInc_Enable;
 	DMAInit.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
@@ -246,6 +362,16 @@ void tmcm_initModuleSpecificADC()
 	DMAInit.DMA_M2M = DMA_M2M_Disable;
 	DMA_Init(DMA1_Channel1, &DMAInit);
 
+	// interrupt on half and full transfer
+	DMA_ITConfig(DMA1_Channel1, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+	NVIC_InitTypeDef NVICInit;
+	NVICInit.NVIC_IRQChannel = DMA1_Channel1_IRQChannel;
+	NVICInit.NVIC_IRQChannelPreemptionPriority = 2;
+	NVICInit.NVIC_IRQChannelSubPriority = 0;
+	NVICInit.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVICInit);
+
 	// enable DMA
 	DMA_Cmd(DMA1_Channel1, ENABLE);
 
@@ -253,8 +379,8 @@ void tmcm_initModuleSpecificADC()
 	ADC_InitTypeDef ADCInit;
 	ADCInit.ADC_Mode = ADC_Mode_Independent;
 	ADCInit.ADC_ScanConvMode = ENABLE;
-	ADCInit.ADC_ContinuousConvMode = ENABLE;
-	ADCInit.ADC_ExternalTrigConv = ADC_ExternalTrigConv_None;
+	ADCInit.ADC_ContinuousConvMode = DISABLE;
+	ADCInit.ADC_ExternalTrigConv = ADC_ExternalTrigConv_T3_TRGO;
 	ADCInit.ADC_DataAlign = ADC_DataAlign_Right;
 	ADCInit.ADC_NbrOfChannel = ADC1_CHANNELS;
 	ADC_Init(ADC1, &ADCInit);
@@ -280,8 +406,60 @@ void tmcm_initModuleSpecificADC()
 	ADC_StartCalibration(ADC1);
 	while(ADC_GetCalibrationStatus(ADC1));
 
-	// start current measurement
-	ADC_SoftwareStartConvCmd(ADC1, ENABLE);
+	// start conversions on trigger
+	ADC_ExternalTrigConvCmd(ADC1, ENABLE);
+
+	// trigger timer: 72MHz / 4500 = 16kHz
+	TIM_TimeBaseInitTypeDef TIMInit;
+	TIM_TimeBaseStructInit(&TIMInit);
+	TIMInit.TIM_Prescaler = 0;
+	TIMInit.TIM_Period = (72000 / ADC1_OVERSAMPLING) - 1;
+	TIMInit.TIM_ClockDivision = TIM_CKD_DIV1;
+	TIMInit.TIM_CounterMode = TIM_CounterMode_Up;
+	TIM_TimeBaseInit(TIM3, &TIMInit);
+	TIM_SelectOutputTrigger(TIM3, TIM_TRGOSource_Update);
+
+	// first update (trigger) with the first timer clock after the start
+	TIM_SetCounter(TIM3, TIMInit.TIM_Period);
+
+	// start synchronously to the control tick
+	uint32_t tick = systick_getTimer();
+	while(systick_getTimer() == tick){;}
+	TIM_Cmd(TIM3, ENABLE);
+}
+
+/* decimate the completed half of the ADC double buffer */
+void DMA1_Channel1_IRQHandler(void)
+{
+	uint8_t half;
+
+	if (DMA_GetITStatus(DMA1_IT_HT1))
+	{
+		half = 0;
+		DMA_ClearITPendingBit(DMA1_IT_HT1);
+	}
+	else if (DMA_GetITStatus(DMA1_IT_TC1))
+	{
+		half = 1;
+		DMA_ClearITPendingBit(DMA1_IT_TC1);
+	}
+	else
+	{
+		DMA_ClearITPendingBit(DMA1_IT_GL1);
+		return;
+	}
+
+	for (int channel = 0; channel < ADC1_CHANNELS; channel++)
+	{
+		uint16_t sum = 0;
+		for (int i = 0; i < ADC1_OVERSAMPLING; i++)
+			sum += ADC1Buffer[half][i][channel];
+
+		ADC1ValueOversampled[channel] = sum;
+		ADC1Value[channel] = sum / ADC1_OVERSAMPLING;
+	}
+
+	ADC1SampleReady = true;
 }
 
 void tmcm_led_run_toggle()
@@ -464,6 +642,34 @@ uint8_t tmcm_getModuleSpecificIOPinStatus(uint8_t pin)
 	return 0;
 }
 
+/* sum of the 16 conversions of the last control tick (ADC_AIN0..ADC_AIN2 and ADC_MOT_TEMP) */
+uint16_t tmcm_getModuleSpecificOversampledADCValue(uint8_t pin)
+{
+	switch(pin)
+	{
+		case 0:
+			return ADC1ValueOversampled[0];  // ADC_AIN0
+		case 1:
+			return ADC1ValueOversampled[1];  // ADC_AIN1
+		case 2:
+			return ADC1ValueOversampled[2];  // ADC_AIN2
+		case 4:
+			return ADC1ValueOversampled[3];  // ADC_MOT_TEMP
+	}
+	return 0;
+}
+
+/* true once per control tick when new decimated ADC values are available */
+uint8_t tmcm_getADCSampleReady()
+{
+	if (ADC1SampleReady)
+	{
+		ADC1SampleReady = false;
+		return true;
+	}
+	return false;
+}
+
 uint16_t tmcm_getModuleSpecificADCValue(uint8_t pin)
 {
 	switch(pin)
@@ -25,6 +25,7 @@
 	#define MAX_CURRENT 				(int32_t)6000		// RMS current
 	#define MAX_PRESSURE				(int32_t)70000
 	#define MAX_VOLUME				    (int32_t)70000
+	#define MAX_FLOW				    (int32_t)300000		// [ml/min]
 
 	#define TMCM_USE_IIC_INTERFACE
 	#define I2C_PRESSURE_SENSOR_SM9333
@@ -55,14 +56,14 @@
 	#define SW_VERSION_HIGH 	1
 	#define SW_VERSION_LOW  	11
 
-	#define TMCM_EEPROM_MAGIC	(uint8_t)0x6E	// 111
+	#define TMCM_EEPROM_MAGIC	(uint8_t)0x7D	// 125
 
 	#define WEASEL_SPI2_ON_PB13_PB14_PB15
 	#define DRAGON_SPI2_ON_PB13_PB14_PB15
 	#define EEPROM_SPI2_ON_PB13_PB14_PB15
 
-	TMC_LinearRamp rampGenerator[NUMBER_OF_MOTORS];
-	TOSV_Config tosvConfig[NUMBER_OF_MOTORS];
+	extern INSTANCE_STATE TMC_LinearRamp rampGenerator[NUMBER_OF_MOTORS];
+	extern INSTANCE_STATE TOSV_Config tosvConfig[NUMBER_OF_MOTORS];
 
 	#define MIN_CRITICAL_TEMP     	100 //100C
 	#define MAX_CRITICAL_TEMP     	120	//120C
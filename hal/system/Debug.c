@@ -7,7 +7,7 @@
 #include "Debug.h"
 
 // test/debug variables
-int32_t gTestVar0, gTestVar1, gTestVar2, gTestVar3, gTestVar4, gTestVar5, gTestVar6, gTestVar7, gTestVar8, gTestVar9;
+INSTANCE_STATE int32_t gTestVar0, gTestVar1, gTestVar2, gTestVar3, gTestVar4, gTestVar5, gTestVar6, gTestVar7, gTestVar8, gTestVar9;
 
 void debug_setTestVar0(int32_t value)
 {
@@ -0,0 +1,188 @@
+/*
+ * Recorder.c
+ *
+ *  Capture of the raw inputs of the control loop for offline replay
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "../Hal_Definitions.h"
+#include "Recorder.h"
+
+#ifndef RECORDER_BUFFER_SIZE
+	#define RECORDER_BUFFER_SIZE	4096	// [byte] header (about 1 kB) and about 300 ms of control ticks
+#endif
+
+#define RECORDER_MAX_INPUT_SIZE		5		// varint of 32 bit
+
+INSTANCE_STATE uint8_t recorderBuffer[RECORDER_BUFFER_SIZE];
+INSTANCE_STATE uint32_t recorderLength = 0;
+INSTANCE_STATE uint32_t recorderEntryStart = 0;		// start of the actual entry
+INSTANCE_STATE uint32_t recorderTicks = 0;
+INSTANCE_STATE uint8_t recorderState = RECORDER_STATE_IDLE;
+INSTANCE_STATE int32_t recorderLastInput[RECORDER_INPUTS];
+INSTANCE_STATE uint32_t recorderStateSize = 0;
+
+/* check the free space for the actual entry, an entry not fitting anymore is dropped */
+bool recorder_reserve(uint32_t size)
+{
+	if (recorderLength + size <= RECORDER_BUFFER_SIZE)
+		return true;
+
+	recorderLength = recorderEntryStart;
+	recorderState = RECORDER_STATE_FULL;
+	return false;
+}
+
+/* zigzag varint: small values of both signs give short codes */
+void recorder_writeValue(int32_t value)
+{
+	uint32_t code = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+
+	while (code >= 0x80)
+	{
+		recorderBuffer[recorderLength++] = (code & 0x7F) | 0x80;
+		code >>= 7;
+	}
+	recorderBuffer[recorderLength++] = code;
+}
+
+void recorder_countState(void *data, uint32_t size)
+{
+	recorderStateSize += size;
+}
+
+/* one block of the state as 32 bit words */
+void recorder_writeState(void *data, uint32_t size)
+{
+	for (uint32_t i = 0; i < size; i += 4)
+	{
+		if ((recorderState != RECORDER_STATE_RECORDING) || !recorder_reserve(RECORDER_MAX_INPUT_SIZE))
+			return;
+
+		uint32_t word = 0;
+		for (uint32_t j = 0; (j < 4) && (i+j < size); j++)
+			word |= (uint32_t)((uint8_t *)data)[i+j] << (8*j);
+
+		recorder_writeValue(word);
+	}
+}
+
+/* start a new recording with the state of walkState() in its header */
+void recorder_start(Recorder_StateWalker walkState)
+{
+	for (int i = 0; i < RECORDER_INPUTS; i++)
+		recorderLastInput[i] = 0;
+
+	recorderLength = 0;
+	recorderEntryStart = 0;
+	recorderTicks = 0;
+	recorderState = RECORDER_STATE_RECORDING;
+
+	recorderStateSize = 0;
+	walkState(recorder_countState);
+
+	if (recorder_reserve(3 + RECORDER_MAX_INPUT_SIZE))
+	{
+		recorderBuffer[recorderLength++] = RECORDER_ENTRY_HEADER;
+		recorderBuffer[recorderLength++] = RECORDER_VERSION;
+		recorderBuffer[recorderLength++] = NUMBER_OF_MOTORS;
+		recorder_writeValue(recorderStateSize);
+		walkState(recorder_writeState);
+	}
+
+	// a recording without complete header is empty
+	if (recorderState == RECORDER_STATE_FULL)
+		recorderLength = 0;
+}
+
+void recorder_stop()
+{
+	if (recorderState == RECORDER_STATE_RECORDING)
+		recorderState = RECORDER_STATE_STOPPED;
+}
+
+uint8_t recorder_getState()
+{
+	return recorderState;
+}
+
+uint32_t recorder_getLength()
+{
+	return recorderLength;
+}
+
+uint32_t recorder_getTicks()
+{
+	return recorderTicks;
+}
+
+/* read 4 byte of the stream (big endian like the TMCL value), returns false if index is out of the recording */
+bool recorder_read(uint32_t index, int32_t *value)
+{
+	if ((recorderState == RECORDER_STATE_RECORDING) || (index >= recorderLength))
+		return false;
+
+	uint32_t data = 0;
+	for (uint32_t i = index; i < index+4; i++)
+		data = (data << 8) | ((i < recorderLength) ? recorderBuffer[i] : 0);
+
+	*value = data;
+	return true;
+}
+
+void recorder_beginTick()
+{
+	if (recorderState != RECORDER_STATE_RECORDING)
+		return;
+
+	recorderEntryStart = recorderLength;
+	if (recorder_reserve(1))
+	{
+		recorderBuffer[recorderLength++] = RECORDER_ENTRY_TICK;
+		recorderTicks++;
+	}
+}
+
+void recorder_setTickFlag(uint8_t flag)
+{
+	if (recorderState != RECORDER_STATE_RECORDING)
+		return;
+
+	recorderBuffer[recorderEntryStart] |= flag;
+}
+
+void recorder_addInput(uint8_t input, int32_t value)
+{
+	if (recorderState != RECORDER_STATE_RECORDING)
+		return;
+
+	if (!recorder_reserve(RECORDER_MAX_INPUT_SIZE))
+	{
+		// the incomplete tick has been dropped
+		recorderTicks--;
+		return;
+	}
+
+	recorder_writeValue(value - recorderLastInput[input]);
+	recorderLastInput[input] = value;
+}
+
+void recorder_addCommand(uint8_t opcode, uint8_t type, uint8_t motor, int32_t value)
+{
+	if (recorderState != RECORDER_STATE_RECORDING)
+		return;
+
+	recorderEntryStart = recorderLength;
+	if (!recorder_reserve(8))
+		return;
+
+	recorderBuffer[recorderLength++] = RECORDER_ENTRY_COMMAND;
+	recorderBuffer[recorderLength++] = opcode;
+	recorderBuffer[recorderLength++] = type;
+	recorderBuffer[recorderLength++] = motor;
+	recorderBuffer[recorderLength++] = value >> 24;
+	recorderBuffer[recorderLength++] = value >> 16;
+	recorderBuffer[recorderLength++] = value >> 8;
+	recorderBuffer[recorderLength++] = value;
+}
@@ -0,0 +1,74 @@
+/*
+ * Recorder.h
+ *
+ *  Capture of the raw inputs of the control loop for offline replay
+ *
+ *  Stream format: a sequence of entries, each starting with one type byte.
+ *      header entry:  RECORDER_ENTRY_HEADER, version, number of motors, size of the state [byte] and
+ *                     the state at the start of the recording (the EEPROM and RAM configuration and
+ *                     the controller state, see tmcl_visitState())
+ *      tick entry:    RECORDER_ENTRY_TICK | flags, followed by the inputs in the order the control
+ *                     loop consumed them in this tick
+ *      command entry: RECORDER_ENTRY_COMMAND, followed by opcode, type, motor and value (big endian)
+ *
+ *  Each input is stored as zigzag varint of the difference to the previous value of the same input
+ *  (7 bits per byte, lsb first, bit 7 set if another byte follows). A replay running the same
+ *  firmware sources consumes the inputs in the same order, so the stream needs no input ids.
+ *  The state of the header is stored as zigzag varints of its 32 bit words (little endian, the
+ *  last word of a block filled up with zeros). A replay needs the same memory layout of the state,
+ *  checked with its size.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+	#include "TMC-API/tmc/helpers/API_Header.h"
+
+	// recorder states
+	#define RECORDER_STATE_IDLE				0
+	#define RECORDER_STATE_RECORDING		1
+	#define RECORDER_STATE_STOPPED			2
+	#define RECORDER_STATE_FULL				3	// stopped at the last complete entry
+
+	#define RECORDER_VERSION				1
+
+	// entry types
+	#define RECORDER_ENTRY_TICK				0x00
+	#define RECORDER_ENTRY_HEADER			0x40
+	#define RECORDER_ENTRY_COMMAND			0x80
+
+	// tick flags
+	#define RECORDER_TICK_PRESSURE_SAMPLE	0x01	// new ADC sample ready, pressure ADC values follow
+	#define RECORDER_TICK_FLOW_SAMPLE		0x02	// flow sensor read, SM9333 values follow
+
+	// inputs (shared sensors, then 4 per axis)
+	#define RECORDER_INPUT_SUPPLY_ADC			0
+	#define RECORDER_INPUT_TEMPERATURE_ADC		1
+	#define RECORDER_INPUT_FLOW_TEMPERATURE		2
+	#define RECORDER_INPUT_FLOW_PRESSURE		3
+	#define RECORDER_INPUT_FLOW_STATUS			4
+	#define RECORDER_INPUT_VELOCITY(motor)		(5+4*(motor))	// TMC4671 PID_VELOCITY_ACTUAL
+	#define RECORDER_INPUT_TORQUE(motor)		(6+4*(motor))	// TMC4671 PID_TORQUE_FLUX_ACTUAL (upper half)
+	#define RECORDER_INPUT_FLUX(motor)			(7+4*(motor))	// TMC4671 PID_TORQUE_FLUX_ACTUAL (lower half)
+	#define RECORDER_INPUT_PRESSURE_ADC(motor)	(8+4*(motor))
+	#define RECORDER_INPUTS						(5+4*NUMBER_OF_MOTORS)
+
+	// called for every block of the state, in the same order for the recording and the replay
+	typedef void (*Recorder_StateVisitor)(void *data, uint32_t size);
+	typedef void (*Recorder_StateWalker)(Recorder_StateVisitor visit);
+
+	void recorder_start(Recorder_StateWalker walkState);
+	void recorder_stop();
+	uint8_t recorder_getState();
+	uint32_t recorder_getLength();
+	uint32_t recorder_getTicks();
+	bool recorder_read(uint32_t index, int32_t *value);
+
+	void recorder_beginTick();
+	void recorder_setTickFlag(uint8_t flag);
+	void recorder_addInput(uint8_t input, int32_t value);
+	void recorder_addCommand(uint8_t opcode, uint8_t type, uint8_t motor, int32_t value);
+
+#endif /* RECORDER_H */
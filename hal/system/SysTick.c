@@ -7,8 +7,8 @@
 
 #include "SysTick.h"
 
-static volatile uint32_t sysTickTimer = 0;
-static volatile uint8_t sysTickDivFlag = 0;
+static INSTANCE_STATE volatile uint32_t sysTickTimer = 0;
+static INSTANCE_STATE volatile uint8_t sysTickDivFlag = 0;
 
 #ifdef USE_UART_INTERFACE
 	#include "../comm/UART.h"
@@ -54,7 +54,9 @@ void SysTick_Handler(void)
 /* initialize SysTick timer */
 void systick_init()
 {
-#if BOARD_CPU == STM32F103
+#if defined(HOST_SIMULATION)
+	// SysTickHandler() is called by the host simulation every 500usec of simulated time
+#elif BOARD_CPU == STM32F103
 	/* Select AHB clock(HCLK) as SysTick clock source */
 	SysTick_CLKSourceConfig(SysTick_CLKSource_HCLK);
 	/* SysTick interrupt each 500usec with Core clock equal to 72MHz */
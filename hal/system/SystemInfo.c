@@ -6,16 +6,36 @@
  */
 #include "SystemInfo.h"
 
-uint32_t loopCounterCheckTime 	= 0;
+#ifdef HOST_SIMULATION
+	#include <time.h>
+#endif
 
-uint32_t mainLoopCounter 		= 0;
-uint32_t mainLoopsPerSecond	 	= 0;
+INSTANCE_STATE uint32_t loopCounterCheckTime 	= 0;
 
-uint32_t velocityLoopCounter 	= 0;
-uint32_t velocityLoopsPerSecond	= 0;
+INSTANCE_STATE uint32_t mainLoopCounter 		= 0;
+INSTANCE_STATE uint32_t mainLoopsPerSecond	 	= 0;
 
-uint32_t commLoopCounter 		= 0;
-uint32_t commLoopsPerSecond		= 0;
+INSTANCE_STATE uint32_t velocityLoopCounter 	= 0;
+INSTANCE_STATE uint32_t velocityLoopsPerSecond	= 0;
+
+INSTANCE_STATE uint32_t commLoopCounter 		= 0;
+INSTANCE_STATE uint32_t commLoopsPerSecond		= 0;
+
+#ifdef HOST_SIMULATION
+	// host simulation: nanoseconds of the monotonic clock instead of cpu cycles
+	#define DWT_CYCCNT			systemInfo_getHostNanoseconds()
+#else
+	// Cortex-M3 DWT cycle counter (not covered by the StdPeriph library)
+	#define DEMCR				(*(volatile uint32_t *)0xE000EDFC)
+	#define DEMCR_TRCENA		(1 << 24)
+	#define DWT_CTRL			(*(volatile uint32_t *)0xE0001000)
+	#define DWT_CTRL_CYCCNTENA	(1 << 0)
+	#define DWT_CYCCNT			(*(volatile uint32_t *)0xE0001004)
+#endif
+
+INSTANCE_STATE uint32_t cycleCounterStart		= 0;
+INSTANCE_STATE uint32_t cycles					= 0;
+INSTANCE_STATE uint32_t maxCycles				= 0;
 
 void systemInfo_update(uint32_t actualSystick)
 {
@@ -76,3 +96,56 @@ uint32_t systemInfo_getCommunicationsPerSecond()
 {
 	return commLoopsPerSecond;
 }
+
+#ifdef HOST_SIMULATION
+uint32_t systemInfo_getHostNanoseconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)now.tv_sec * 1000000000u + (uint32_t)now.tv_nsec;
+}
+#endif
+
+void systemInfo_initCycleCounter()
+{
+#ifndef HOST_SIMULATION
+	DEMCR |= DEMCR_TRCENA;
+	DWT_CYCCNT = 0;
+	DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+#endif
+}
+
+void systemInfo_startCycleMeasurement()
+{
+	cycleCounterStart = DWT_CYCCNT;
+}
+
+void systemInfo_stopCycleMeasurement()
+{
+	cycles = DWT_CYCCNT - cycleCounterStart;
+	if (cycles > maxCycles)
+		maxCycles = cycles;
+}
+
+/* cpu cycles of the last measurement */
+uint32_t systemInfo_getCycles()
+{
+	return cycles;
+}
+
+/* max. cpu cycles since start or last reset */
+uint32_t systemInfo_getMaxCycles()
+{
+	return maxCycles;
+}
+
+void systemInfo_resetMaxCycles()
+{
+	maxCycles = 0;
+}
+
+/* free running cpu cycle counter */
+uint32_t systemInfo_getCycleCounter()
+{
+	return DWT_CYCCNT;
+}
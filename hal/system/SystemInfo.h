@@ -23,4 +23,12 @@
 	void systemInfo_incCommunicationLoopCounter();
 	uint32_t systemInfo_getCommunicationsPerSecond();
 
+	void systemInfo_initCycleCounter();
+	void systemInfo_startCycleMeasurement();
+	void systemInfo_stopCycleMeasurement();
+	uint32_t systemInfo_getCycles();
+	uint32_t systemInfo_getMaxCycles();
+	void systemInfo_resetMaxCycles();
+	uint32_t systemInfo_getCycleCounter();
+
 #endif /* SYSTEM_INFO_H */
@@ -30,6 +30,9 @@
 	#define TMCL_RSGP 						12
 	#define TMCL_SIO 						14
 	#define TMCL_GIO 						15
+	#define TMCL_Autotune					64
+	#define TMCL_Recorder					65
+	#define TMCL_Benchmark					66
 	#define TMCL_GetVersion 				136
 	#define TMCL_FactoryDefault 			137
 	#define TMCL_writeRegisterChannel_1		146
@@ -11,11 +11,11 @@
 	#include "../Hal_Definitions.h"
 	#include "TMCL-Defines.h"
 
-	uint8_t TMCLReplyFormat;
-	uint8_t SpecialReply[9];
-	uint8_t TMCLSuppressReply;
+	INSTANCE_STATE uint8_t TMCLReplyFormat;
+	INSTANCE_STATE uint8_t SpecialReply[9];
+	INSTANCE_STATE uint8_t TMCLSuppressReply;
 
-	TTMCLCommand ActualCommand;
-	TTMCLReply ActualReply;
+	INSTANCE_STATE TTMCLCommand ActualCommand;
+	INSTANCE_STATE TTMCLReply ActualReply;
 
 #endif /* TMCL_VARIABLES_H */
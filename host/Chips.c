@@ -0,0 +1,283 @@
+/*
+ * Chips.c
+ *
+ *  Emulation of the ICs of the TOSV reference board for the host simulation. The emulation sits
+ *  behind the SPI and I2C functions of the hal (replacing hal/comm/SPI.c and hal/comm/I2C.c), so the
+ *  TMC-API, the EEPROM driver and the flow sensor readout of the firmware run unchanged.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Chips.h"
+#include "hal/comm/SPI.h"
+#include "hal/comm/I2C.h"
+
+#define SM9333_I2C_ADDRESS		0xD8
+#define SM9333_REG_DSP_T		0x2E
+#define EEPROM_SIZE				16384	// AT25128
+
+INSTANCE_STATE TMC4671_Emulation tmc4671Emulation[NUMBER_OF_MOTORS];
+INSTANCE_STATE SM9333_Emulation sm9333Emulation;
+
+// SPI datagram of the TMC4671/TMC6200: address (bit 7: write) and 4 data bytes, MSB first
+typedef struct
+{
+	uint8_t count;
+	uint8_t address;
+	uint32_t data;
+} SPI_Datagram;
+
+static INSTANCE_STATE SPI_Datagram tmc4671Datagram[NUMBER_OF_MOTORS];
+static INSTANCE_STATE SPI_Datagram tmc6200Datagram[NUMBER_OF_MOTORS];
+static INSTANCE_STATE int32_t tmc6200Registers[NUMBER_OF_MOTORS][128];
+
+// SPI EEPROM: command, address and data transfer until the chip select is released
+static INSTANCE_STATE uint8_t eeprom[EEPROM_SIZE];
+static INSTANCE_STATE uint8_t eepromCommand;
+static INSTANCE_STATE uint32_t eepromCount;
+static INSTANCE_STATE uint16_t eepromAddress;
+static INSTANCE_STATE bool eepromWriteEnabled;
+
+static INSTANCE_STATE uint8_t sm9333Register;
+
+void chips_init()
+{
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+	{
+		for (int i = 0; i < 128; i++)
+		{
+			tmc4671Emulation[motor].registers[i] = 0;
+			tmc6200Registers[motor][i] = 0;
+		}
+		tmc4671Emulation[motor].torque = 0;
+		tmc4671Emulation[motor].velocity = 0;
+		tmc4671Emulation[motor].velocityErrorSum = 0;
+		tmc4671Emulation[motor].replay = false;
+		tmc4671Datagram[motor].count = 0;
+		tmc6200Datagram[motor].count = 0;
+		chips_setSupplyVoltage(motor, 240);
+	}
+
+	// erased EEPROM
+	for (int i = 0; i < EEPROM_SIZE; i++)
+		eeprom[i] = 0xFF;
+	eepromCount = 0;
+	eepromWriteEnabled = false;
+
+	sm9333Emulation.temperature = 0;
+	sm9333Emulation.pressure = 0;
+	sm9333Emulation.status = 0;
+	sm9333Emulation.present = true;
+	sm9333Register = 0;
+}
+
+/* supply voltage [0.1V] measured by the TMC4671 */
+void chips_setSupplyVoltage(uint8_t motor, int32_t voltage)
+{
+	tmc4671Emulation[motor].registers[TMC4671_ADC_RAW_DATA] = (uint16_t)(VOLTAGE_OFFSET + (voltage * 4095) / VOLTAGE_FAKTOR);
+}
+
+// ===== TMC4671 =====
+
+int32_t chips_readTMC4671(uint8_t motor, uint8_t address)
+{
+	TMC4671_Emulation *chip = &tmc4671Emulation[motor];
+	int32_t polePairs = chip->registers[TMC4671_MOTOR_TYPE_N_POLE_PAIRS] & 0xFF;
+	int32_t dualShuntFactor = motorConfig[motor].dualShuntFactor;
+
+	if (chip->replay && ((address == TMC4671_PID_VELOCITY_ACTUAL) || (address == TMC4671_PID_TORQUE_FLUX_ACTUAL)))
+		return chip->registers[address];
+
+	switch(address)
+	{
+		case TMC4671_PID_VELOCITY_ACTUAL:
+			return (int32_t)chip->velocity * polePairs;
+		case TMC4671_PID_TORQUE_FLUX_ACTUAL:
+			return (int32_t)((uint32_t)(int16_t)(chip->torque * 256 / dualShuntFactor) << 16);
+		case TMC4671_ADC_RAW_DATA:
+			// only the supply voltage (ADC_RAW_ADDR 1) is emulated
+			return (chip->registers[TMC4671_ADC_RAW_ADDR] == 1) ? chip->registers[TMC4671_ADC_RAW_DATA] : 0;
+	}
+	return chip->registers[address & 0x7F];
+}
+
+/* inner loops of the TMC4671: ideal torque loop, velocity PI with the register gains */
+void chips_updateTMC4671(uint8_t motor, double dt)
+{
+	TMC4671_Emulation *chip = &tmc4671Emulation[motor];
+	int32_t polePairs = chip->registers[TMC4671_MOTOR_TYPE_N_POLE_PAIRS] & 0xFF;
+	double torqueScale = motorConfig[motor].dualShuntFactor / 256.0;
+	double limit = chip->registers[TMC4671_PID_TORQUE_FLUX_LIMITS] * torqueScale;
+	double target = 0;
+
+	switch(chip->registers[TMC4671_MODE_RAMP_MODE_MOTION] & 0xFF)
+	{
+		case TMC4671_MOTION_MODE_TORQUE:
+			target = (int16_t)(chip->registers[TMC4671_PID_TORQUE_FLUX_TARGET] >> 16) * torqueScale;
+			break;
+		case TMC4671_MOTION_MODE_VELOCITY:
+			{
+				// P in q8.8, I in q0.16 per 100us, error in electrical rpm, output in raw torque
+				uint32_t gains = chip->registers[TMC4671_PID_VELOCITY_P_VELOCITY_I];
+				double error = chip->registers[TMC4671_PID_VELOCITY_TARGET] - chip->velocity * polePairs;
+				chip->velocityErrorSum += error * (gains & 0xFFFF) / 65536.0 * (dt / 100e-6);
+				if (chip->velocityErrorSum > limit / torqueScale)
+					chip->velocityErrorSum = limit / torqueScale;
+				else if (chip->velocityErrorSum < -limit / torqueScale)
+					chip->velocityErrorSum = -limit / torqueScale;
+				target = (error * (gains >> 16) / 256.0 + chip->velocityErrorSum) * torqueScale;
+			}
+			break;
+		default:
+			chip->velocityErrorSum = 0;
+			break;
+	}
+
+	if (!tmcm_getDriverState(motor))
+		target = 0;
+
+	if (target > limit)
+		target = limit;
+	else if (target < -limit)
+		target = -limit;
+
+	chip->torque = target;
+}
+
+uint8_t weasel_spi_readWriteByte(uint8_t motor, uint8_t data, uint8_t lastTransfer)
+{
+	SPI_Datagram *datagram = &tmc4671Datagram[motor];
+	uint8_t reply = 0;
+
+	if (datagram->count == 0)
+	{
+		datagram->address = data;
+		datagram->data = (data & 0x80) ? 0 : (uint32_t)chips_readTMC4671(motor, data & 0x7F);
+	}
+	else
+	{
+		reply = datagram->data >> 24;
+		datagram->data = (datagram->data << 8) | data;
+	}
+	datagram->count++;
+
+	if (lastTransfer)
+	{
+		if ((datagram->count == 5) && (datagram->address & 0x80))
+			tmc4671Emulation[motor].registers[datagram->address & 0x7F] = datagram->data;
+		datagram->count = 0;
+	}
+	return reply;
+}
+
+// ===== TMC6200 =====
+
+uint8_t dragon_spi_readWriteByte(uint8_t motor, uint8_t data, uint8_t lastTransfer)
+{
+	SPI_Datagram *datagram = &tmc6200Datagram[motor];
+	uint8_t reply = 0;
+
+	if (datagram->count == 0)
+	{
+		datagram->address = data;
+		datagram->data = (data & 0x80) ? 0 : (uint32_t)tmc6200Registers[motor][data & 0x7F];
+	}
+	else
+	{
+		reply = datagram->data >> 24;
+		datagram->data = (datagram->data << 8) | data;
+	}
+	datagram->count++;
+
+	if (lastTransfer)
+	{
+		if ((datagram->count == 5) && (datagram->address & 0x80))
+			tmc6200Registers[motor][datagram->address & 0x7F] = datagram->data;
+		datagram->count = 0;
+	}
+	return reply;
+}
+
+// ===== SPI EEPROM (AT25128) =====
+
+uint8_t eeprom_spi_readWriteByte(uint8_t data, uint8_t lastTransfer)
+{
+	uint8_t reply = 0;
+
+	if (eepromCount == 0)
+	{
+		eepromCommand = data;
+		if (data == 0x06)		// write enable
+			eepromWriteEnabled = true;
+	}
+	else if ((eepromCommand == 0x05) && (eepromCount == 1))	// status: write enable latch, never busy
+	{
+		reply = eepromWriteEnabled ? 0x02 : 0x00;
+	}
+	else if ((eepromCommand == 0x03) || (eepromCommand == 0x02))
+	{
+		if (eepromCount == 1)
+		{
+			eepromAddress = data << 8;
+		}
+		else if (eepromCount == 2)
+		{
+			eepromAddress |= data;
+		}
+		else if (eepromCommand == 0x03)
+		{
+			// read with address increment over the whole memory
+			reply = eeprom[eepromAddress % EEPROM_SIZE];
+			eepromAddress++;
+		}
+		else if (eepromWriteEnabled)
+		{
+			// write with address increment within the 64 byte page
+			eeprom[eepromAddress % EEPROM_SIZE] = data;
+			eepromAddress = (eepromAddress & ~0x3F) | ((eepromAddress + 1) & 0x3F);
+		}
+	}
+	eepromCount++;
+
+	if (lastTransfer)
+	{
+		if (eepromCommand == 0x02)
+			eepromWriteEnabled = false;
+		eepromCount = 0;
+	}
+	return reply;
+}
+
+void spi_init()
+{
+}
+
+// ===== SM9333 on I2C =====
+
+void InitIIC(void)
+{
+}
+
+uint8_t I2C_Master_BufferWrite(I2C_TypeDef* I2Cx, u8* pBuffer, u32 NumByteToWrite, u8 SlaveAddress)
+{
+	if ((SlaveAddress != SM9333_I2C_ADDRESS) || !sm9333Emulation.present || (NumByteToWrite < 1))
+		return false;
+
+	sm9333Register = pBuffer[0];
+	return true;
+}
+
+/* burst read from DSP_T: temperature, pressure and status (little endian words) */
+uint8_t I2C_Master_BufferRead(I2C_TypeDef* I2Cx, u8* pBuffer, u32 NumByteToRead, u8 SlaveAddress)
+{
+	if ((SlaveAddress != SM9333_I2C_ADDRESS) || !sm9333Emulation.present || (sm9333Register != SM9333_REG_DSP_T))
+		return false;
+
+	uint16_t words[3] = { sm9333Emulation.temperature, sm9333Emulation.pressure, sm9333Emulation.status };
+	for (u32 i = 0; i < NumByteToRead; i++)
+		pBuffer[i] = (i < 6) ? (words[i/2] >> (8 * (i%2))) : 0;
+
+	// the update flag is cleared by reading the status
+	sm9333Emulation.status &= ~0x0008;
+	return true;
+}
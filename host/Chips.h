@@ -0,0 +1,40 @@
+/*
+ * Chips.h
+ *
+ *  Emulation of the ICs of the TOSV reference board for the host simulation
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef CHIPS_H
+#define CHIPS_H
+
+	#include "hal/Hal_Definitions.h"
+
+	// TMC4671 with ideal current loop and the velocity PI of the chip
+	typedef struct
+	{
+		int32_t registers[128];
+		double torque;				// actual torque current [mA]
+		double velocity;			// actual mechanical speed [rpm] (set by the plant)
+		double velocityErrorSum;
+		bool replay;				// actual velocity and torque/flux are read from the registers (set by the replay)
+	} TMC4671_Emulation;
+
+	// SM9333 differential pressure sensor of the flow sensor
+	typedef struct
+	{
+		int16_t temperature;		// raw temperature
+		int16_t pressure;			// raw pressure [counts]
+		uint16_t status;			// DSP_S updated, error flags
+		bool present;
+	} SM9333_Emulation;
+
+	extern INSTANCE_STATE TMC4671_Emulation tmc4671Emulation[NUMBER_OF_MOTORS];
+	extern INSTANCE_STATE SM9333_Emulation sm9333Emulation;
+
+	void chips_init();
+	void chips_setSupplyVoltage(uint8_t motor, int32_t voltage);
+	void chips_updateTMC4671(uint8_t motor, double dt);
+
+#endif /* CHIPS_H */
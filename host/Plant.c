@@ -0,0 +1,215 @@
+/*
+ * Plant.c
+ *
+ *  Blowers, patient circuit and lung for the host simulation.
+ *
+ *  Each blower builds up a static pressure proportional to its speed squared and is loaded by a fan
+ *  torque that rises with speed and flow. Axis 0 feeds the patient circuit: the blower flow passes
+ *  the tubing into the wye, where the exhalation port leaks to atmosphere and the patient is
+ *  connected through the airway resistance to a lung compliance. A spontaneously breathing patient
+ *  lowers the alveolar pressure by the muscle pressure of its efforts. Further axes blow into their
+ *  own leak (e.g. a PEEP blower). The pressure sensor of an axis sits at the wye, the flow sensor
+ *  measures the patient flow including a leak at the patient (e.g. the mask).
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <math.h>
+#include "Plant.h"
+#include "Chips.h"
+
+#define PLANT_STEPS			10		// sub steps per control tick
+#define PLANT_STEP_TIME		(0.001 / PLANT_STEPS)
+
+#define SM9333_STATUS_DSP_S_UPDATED		0x0008
+
+INSTANCE_STATE Plant_Blower plantBlower[NUMBER_OF_MOTORS];
+INSTANCE_STATE Plant_Patient plantPatient;
+INSTANCE_STATE Plant_BlowerState plantBlowerState[NUMBER_OF_MOTORS];
+INSTANCE_STATE Plant_PatientState plantPatientState;
+
+static INSTANCE_STATE uint32_t effortRandom;
+static INSTANCE_STATE uint32_t noiseRandom;
+static INSTANCE_STATE uint32_t nextEffort;
+
+void plant_init()
+{
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+	{
+		// about 6 kPa at 40000 rpm, 2.2 A load at 38000 rpm against the leak
+		plantBlower[motor].pressureGain		= 4.0e-6;
+		plantBlower[motor].loadGain			= 9.4e-7;
+		plantBlower[motor].flowLoadGain		= 1.5e-5;
+		plantBlower[motor].friction			= 50;
+		plantBlower[motor].acceleration		= 60;
+		plantBlower[motor].resistance		= 0.5;
+		plantBlower[motor].leakResistance	= 5.0;
+
+		plantBlowerState[motor].velocity	= 0;
+		plantBlowerState[motor].pressure	= 0;
+		plantBlowerState[motor].flow		= 0;
+		plantBlowerState[motor].loadTorque	= 0;
+	}
+
+	// R 10 cmH2O/(l/s), C 50 ml/cmH2O, passive
+	plantPatient.resistance			= 0.98;
+	plantPatient.compliance			= 0.51;
+	plantPatient.leakResistance		= 0;
+	plantPatient.effortAmplitude	= 0;
+	plantPatient.effortRiseTime		= 300;
+	plantPatient.effortRelaxTime	= 400;
+	plantPatient.effortPeriod		= 4000;
+	plantPatient.effortVariation	= 0;
+	plantPatient.effortStrengthVariation = 0;
+	plantPatient.effortSeed			= 1;
+	plantPatient.flowOffset			= 0;
+	plantPatient.pressureNoise		= 0;
+	plantPatient.flowNoise			= 0;
+	plantPatient.noiseSeed			= 1;
+
+	plantPatientState.volume			= 0;
+	plantPatientState.flow				= 0;
+	plantPatientState.leakFlow			= 0;
+	plantPatientState.alveolarPressure	= 0;
+	plantPatientState.musclePressure	= 0;
+	plantPatientState.efforts			= 0;
+	plantPatientState.effortStart		= 0;
+	plantPatientState.effortAmplitude	= 0;
+
+	effortRandom = 0;
+	noiseRandom = 0;
+	nextEffort = 0;
+}
+
+/* uniform random number in [0, 1) */
+double plant_random(uint32_t *state)
+{
+	*state = *state * 1664525u + 1013904223u;
+	return (*state >> 8) / 16777216.0;
+}
+
+/* normal distributed random number (Box-Muller) */
+double plant_gaussian(uint32_t *state)
+{
+	double u1 = plant_random(state);
+	double u2 = plant_random(state);
+	return sqrt(-2.0 * log(1.0 - u1)) * cos(2.0 * M_PI * u2);
+}
+
+/* muscle pressure of the patient efforts at time [ms] */
+double plant_updateMusclePressure(uint32_t time)
+{
+	Plant_Patient *patient = &plantPatient;
+	Plant_PatientState *state = &plantPatientState;
+
+	if (patient->effortAmplitude <= 0)
+		return 0;
+
+	// first effort after one period, random variation of the following periods
+	if (nextEffort == 0)
+	{
+		effortRandom = patient->effortSeed;
+		nextEffort = time + patient->effortPeriod;
+	}
+
+	if (time >= nextEffort)
+	{
+		state->efforts++;
+		state->effortStart = time;
+
+		double variation = patient->effortVariation / 100.0 * (2.0 * plant_random(&effortRandom) - 1.0);
+		nextEffort = time + patient->effortPeriod * (1.0 + variation);
+		state->effortAmplitude = patient->effortAmplitude;
+		if (patient->effortStrengthVariation > 0)
+			state->effortAmplitude *= 1.0 - patient->effortStrengthVariation / 100.0 * plant_random(&effortRandom);
+	}
+
+	if (state->efforts == 0)
+		return 0;
+
+	double t = time - state->effortStart;
+	if (t < patient->effortRiseTime)
+		return -state->effortAmplitude * (1.0 - cos(M_PI * t / patient->effortRiseTime)) / 2;
+
+	t -= patient->effortRiseTime;
+	if (t < patient->effortRelaxTime)
+		return -state->effortAmplitude * (1.0 + cos(M_PI * t / patient->effortRelaxTime)) / 2;
+
+	return 0;
+}
+
+/* advance the plant by one control tick (time [ms] at the end of the tick) */
+void plant_step(uint32_t time)
+{
+	Plant_PatientState *patient = &plantPatientState;
+
+	patient->musclePressure = plant_updateMusclePressure(time);
+
+	for (int step = 0; step < PLANT_STEPS; step++)
+	{
+		for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+		{
+			Plant_Blower *blower = &plantBlower[motor];
+			Plant_BlowerState *state = &plantBlowerState[motor];
+
+			chips_updateTMC4671(motor, PLANT_STEP_TIME);
+
+			double staticPressure = blower->pressureGain * state->velocity * state->velocity;
+			if (motor == 0)
+			{
+				// wye pressure from the flow balance of blower, leaks and patient
+				double leakConductance = (plantPatient.leakResistance > 0) ? 1.0 / plantPatient.leakResistance : 0;
+				patient->alveolarPressure = patient->volume / plantPatient.compliance + patient->musclePressure;
+				state->pressure = (staticPressure / blower->resistance + patient->alveolarPressure / plantPatient.resistance)
+						/ (1.0 / blower->resistance + 1.0 / blower->leakResistance + leakConductance + 1.0 / plantPatient.resistance);
+				patient->flow = (state->pressure - patient->alveolarPressure) / plantPatient.resistance;
+				patient->leakFlow = state->pressure * leakConductance;
+				patient->volume += patient->flow * PLANT_STEP_TIME;
+			}
+			else
+			{
+				state->pressure = staticPressure * blower->leakResistance / (blower->resistance + blower->leakResistance);
+			}
+			state->flow = (staticPressure - state->pressure) / blower->resistance;
+
+			// fan load
+			state->loadTorque = blower->loadGain * state->velocity * state->velocity
+					+ blower->flowLoadGain * state->velocity * fmax(state->flow, 0)
+					+ ((state->velocity > 0) ? blower->friction : 0);
+
+			state->velocity += blower->acceleration * (tmc4671Emulation[motor].torque - state->loadTorque) * PLANT_STEP_TIME;
+			if (state->velocity < 0)
+				state->velocity = 0;
+
+			tmc4671Emulation[motor].velocity = state->velocity;
+		}
+	}
+}
+
+/* sample the sensors for the next control tick */
+void plant_updateSensors()
+{
+	if (noiseRandom == 0)
+		noiseRandom = plantPatient.noiseSeed;
+
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+	{
+		double pressure = plantBlowerState[motor].pressure;
+		if (motor == 0)
+			pressure += plantPatient.pressureNoise * plant_gaussian(&noiseRandom);
+
+		// 16 conversions of the 12 bit ADC, 517 counts per 25 kPa, -20 kPa at 0V
+		double adc = (pressure + 20000) * 517 * 16 / 25000;
+		tmcm_setSimulatedADCValue(motor, (uint16_t)fmax(0, fmin(65535, adc)));
+	}
+
+	// NTC at 25 degrees
+	tmcm_setSimulatedADCValue(ADC_MOT_TEMP, 2786 * 16);
+
+	// flow sensor: 1 count = 2 ml/min
+	double counts = ((plantPatientState.flow + plantPatientState.leakFlow) * 60 + plantPatient.flowOffset + plantPatient.flowNoise * plant_gaussian(&noiseRandom)) / 2;
+	sm9333Emulation.pressure = (int16_t)fmax(-32768, fmin(32767, counts));
+	sm9333Emulation.status = SM9333_STATUS_DSP_S_UPDATED;
+
+	tmcm_setSimulatedADCSampleReady();
+}
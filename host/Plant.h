@@ -0,0 +1,78 @@
+/*
+ * Plant.h
+ *
+ *  Blowers, patient circuit and lung for the host simulation
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef PLANT_H
+#define PLANT_H
+
+	#include "hal/Hal_Definitions.h"
+
+	// blower (all axes)
+	typedef struct
+	{
+		double pressureGain;		// static pressure per rpm^2 [Pa/rpm^2]
+		double loadGain;			// load torque per rpm^2 [mA/rpm^2]
+		double flowLoadGain;		// load torque per rpm and flow [mA/(rpm*ml/s)]
+		double friction;			// [mA]
+		double acceleration;		// [rpm/(mA*s)]
+		double resistance;			// blower droop and tubing [Pa/(ml/s)]
+		double leakResistance;		// exhalation port / leak [Pa/(ml/s)]
+	} Plant_Blower;
+
+	// patient (axis 0)
+	typedef struct
+	{
+		double resistance;			// airway resistance [Pa/(ml/s)]
+		double compliance;			// [ml/Pa]
+		double leakResistance;		// leak between flow sensor and patient, e.g. the mask [Pa/(ml/s)] (0: none)
+
+		// spontaneous breathing: muscle pressure efforts
+		double effortAmplitude;		// [Pa] (0: passive patient)
+		uint32_t effortRiseTime;	// [ms]
+		uint32_t effortRelaxTime;	// [ms]
+		uint32_t effortPeriod;		// [ms] between effort onsets
+		uint8_t effortVariation;	// [%] random variation of the period
+		uint8_t effortStrengthVariation;	// [%] random reduction of the amplitude (weak and strong efforts)
+		uint32_t effortSeed;
+
+		// flow sensor zero offset and sensor noise (standard deviation, 0: off)
+		double flowOffset;			// [ml/min]
+		double pressureNoise;		// [Pa]
+		double flowNoise;			// [ml/min]
+		uint32_t noiseSeed;
+	} Plant_Patient;
+
+	typedef struct
+	{
+		double velocity;			// [rpm]
+		double pressure;			// pressure at the sensor [Pa]
+		double flow;				// blower flow [ml/s]
+		double loadTorque;			// [mA]
+	} Plant_BlowerState;
+
+	typedef struct
+	{
+		double volume;				// lung volume above FRC [ml]
+		double flow;				// patient flow [ml/s]
+		double leakFlow;			// [ml/s]
+		double alveolarPressure;	// [Pa]
+		double musclePressure;		// [Pa]
+		uint32_t efforts;			// started efforts
+		uint32_t effortStart;		// time of the last effort onset [ms]
+		double effortAmplitude;		// [Pa] of the last effort
+	} Plant_PatientState;
+
+	extern INSTANCE_STATE Plant_Blower plantBlower[NUMBER_OF_MOTORS];
+	extern INSTANCE_STATE Plant_Patient plantPatient;
+	extern INSTANCE_STATE Plant_BlowerState plantBlowerState[NUMBER_OF_MOTORS];
+	extern INSTANCE_STATE Plant_PatientState plantPatientState;
+
+	void plant_init();
+	void plant_step(uint32_t time);
+	void plant_updateSensors();
+
+#endif /* PLANT_H */
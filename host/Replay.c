@@ -0,0 +1,179 @@
+/*
+ * Replay.c
+ *
+ *  Replay of a recording of the control loop inputs on the host. The header restores the state of
+ *  the firmware at the start of the recording (after simulation_init()), then every entry of the
+ *  stream runs one control tick without the plant or executes one TMCL command. The inputs of a
+ *  tick are set on the emulated ICs in the order the control loop consumes them, so the same
+ *  firmware sources give the same outputs as on the recording device.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Replay.h"
+#include "Simulation.h"
+#include "TMCL.h"
+
+extern const uint8_t pressureSensorPin[NUMBER_OF_MOTORS];
+
+static INSTANCE_STATE const uint8_t *replayStream;
+static INSTANCE_STATE uint32_t replayLength;
+static INSTANCE_STATE uint32_t replayPosition;
+static INSTANCE_STATE uint32_t replayTicks;
+static INSTANCE_STATE uint32_t replayStateSize;
+static INSTANCE_STATE bool replayError;
+static INSTANCE_STATE int32_t replayLastInput[RECORDER_INPUTS];
+
+static uint8_t replay_readByte()
+{
+	if (replayPosition >= replayLength)
+	{
+		replayError = true;
+		return 0;
+	}
+	return replayStream[replayPosition++];
+}
+
+/* zigzag varint (see recorder_writeValue()) */
+static int32_t replay_readValue()
+{
+	uint32_t code = 0;
+
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		uint8_t byte = replay_readByte();
+		code |= (uint32_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return (int32_t)(code >> 1) ^ -(int32_t)(code & 1);
+	}
+
+	replayError = true;
+	return 0;
+}
+
+static int32_t replay_readInput(uint8_t input)
+{
+	replayLastInput[input] += replay_readValue();
+	return replayLastInput[input];
+}
+
+static void replay_countState(void *data, uint32_t size)
+{
+	replayStateSize += size;
+}
+
+/* one block of the state from its 32 bit words */
+static void replay_restoreState(void *data, uint32_t size)
+{
+	for (uint32_t i = 0; i < size; i += 4)
+	{
+		uint32_t word = replay_readValue();
+		for (uint32_t j = 0; (j < 4) && (i+j < size); j++)
+			((uint8_t *)data)[i+j] = word >> (8*j);
+	}
+}
+
+/* check the header and restore the state of the recording, call after simulation_init() */
+bool replay_start(const uint8_t *stream, uint32_t length)
+{
+	replayStream = stream;
+	replayLength = length;
+	replayPosition = 0;
+	replayTicks = 0;
+	replayError = false;
+	for (int i = 0; i < RECORDER_INPUTS; i++)
+		replayLastInput[i] = 0;
+
+	if ((replay_readByte() != RECORDER_ENTRY_HEADER) || (replay_readByte() != RECORDER_VERSION) || (replay_readByte() != NUMBER_OF_MOTORS))
+		return false;
+
+	// same memory layout of the state as the recording firmware
+	replayStateSize = 0;
+	tmcl_visitState(replay_countState);
+	if ((uint32_t)replay_readValue() != replayStateSize)
+		return false;
+
+	tmcl_visitState(replay_restoreState);
+
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+		tmc4671Emulation[motor].replay = true;
+
+	return !replayError;
+}
+
+/* set the inputs of one tick in the order of bldc_processBLDC() */
+static void replay_setTickInputs(uint8_t flags)
+{
+	tmc4671Emulation[0].registers[TMC4671_ADC_RAW_DATA] = (uint16_t)(replay_readInput(RECORDER_INPUT_SUPPLY_ADC) + VOLTAGE_OFFSET);
+	tmcm_setSimulatedADCValue(ADC_MOT_TEMP, replay_readInput(RECORDER_INPUT_TEMPERATURE_ADC) * 16);
+
+	// a tick without flow sample had a failed transfer
+	sm9333Emulation.present = (flags & RECORDER_TICK_FLOW_SAMPLE);
+	if (flags & RECORDER_TICK_FLOW_SAMPLE)
+	{
+		sm9333Emulation.temperature = replay_readInput(RECORDER_INPUT_FLOW_TEMPERATURE);
+		sm9333Emulation.pressure = replay_readInput(RECORDER_INPUT_FLOW_PRESSURE);
+		sm9333Emulation.status = replay_readInput(RECORDER_INPUT_FLOW_STATUS);
+	}
+
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+	{
+		int32_t *registers = tmc4671Emulation[motor].registers;
+
+		registers[TMC4671_PID_VELOCITY_ACTUAL] = replay_readInput(RECORDER_INPUT_VELOCITY(motor));
+		int32_t torque = replay_readInput(RECORDER_INPUT_TORQUE(motor));
+		int32_t flux = replay_readInput(RECORDER_INPUT_FLUX(motor));
+		registers[TMC4671_PID_TORQUE_FLUX_ACTUAL] = ((uint32_t)torque << 16) | (flux & 0xFFFF);
+
+		if (flags & RECORDER_TICK_PRESSURE_SAMPLE)
+			tmcm_setSimulatedADCValue(pressureSensorPin[motor], replay_readInput(RECORDER_INPUT_PRESSURE_ADC(motor)));
+	}
+
+	if (flags & RECORDER_TICK_PRESSURE_SAMPLE)
+		tmcm_setSimulatedADCSampleReady();
+}
+
+/* replay the next entry of the stream */
+uint8_t replay_step()
+{
+	if (replayError)
+		return REPLAY_ERROR;
+	if (replayPosition >= replayLength)
+		return REPLAY_END;
+
+	uint8_t entry = replay_readByte();
+	if (entry & RECORDER_ENTRY_COMMAND)
+	{
+		uint8_t opcode = replay_readByte();
+		uint8_t type = replay_readByte();
+		uint8_t motor = replay_readByte();
+		int32_t value = 0;
+		for (int i = 0; i < 4; i++)
+			value = (value << 8) | replay_readByte();
+
+		if (replayError)
+			return REPLAY_ERROR;
+
+		simulation_command(opcode, type, motor, &value);
+		return REPLAY_COMMAND;
+	}
+
+	if (entry & RECORDER_ENTRY_HEADER)
+	{
+		replayError = true;
+		return REPLAY_ERROR;
+	}
+
+	replay_setTickInputs(entry);
+	if (replayError)
+		return REPLAY_ERROR;
+
+	simulation_controlTick();
+	replayTicks++;
+	return REPLAY_TICK;
+}
+
+uint32_t replay_getTicks()
+{
+	return replayTicks;
+}
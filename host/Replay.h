@@ -0,0 +1,24 @@
+/*
+ * Replay.h
+ *
+ *  Replay of a recording of the control loop inputs (see hal/system/Recorder.h) on the host
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+	#include "hal/Hal_Definitions.h"
+
+	// results of replay_step()
+	#define REPLAY_END			0
+	#define REPLAY_TICK			1	// one control tick with the recorded inputs
+	#define REPLAY_COMMAND		2	// one TMCL command
+	#define REPLAY_ERROR		3	// truncated or corrupt stream
+
+	bool replay_start(const uint8_t *stream, uint32_t length);
+	uint8_t replay_step();
+	uint32_t replay_getTicks();
+
+#endif /* REPLAY_H */
@@ -0,0 +1,87 @@
+/*
+ * Runner.c
+ *
+ *  Parallel runs of independent simulation instances (parameter sweeps, Monte-Carlo runs)
+ *
+ *  A pool of worker threads takes the instances in order. The firmware state is INSTANCE_STATE, so
+ *  every instance runs on a fresh thread of its worker: a reused thread would keep the state of the
+ *  previous instance wherever the init functions don't reset it.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include "Runner.h"
+
+typedef struct
+{
+	Runner_Task task;
+	void *argument;
+	uint32_t instances;
+	uint32_t nextInstance;
+	pthread_mutex_t mutex;
+} Runner_Pool;
+
+typedef struct
+{
+	Runner_Pool *pool;
+	uint32_t index;
+} Runner_Instance;
+
+static void *runner_runInstance(void *argument)
+{
+	Runner_Instance *instance = argument;
+
+	instance->pool->task(instance->index, instance->pool->argument);
+	return NULL;
+}
+
+static void *runner_runWorker(void *argument)
+{
+	Runner_Pool *pool = argument;
+
+	while (1)
+	{
+		pthread_mutex_lock(&pool->mutex);
+		uint32_t index = pool->nextInstance;
+		if (index < pool->instances)
+			pool->nextInstance++;
+		pthread_mutex_unlock(&pool->mutex);
+
+		if (index >= pool->instances)
+			return NULL;
+
+		Runner_Instance instance = { pool, index };
+		pthread_t thread;
+		pthread_create(&thread, NULL, runner_runInstance, &instance);
+		pthread_join(thread, NULL);
+	}
+}
+
+/* number of online cpus */
+uint32_t runner_getCpuCount()
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0) ? count : 1;
+}
+
+/* run the instances 0..instances-1 of the task on up to threads cpus (0: all), returns when all are done */
+void runner_run(Runner_Task task, void *argument, uint32_t instances, uint32_t threads)
+{
+	Runner_Pool pool = { task, argument, instances, 0, PTHREAD_MUTEX_INITIALIZER };
+
+	if (instances == 0)
+		return;
+	if (threads == 0)
+		threads = runner_getCpuCount();
+	if (threads > instances)
+		threads = instances;
+
+	pthread_t workers[threads];
+	for (uint32_t i = 0; i < threads; i++)
+		pthread_create(&workers[i], NULL, runner_runWorker, &pool);
+
+	for (uint32_t i = 0; i < threads; i++)
+		pthread_join(workers[i], NULL);
+}
@@ -0,0 +1,20 @@
+/*
+ * Runner.h
+ *
+ *  Parallel runs of independent simulation instances (parameter sweeps, Monte-Carlo runs)
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef RUNNER_H
+#define RUNNER_H
+
+	#include <stdint.h>
+
+	// one instance: initializes the simulation and runs it, index 0..instances-1
+	typedef void (*Runner_Task)(uint32_t index, void *argument);
+
+	uint32_t runner_getCpuCount();
+	void runner_run(Runner_Task task, void *argument, uint32_t instances, uint32_t threads);
+
+#endif /* RUNNER_H */
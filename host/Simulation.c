@@ -0,0 +1,120 @@
+/*
+ * Simulation.c
+ *
+ *  Host simulation of the TOSV firmware. The firmware is initialized like main() does on the board,
+ *  every simulated millisecond the plant advances, the sensors are sampled, two SysTick interrupts
+ *  are raised and the control loop runs once. TMCL commands are executed directly, as if received
+ *  by one of the interfaces.
+ *
+ *  All state is INSTANCE_STATE, so each thread of a host process runs its own simulation.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Simulation.h"
+#include "hal/system/SysTick.h"
+#include "hal/system/SystemInfo.h"
+#include "hal/comm/Eeprom.h"
+#include "hal/comm/SPI.h"
+#include "hal/comm/I2C.h"
+#include "BLDC.h"
+#include "TMCL.h"
+#include "TOSV.h"
+
+extern void SysTickHandler(void);
+extern INSTANCE_STATE TTMCLCommand ActualCommand;
+extern INSTANCE_STATE TTMCLReply ActualReply;
+
+static INSTANCE_STATE uint32_t simulationTime;
+
+/* initialize the firmware in the order of main() */
+void simulation_init()
+{
+	simulationTime = 0;
+	chips_init();
+	plant_init();
+
+	// load default values of the module
+	tmcm_initModuleConfig();
+	tmcm_initMotorConfig();
+
+	// initialize hal functionality
+	systick_init();
+	systemInfo_initCycleCounter();
+
+	tmcm_initModuleSpecificIO();
+	tmcm_initModuleSpecificADC();
+
+	spi_init();
+	eeprom_initConfig();
+
+	InitIIC();
+
+	// initialize software
+	tmcl_init();
+	bldc_init();
+
+	// initialize ICs
+	tmcm_updateConfig();
+	tosv_initFlowSensor();
+}
+
+/* one control tick (1ms) */
+void simulation_tick()
+{
+	// the ADC values of the passed millisecond are ready before the tick
+	plant_step(simulationTime + 1);
+	plant_updateSensors();
+
+	simulation_controlTick();
+}
+
+/* one control tick without the plant, the inputs are set by the caller (see Replay.c) */
+void simulation_controlTick()
+{
+	simulationTime++;
+
+	SysTickHandler();
+	SysTickHandler();
+
+	bldc_processBLDC();
+}
+
+/* run for time [ms] */
+void simulation_run(uint32_t time)
+{
+	for (uint32_t i = 0; i < time; i++)
+		simulation_tick();
+}
+
+/* simulated time [ms] */
+uint32_t simulation_getTime()
+{
+	return simulationTime;
+}
+
+/* execute a TMCL command, returns the reply status and the reply value in value */
+uint8_t simulation_command(uint8_t opcode, uint8_t type, uint8_t motor, int32_t *value)
+{
+	ActualCommand.Opcode = opcode;
+	ActualCommand.Type = type;
+	ActualCommand.Motor = motor;
+	ActualCommand.Value.Int32 = *value;
+
+	tmcl_executeActualCommand();
+
+	*value = ActualReply.Value.Int32;
+	return ActualReply.Status;
+}
+
+int32_t simulation_getAxisParameter(uint8_t motor, uint8_t type)
+{
+	int32_t value = 0;
+	simulation_command(TMCL_GAP, type, motor, &value);
+	return value;
+}
+
+bool simulation_setAxisParameter(uint8_t motor, uint8_t type, int32_t value)
+{
+	return simulation_command(TMCL_SAP, type, motor, &value) == REPLY_OK;
+}
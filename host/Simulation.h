@@ -0,0 +1,27 @@
+/*
+ * Simulation.h
+ *
+ *  Host simulation of the TOSV firmware: the control core with emulated ICs and plant
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+	#include "hal/Hal_Definitions.h"
+	#include "hal/tmcl/TMCL-Defines.h"
+	#include "Plant.h"
+	#include "Chips.h"
+
+	void simulation_init();
+	void simulation_tick();
+	void simulation_controlTick();
+	void simulation_run(uint32_t time);
+	uint32_t simulation_getTime();
+
+	uint8_t simulation_command(uint8_t opcode, uint8_t type, uint8_t motor, int32_t *value);
+	int32_t simulation_getAxisParameter(uint8_t motor, uint8_t type);
+	bool simulation_setAxisParameter(uint8_t motor, uint8_t type, int32_t value);
+
+#endif /* SIMULATION_H */
@@ -0,0 +1,27 @@
+/*
+ * Test.h
+ *
+ *  Checks of the host tests. A test is a program that returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+	#include <stdio.h>
+
+	static int testFailures = 0;
+
+	#define CHECK(condition) \
+		do { \
+			if (!(condition)) \
+			{ \
+				printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+				testFailures++; \
+			} \
+		} while(0)
+
+	#define TEST_RESULT()	(printf("%s\n", testFailures ? "FAILED" : "passed"), testFailures)
+
+#endif /* TEST_H */
@@ -0,0 +1,445 @@
+/*
+ * ControlBenchmark.c
+ *
+ *  Control performance of scripted scenarios on the simulated plant, compared with a baseline file:
+ *
+ *    ControlBenchmark <baseline>       run all scenarios, fails on a regression against the baseline
+ *    ControlBenchmark -w <baseline>    run all scenarios and write their results as new baseline
+ *
+ *  The KPIs of a scenario are taken from the breaths after the settling time. All of them are
+ *  better when lower. A KPI is a regression if it exceeds its baseline by more than 10% plus the
+ *  slack of the KPI. The nanoseconds per tick of the host are printed, not compared.
+ *
+ *  The pressure KPIs compare the regulator target with the pressure of the plant at the sensor
+ *  (without sensor noise and filter), so they show the tracking of the patient pressure and not
+ *  of the filtered measurement.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Simulation.h"
+#include "Runner.h"
+#include "BLDC.h"
+#include "TOSV.h"
+
+#define SCENARIO_TIME		30000	// [ms]
+#define SETTLE_TIME			6000	// [ms] not evaluated
+#define TOLERANCE			10		// [%] of the baseline
+#define RISE_LEVEL			90		// [%] of the step from PEEP to the inspiratory pressure
+
+typedef enum
+{
+	KPI_RMS_ERROR,				// [Pa] mean rms pressure error of a breath
+	KPI_MAX_RMS_ERROR,			// [Pa]
+	KPI_OVERSHOOT,				// [Pa] max. overshoot over the inspiratory pressure
+	KPI_RISE_TIME,				// [ms] mean rise time to 90% of the step from PEEP
+	KPI_VOLUME_ERROR,			// [ml] mean deviation of the peak volume from the target (volume control)
+	KPI_TRIGGER_DELAY,			// [ms] mean delay from the effort onset to the triggered breath
+	KPI_MAX_TRIGGER_DELAY,		// [ms]
+	KPI_MISSED_EFFORTS,			// efforts in the exhalation without triggered breath
+	KPI_AUTO_TRIGGERS,			// triggered breaths without effort
+	KPIS
+} Benchmark_Kpi;
+
+static const struct
+{
+	const char *name;
+	double slack;
+} kpis[KPIS] =
+{
+	[KPI_RMS_ERROR]         = { "rms-error",         5 },
+	[KPI_MAX_RMS_ERROR]     = { "max-rms-error",     10 },
+	[KPI_OVERSHOOT]         = { "overshoot",         10 },
+	[KPI_RISE_TIME]         = { "rise-time",         5 },
+	[KPI_VOLUME_ERROR]      = { "volume-error",      5 },
+	[KPI_TRIGGER_DELAY]     = { "trigger-delay",     5 },
+	[KPI_MAX_TRIGGER_DELAY] = { "max-trigger-delay", 10 },
+	[KPI_MISSED_EFFORTS]    = { "missed-efforts",    0 },
+	[KPI_AUTO_TRIGGERS]     = { "auto-triggers",     0 },
+};
+
+typedef struct
+{
+	const char *name;
+	void (*setup)();
+	void (*event)(uint32_t time);	// scripted changes while running (optional)
+} Benchmark_Scenario;
+
+typedef struct
+{
+	double kpi[KPIS];
+	double nsPerTick;
+} Benchmark_Result;
+
+/* pressure tracking of the actual breath, from the start of an inhalation to the start of the next one */
+typedef struct
+{
+	double errorSquareSum;		// [Pa^2] while the pressure regulator is active
+	uint32_t samples;
+	double peakPressure;		// [Pa] in the inhalation
+	int32_t targetPressure;		// [Pa] inspiratory pressure, latched at the breath start
+	uint32_t time;				// [ms] since the breath start
+	uint32_t riseTime;			// [ms] to RISE_LEVEL (0: not reached)
+} Benchmark_Breath;
+
+// ===== scenarios =====
+
+static void setPressureControl()
+{
+	simulation_setAxisParameter(0, 15, 2);				// digital hall
+	simulation_setAxisParameter(0, 108, 2500);
+	simulation_setAxisParameter(0, 109, 800);
+}
+
+static void setupPressureControl()
+{
+	setPressureControl();
+}
+
+static void setupVolumeControl()
+{
+	setPressureControl();
+	simulation_setAxisParameter(0, 108, 4000);
+	simulation_setAxisParameter(0, 114, 400);
+	simulation_setAxisParameter(0, 99, TOSV_MODE_VOLUME_CONTROL);
+}
+
+static void setupPrvc()
+{
+	setPressureControl();
+	simulation_setAxisParameter(0, 108, 4000);
+	simulation_setAxisParameter(0, 114, 500);
+	simulation_setAxisParameter(0, 99, TOSV_MODE_PRVC);
+}
+
+static void setupAsbTrigger()
+{
+	setPressureControl();
+	simulation_setAxisParameter(0, 107, 3000);			// long exhalation pause for the efforts
+	simulation_setAxisParameter(0, 120, 1);
+	plantPatient.effortAmplitude = 400;
+	plantPatient.effortPeriod = 4500;
+	plantPatient.effortVariation = 20;
+}
+
+static void setupLeak()
+{
+	setPressureControl();
+	plantBlower[0].leakResistance = 2.0;
+}
+
+static void setupSensorNoise()
+{
+	setPressureControl();
+	plantPatient.pressureNoise = 30;
+	plantPatient.flowNoise = 300;
+}
+
+static void stepPeepLimit(uint32_t time)
+{
+	if (time == 12000)
+		simulation_setAxisParameter(0, 109, 1200);
+	else if (time == 20000)
+		simulation_setAxisParameter(0, 108, 3200);
+}
+
+static const Benchmark_Scenario scenarios[] =
+{
+	{ "pressure-control",  setupPressureControl, NULL },
+	{ "volume-control",    setupVolumeControl,   NULL },
+	{ "prvc",              setupPrvc,            NULL },
+	{ "asb-trigger",       setupAsbTrigger,      NULL },
+	{ "peep-limit-steps",  setupPressureControl, stepPeepLimit },
+	{ "leak",              setupLeak,            NULL },
+	{ "sensor-noise",      setupSensorNoise,     NULL },
+};
+
+#define SCENARIOS	(sizeof(scenarios)/sizeof(scenarios[0]))
+
+// ===== run =====
+
+/* The inspiratory pressure is latched at the start of the breath: in PRVC the breath start action has
+ * already adapted it for the next breath when the finished one is evaluated.
+ */
+static void startBreath(Benchmark_Breath *breath)
+{
+	breath->errorSquareSum = 0;
+	breath->samples = 0;
+	breath->peakPressure = 0;
+	breath->targetPressure = simulation_getAxisParameter(0, (simulation_getAxisParameter(0, 99) == TOSV_MODE_PRVC) ? 169 : 108);
+	breath->time = 0;
+	breath->riseTime = 0;
+}
+
+/* one tick of the breath: rms error, and in the pressure shaped modes overshoot and rise time */
+static void updateBreath(Benchmark_Breath *breath, uint8_t state)
+{
+	uint32_t mode = simulation_getAxisParameter(0, 99);
+	bool isPressureShaped = (mode == TOSV_MODE_PRESSURE_CONTROL) || (mode == TOSV_MODE_PRVC) || (mode == TOSV_MODE_PRESSURE_SUPPORT);
+	bool isInhalation = (state == TOSV_STATE_INHALATION_RISE) || (state == TOSV_STATE_INHALATION_PAUSE);
+	double pressure = plantBlowerState[0].pressure;
+
+	if (bldc_isPressureRegulatorActive(0))
+	{
+		double error = bldc_getTargetPressure(0) - pressure;
+		breath->errorSquareSum += error * error;
+		breath->samples++;
+	}
+
+	if (isPressureShaped && isInhalation)
+	{
+		if (pressure > breath->peakPressure)
+			breath->peakPressure = pressure;
+
+		int32_t step = breath->targetPressure - simulation_getAxisParameter(0, 109);
+		if ((breath->riseTime == 0) && (step > 0) && ((pressure - simulation_getAxisParameter(0, 109)) * 100 >= step * RISE_LEVEL))
+			breath->riseTime = breath->time + 1;
+	}
+
+	breath->time++;
+}
+
+/* one scenario, the KPIs are collected per breath (rise start) and per patient effort */
+static void runScenario(uint32_t index, void *argument)
+{
+	const Benchmark_Scenario *scenario = &scenarios[index];
+	Benchmark_Result *result = &((Benchmark_Result *)argument)[index];
+
+	simulation_init();
+	scenario->setup();
+	simulation_setAxisParameter(0, 100, 1);
+
+	double rmsSum = 0, riseTimeSum = 0, volumeErrorSum = 0, delaySum = 0;
+	uint32_t breaths = 0, volumeBreaths = 0, triggers = 0;
+	int32_t peakVolume = 0;
+	uint32_t pauseTime = 0;
+	uint32_t efforts = 0;
+	bool isEffortPending = false;
+	uint8_t lastState = TOSV_STATE_STOPPED;
+	Benchmark_Breath breath = { 0 };
+	for (int i = 0; i < KPIS; i++)
+		result->kpi[i] = 0;
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (uint32_t time = 1; time <= SCENARIO_TIME; time++)
+	{
+		if (scenario->event != NULL)
+			scenario->event(time);
+
+		simulation_tick();
+
+		bool isSettled = (time > SETTLE_TIME);
+		uint8_t state = simulation_getAxisParameter(0, 101);
+
+		// an effort onset in the exhalation should trigger a breath before the effort has ended
+		if (plantPatientState.efforts != efforts)
+		{
+			efforts = plantPatientState.efforts;
+			if (isEffortPending && isSettled)
+				result->kpi[KPI_MISSED_EFFORTS]++;
+			isEffortPending = (state == TOSV_STATE_EXHALATION_FALL) || (state == TOSV_STATE_EXHALATION_PAUSE);
+		}
+		if (isEffortPending && (time - plantPatientState.effortStart > plantPatient.effortRiseTime + plantPatient.effortRelaxTime))
+		{
+			if (isSettled)
+				result->kpi[KPI_MISSED_EFFORTS]++;
+			isEffortPending = false;
+		}
+
+		if (state == TOSV_STATE_EXHALATION_PAUSE)
+			pauseTime++;
+
+		if ((state == TOSV_STATE_INHALATION_RISE) && (lastState != TOSV_STATE_INHALATION_RISE))
+		{
+			// a shortened exhalation pause is a triggered breath
+			bool isTriggered = (lastState == TOSV_STATE_EXHALATION_PAUSE) && (pauseTime < (uint32_t)simulation_getAxisParameter(0, 107));
+			if (isTriggered && isSettled)
+			{
+				if (isEffortPending)
+				{
+					uint32_t delay = time - plantPatientState.effortStart;
+					delaySum += delay;
+					triggers++;
+					if (delay > result->kpi[KPI_MAX_TRIGGER_DELAY])
+						result->kpi[KPI_MAX_TRIGGER_DELAY] = delay;
+				}
+				else
+				{
+					result->kpi[KPI_AUTO_TRIGGERS]++;
+				}
+			}
+			if (isTriggered)
+				isEffortPending = false;
+
+			// results of a complete breath (not after the startup)
+			if (isSettled && (lastState == TOSV_STATE_EXHALATION_PAUSE) && (breath.samples > 0))
+			{
+				double rmsError = sqrt(breath.errorSquareSum / breath.samples);
+				rmsSum += rmsError;
+				riseTimeSum += breath.riseTime;
+				breaths++;
+				if (rmsError > result->kpi[KPI_MAX_RMS_ERROR])
+					result->kpi[KPI_MAX_RMS_ERROR] = rmsError;
+				if (breath.peakPressure - breath.targetPressure > result->kpi[KPI_OVERSHOOT])
+					result->kpi[KPI_OVERSHOOT] = breath.peakPressure - breath.targetPressure;
+
+				if (simulation_getAxisParameter(0, 99) == TOSV_MODE_VOLUME_CONTROL)
+				{
+					volumeErrorSum += abs(peakVolume - simulation_getAxisParameter(0, 114));
+					volumeBreaths++;
+				}
+			}
+
+			startBreath(&breath);
+			peakVolume = 0;
+			pauseTime = 0;
+		}
+		if (state >= TOSV_STATE_INHALATION_RISE)
+			updateBreath(&breath, state);
+
+		int32_t volume = simulation_getAxisParameter(0, 113);
+		if (volume > peakVolume)
+			peakVolume = volume;
+
+		lastState = state;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	result->nsPerTick = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / SCENARIO_TIME;
+
+	if (breaths > 0)
+	{
+		result->kpi[KPI_RMS_ERROR] = rmsSum / breaths;
+		result->kpi[KPI_RISE_TIME] = riseTimeSum / breaths;
+	}
+	if (volumeBreaths > 0)
+		result->kpi[KPI_VOLUME_ERROR] = volumeErrorSum / volumeBreaths;
+	if (triggers > 0)
+		result->kpi[KPI_TRIGGER_DELAY] = delaySum / triggers;
+}
+
+// ===== baseline =====
+
+static bool readBaseline(const char *fileName, double baseline[SCENARIOS][KPIS], bool isSet[SCENARIOS][KPIS])
+{
+	FILE *file = fopen(fileName, "r");
+	if (file == NULL)
+		return false;
+
+	char line[256], scenarioName[64], kpiName[64];
+	double value;
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		if ((line[0] == '#') || (sscanf(line, "%63s %63s %lf", scenarioName, kpiName, &value) != 3))
+			continue;
+
+		for (uint32_t i = 0; i < SCENARIOS; i++)
+		{
+			for (int j = 0; j < KPIS; j++)
+			{
+				if (!strcmp(scenarioName, scenarios[i].name) && !strcmp(kpiName, kpis[j].name))
+				{
+					baseline[i][j] = value;
+					isSet[i][j] = true;
+				}
+			}
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+static bool writeBaseline(const char *fileName, Benchmark_Result *results)
+{
+	FILE *file = fopen(fileName, "wb");
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "# baseline of ControlBenchmark: scenario, KPI and value (written by make -C host baseline)\r\n");
+	for (uint32_t i = 0; i < SCENARIOS; i++)
+		for (int j = 0; j < KPIS; j++)
+			fprintf(file, "%s %s %.1f\r\n", scenarios[i].name, kpis[j].name, results[i].kpi[j]);
+
+	fclose(file);
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	bool isWrite = (argc == 3) && !strcmp(argv[1], "-w");
+	if ((argc != 2) && !isWrite)
+	{
+		printf("usage: %s [-w] <baseline>\n", argv[0]);
+		return 1;
+	}
+	const char *fileName = argv[argc-1];
+
+	Benchmark_Result results[SCENARIOS];
+	runner_run(runScenario, results, SCENARIOS, 0);
+
+	if (isWrite)
+	{
+		if (!writeBaseline(fileName, results))
+		{
+			printf("can't write %s\n", fileName);
+			return 1;
+		}
+		printf("baseline written to %s\n", fileName);
+	}
+
+	double baseline[SCENARIOS][KPIS] = { { 0 } };
+	bool isSet[SCENARIOS][KPIS] = { { false } };
+	if (!isWrite && !readBaseline(fileName, baseline, isSet))
+	{
+		printf("can't read %s\n", fileName);
+		return 1;
+	}
+
+	int regressions = 0;
+	for (uint32_t i = 0; i < SCENARIOS; i++)
+	{
+		printf("----- %s (%.0f ns per tick) -----\n", scenarios[i].name, results[i].nsPerTick);
+		for (int j = 0; j < KPIS; j++)
+		{
+			double value = results[i].kpi[j];
+			const char *verdict = "";
+
+			if (!isWrite)
+			{
+				double limit = baseline[i][j] * (100 + TOLERANCE) / 100 + kpis[j].slack;
+				if (!isSet[i][j])
+				{
+					verdict = "no baseline";
+					regressions++;
+				}
+				else if (value > limit)
+				{
+					verdict = "REGRESSION";
+					regressions++;
+				}
+				else if (value < baseline[i][j] * (100 - TOLERANCE) / 100 - kpis[j].slack)
+				{
+					verdict = "improved (update the baseline)";
+				}
+			}
+
+			if (isWrite)
+				printf("  %-18s %10.1f\n", kpis[j].name, value);
+			else
+				printf("  %-18s %10.1f  baseline %10.1f  %s\n", kpis[j].name, value, baseline[i][j], verdict);
+		}
+	}
+
+	if (!isWrite)
+		printf("%s\n", regressions ? "FAILED" : "passed");
+
+	return regressions;
+}
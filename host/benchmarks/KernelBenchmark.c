@@ -0,0 +1,128 @@
+/*
+ * KernelBenchmark.c
+ *
+ *  Host nanoseconds per call of the control loop kernels (see Benchmark.c), next to the cpu cycles
+ *  measured on the target:
+ *
+ *    KernelBenchmark <cycle table>
+ *
+ *  Every kernel runs in batches of KERNEL_CALLS calls with the inputs of the benchmark on the target,
+ *  the fastest batch counts and the batch of empty calls is subtracted. The numbers show relative
+ *  changes of a kernel on the build machine. The list follows the types of TMCL command 66 and
+ *  also shows its min. and mean reply on the host, where the cycle counter counts nanoseconds.
+ *
+ *  The cpu cycles on the Cortex-M3 (with the flash wait states of the part) can only be measured on
+ *  the board with TMCL command 66, there is no instruction set emulation of the target here. The
+ *  cycle table holds these replies per type, "-" for a kernel not measured on the target yet.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "Simulation.h"
+#include "Benchmark.h"
+
+#define KERNEL_CALLS		1000000
+#define KERNEL_BATCHES		5
+
+static const char *kernelNames[BENCHMARK_KERNELS] =
+{
+	[BENCHMARK_FILTER_PT1]        = "tmc_filterPT1",
+	[BENCHMARK_PID]               = "pid_process",
+	[BENCHMARK_DIVIDE]            = "conversion_divide",
+	[BENCHMARK_CALIBRATION]       = "calibration_interpolate",
+	[BENCHMARK_MOTOR_TEMPERATURE] = "bldc_calculateMotorTemperature",
+	[BENCHMARK_TMCL_FRAME]        = "tmcl_parseFrame",
+	[BENCHMARK_VOLUME]            = "tosv_integrateVolume",
+	[BENCHMARK_ESTIMATOR]         = "estimator_update",
+	[BENCHMARK_LUNG_SAMPLE]       = "lungMechanics_addSample",
+	[BENCHMARK_REGULATOR_SETTINGS] = "bldc_updateRegulatorSettings",
+	[BENCHMARK_BREATH_PHASE]      = "tosv_processPhase",
+};
+
+/* [ns] of the fastest batch */
+static double measureBatch(uint8_t kernel)
+{
+	double fastest = 0;
+
+	for (int batch = 0; batch < KERNEL_BATCHES; batch++)
+	{
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		benchmark_repeat(kernel, KERNEL_CALLS);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		double time = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+		if ((batch == 0) || (time < fastest))
+			fastest = time;
+	}
+	return fastest;
+}
+
+/* target cycles per type: "<type> <kernel> <min> <mean>", "-" for not measured */
+static bool readCycleTable(const char *fileName, char cycles[BENCHMARK_KERNELS][2][16])
+{
+	FILE *file = fopen(fileName, "r");
+	if (file == NULL)
+		return false;
+
+	char line[256], kernelName[64], minCycles[16], meanCycles[16];
+	int type;
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		if ((line[0] == '#') || (sscanf(line, "%d %63s %15s %15s", &type, kernelName, minCycles, meanCycles) != 4))
+			continue;
+
+		if ((type >= 0) && (type < BENCHMARK_KERNELS))
+		{
+			snprintf(cycles[type][0], sizeof(cycles[type][0]), "%s", minCycles);
+			snprintf(cycles[type][1], sizeof(cycles[type][1]), "%s", meanCycles);
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 2)
+	{
+		printf("usage: %s <cycle table>\n", argv[0]);
+		return 1;
+	}
+
+	char cycles[BENCHMARK_KERNELS][2][16];
+	for (int kernel = 0; kernel < BENCHMARK_KERNELS; kernel++)
+		for (int value = 0; value < 2; value++)
+			snprintf(cycles[kernel][value], sizeof(cycles[kernel][value]), "-");
+	if (!readCycleTable(argv[1], cycles))
+	{
+		printf("can't read %s\n", argv[1]);
+		return 1;
+	}
+
+	// default configuration of the module for the kernel inputs
+	simulation_init();
+
+	double overhead = measureBatch(BENCHMARK_KERNELS);
+
+	printf("%-4s %-32s %10s %15s %15s %15s %15s\n", "type", "kernel", "host ns/call",
+			"host min [ns]", "host mean [ns]", "target min", "target mean");
+	for (int kernel = 0; kernel < BENCHMARK_KERNELS; kernel++)
+	{
+		double time = measureBatch(kernel) - overhead;
+
+		// TMCL command 66 on the host (value 0: min, 1: mean)
+		int32_t minReply = 0, meanReply = 1;
+		simulation_command(TMCL_Benchmark, kernel, 0, &minReply);
+		simulation_command(TMCL_Benchmark, kernel, 0, &meanReply);
+
+		printf("%-4d %-32s %10.2f %15d %15d %15s %15s\n", kernel, kernelNames[kernel], (time > 0) ? time / KERNEL_CALLS : 0,
+				minReply, meanReply, cycles[kernel][0], cycles[kernel][1]);
+	}
+	printf("(loop overhead %.2f ns/call subtracted, target: cpu cycles of TMCL command 66 from %s)\n", overhead / KERNEL_CALLS, argv[1]);
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * AutotuneTest.c
+ *
+ *  Relay feedback autotuner against first order plus dead time plants and the closed loop
+ *  step response of the PID engine with the identified gains
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <math.h>
+#include "Autotune.h"
+#include "PID.h"
+#include "Test.h"
+
+#define MAX_DEAD_TIME		64		// [ms]
+#define BIAS				1000	// output at the operating point
+#define AMPLITUDE			500
+
+// first order plus dead time plant with a 1 ms step
+typedef struct
+{
+	double gain;
+	double timeConstant;			// [ms]
+	uint32_t deadTime;				// [ms]
+	double value;
+	int32_t delayed[MAX_DEAD_TIME];
+	uint32_t time;
+} FOPDT;
+
+void fopdt_init(FOPDT *plant, double gain, double timeConstant, uint32_t deadTime, int32_t output)
+{
+	plant->gain = gain;
+	plant->timeConstant = timeConstant;
+	plant->deadTime = deadTime;
+	plant->value = gain * output;
+	for (int i = 0; i < MAX_DEAD_TIME; i++)
+		plant->delayed[i] = output;
+	plant->time = 0;
+}
+
+int32_t fopdt_step(FOPDT *plant, int32_t output)
+{
+	uint32_t index = plant->time++ % plant->deadTime;
+	int32_t delayedOutput = plant->delayed[index];
+	plant->delayed[index] = output;
+
+	plant->value += (plant->gain * delayedOutput - plant->value) / plant->timeConstant;
+	return lround(plant->value);
+}
+
+/* identify the plant and check the closed loop step response with the tuned gains */
+void checkPlant(double gain, double timeConstant, uint32_t deadTime, uint8_t rule)
+{
+	FOPDT plant;
+	fopdt_init(&plant, gain, timeConstant, deadTime, BIAS);
+
+	Autotune at;
+	// the operating points are averaged after about 6 time constants
+	CHECK(autotune_start(&at, BIAS, AMPLITUDE, 10, 6 * timeConstant, rule, 8, 16));
+
+	int32_t actual = fopdt_step(&plant, BIAS);
+	for (int i = 0; (i < 60000) && autotune_isActive(&at); i++)
+		actual = fopdt_step(&plant, autotune_process(&at, actual));
+
+	CHECK(at.state == AUTOTUNE_STATE_DONE);
+	CHECK(fabs(at.plantGain / 1000.0 - gain) < 0.1 * gain);
+	CHECK(fabs(at.timeConstant - timeConstant) < 0.3 * timeConstant);
+	CHECK(abs(at.deadTime - (int32_t)deadTime) < 15);
+
+	// closed loop step of the target by the amplitude of the experiment
+	PIDControl pid = { .pParam = at.pParam, .iParam = at.iParam, .pShift = 8, .iShift = 16, .dFilterShift = 3,
+			.setpointWeight = 256, .trackingGain = 128 };
+	pid_reset(&pid);
+
+	fopdt_init(&plant, gain, timeConstant, deadTime, BIAS);
+	actual = fopdt_step(&plant, BIAS);
+	int32_t start = actual;
+	int32_t target = start + gain * AMPLITUDE;
+	pid_handover(&pid, start, actual, BIAS);
+
+	int32_t maxActual = actual;
+	for (int i = 0; i < 5000; i++)
+	{
+		actual = fopdt_step(&plant, pid_process(&pid, target, actual, 0, 4 * BIAS));
+		if (actual > maxActual)
+			maxActual = actual;
+	}
+
+	int32_t overshoot = 100 * (maxActual - target) / (target - start);
+	printf("K %.1f tau %4.0f dead time %2u rule %u: K %5.3f tau %4d dead time %3d, P %5u I %5u, closed loop overshoot %d%%\n",
+			gain, timeConstant, deadTime, rule, at.plantGain / 1000.0, at.timeConstant, at.deadTime, at.pParam, at.iParam, overshoot);
+	CHECK(overshoot < 15);
+	CHECK(abs(actual - target) <= 2);
+}
+
+int main()
+{
+	checkPlant(2.0, 200, 10, AUTOTUNE_RULE_SIMC);
+	checkPlant(2.0, 200, 30, AUTOTUNE_RULE_SIMC);
+	checkPlant(2.0, 200, 10, AUTOTUNE_RULE_IMC);
+	checkPlant(2.0, 200, 30, AUTOTUNE_RULE_IMC);
+	checkPlant(4.0, 50, 5, AUTOTUNE_RULE_SIMC);
+	checkPlant(1.0, 500, 50, AUTOTUNE_RULE_SIMC);
+
+	return TEST_RESULT();
+}
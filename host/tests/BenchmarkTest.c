@@ -0,0 +1,64 @@
+/*
+ * BenchmarkTest.c
+ *
+ *  Kernel benchmark command (TMCL 66): runs on an idle module, refused while the ventilator or a
+ *  regulator of an axis depends on the blocked control tick
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <pthread.h>
+#include "Simulation.h"
+#include "Benchmark.h"
+#include "Test.h"
+
+static uint8_t runBenchmark(uint8_t kernel)
+{
+	int32_t value = 0;
+	return simulation_command(TMCL_Benchmark, kernel, 0, &value);
+}
+
+void *runBenchmarkCommand(void *argument)
+{
+	(void)argument;
+
+	simulation_init();
+	CHECK(simulation_setAxisParameter(0, 15, 2));				// digital hall
+
+	// idle
+	for (int kernel = 0; kernel < BENCHMARK_KERNELS; kernel++)
+		CHECK(runBenchmark(kernel) == REPLY_OK);
+	CHECK(runBenchmark(BENCHMARK_KERNELS) == REPLY_WRONG_TYPE);
+
+	// torque mode: the TMC4671 regulates on its own
+	CHECK(simulation_setAxisParameter(0, 20, 500));
+	simulation_run(10);
+	CHECK(runBenchmark(BENCHMARK_FILTER_PT1) == REPLY_OK);
+
+	CHECK(simulation_setAxisParameter(0, 24, 1000));
+	simulation_run(10);
+	CHECK(runBenchmark(BENCHMARK_FILTER_PT1) == REPLY_CMD_NOT_AVAILABLE);
+
+	CHECK(simulation_setAxisParameter(0, 31, 1000));
+	simulation_run(10);
+	CHECK(runBenchmark(BENCHMARK_FILTER_PT1) == REPLY_CMD_NOT_AVAILABLE);
+
+	CHECK(simulation_setAxisParameter(0, 20, 0));
+	simulation_run(10);
+	CHECK(runBenchmark(BENCHMARK_FILTER_PT1) == REPLY_OK);
+
+	CHECK(simulation_setAxisParameter(0, 100, 1));
+	simulation_run(10);
+	CHECK(runBenchmark(BENCHMARK_FILTER_PT1) == REPLY_CMD_NOT_AVAILABLE);
+
+	return NULL;
+}
+
+int main()
+{
+	pthread_t thread;
+	pthread_create(&thread, NULL, runBenchmarkCommand, NULL);
+	pthread_join(thread, NULL);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,90 @@
+/*
+ * ConversionTest.c
+ *
+ *  conversion_divide() against the C division
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Conversion.h"
+#include "Test.h"
+
+#define NUMERATOR_RANGE		(1 << 24)
+
+static uint64_t comparisons = 0;
+
+/* compare one numerator, reports the first mismatch of a divisor only */
+static bool isEqual(int32_t value, uint32_t divisor, const Reciprocal *reciprocal)
+{
+	int32_t expected = (divisor <= INT32_MAX) ? value / (int32_t)divisor : (int32_t)(((int64_t)value) / divisor);
+	int32_t result = conversion_divide(value, reciprocal);
+
+	comparisons++;
+	if (result == expected)
+		return true;
+
+	printf("%d / %u: %d instead of %d\n", value, divisor, result, expected);
+	return false;
+}
+
+/* the multiples of the divisor and their neighbours up to NUMERATOR_RANGE and the extremes */
+static bool checkMultiples(uint32_t divisor)
+{
+	Reciprocal reciprocal;
+	conversion_setDivisor(&reciprocal, divisor);
+
+	int32_t extremes[] = { INT32_MIN+1, INT32_MIN+2, -1, 0, 1, INT32_MAX-1, INT32_MAX };
+	for (uint32_t i = 0; i < sizeof(extremes)/sizeof(extremes[0]); i++)
+		if (!isEqual(extremes[i], divisor, &reciprocal))
+			return false;
+
+	for (int64_t multiple = 0; multiple <= NUMERATOR_RANGE; multiple += divisor)
+	{
+		for (int32_t delta = -1; delta <= 1; delta++)
+		{
+			if (!isEqual(multiple + delta, divisor, &reciprocal) || !isEqual(-multiple + delta, divisor, &reciprocal))
+				return false;
+		}
+	}
+	return true;
+}
+
+/* every numerator in +-NUMERATOR_RANGE */
+static bool checkAll(uint32_t divisor)
+{
+	Reciprocal reciprocal;
+	conversion_setDivisor(&reciprocal, divisor);
+
+	for (int32_t value = -NUMERATOR_RANGE; value <= NUMERATOR_RANGE; value++)
+	{
+		if (conversion_divide(value, &reciprocal) != value / (int32_t)divisor)
+			return isEqual(value, divisor, &reciprocal);
+	}
+	comparisons += 2*NUMERATOR_RANGE + 1;
+	return true;
+}
+
+int main()
+{
+	// all 16 bit divisors (shunt factor, ramp times)
+	for (uint32_t divisor = 1; divisor <= 0xFFFF; divisor++)
+		CHECK(checkMultiples(divisor));
+
+	// large divisors
+	for (uint32_t divisor = 0x10000; divisor >= 0x10000; divisor += 0x10000 - 1)
+		CHECK(checkMultiples(divisor));
+	CHECK(checkMultiples(UINT32_MAX));
+
+	// every numerator for the pole pairs
+	for (uint32_t divisor = 1; divisor <= 255; divisor++)
+		CHECK(checkAll(divisor));
+
+	// division by zero returns 0 like the Cortex-M3
+	Reciprocal reciprocal;
+	conversion_setDivisor(&reciprocal, 0);
+	CHECK(conversion_divide(12345, &reciprocal) == 0);
+	CHECK(conversion_divide(-12345, &reciprocal) == 0);
+
+	printf("%llu comparisons\n", (unsigned long long)comparisons);
+	return TEST_RESULT();
+}
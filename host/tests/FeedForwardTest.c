@@ -0,0 +1,107 @@
+/*
+ * FeedForwardTest.c
+ *
+ *  Pressure feed forward (axis parameters 69-72): tracking of the inhalation rise of the
+ *  pressure control mode and no torque kick on a step of the target pressure
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <pthread.h>
+#include "Simulation.h"
+#include "TOSV.h"
+#include "Test.h"
+
+// blower model of the simulated plant (Plant.c) at the inhalation pressures
+#define FF_PRESSURE_GAIN	240		// [mA per 1024 Pa] load torque per pressure
+#define FF_SLOPE_GAIN		140		// [mA per Pa/ms] acceleration around 30000rpm and lung filling
+#define FF_FLOW_GAIN		8		// [mA per 1024 ml/min] load torque per flow around 30000rpm
+
+#define BREATHS				10
+
+typedef struct
+{
+	bool feedForward;
+	double riseError;			// summed squared error of the inhalation rise of the last breath [Pa^2]
+	int32_t stepTorqueChange;	// torque change in the tick of a target pressure step [mA]
+} FeedForwardRun;
+
+void enableFeedForward(bool enable)
+{
+	CHECK(simulation_setAxisParameter(0, 69, enable));
+	CHECK(simulation_setAxisParameter(0, 70, FF_PRESSURE_GAIN));
+	CHECK(simulation_setAxisParameter(0, 71, FF_SLOPE_GAIN));
+	CHECK(simulation_setAxisParameter(0, 72, FF_FLOW_GAIN));
+}
+
+void *runFeedForward(void *argument)
+{
+	FeedForwardRun *run = argument;
+
+	// pressure control ventilation
+	simulation_init();
+	CHECK(simulation_setAxisParameter(0, 15, 2));				// digital hall
+	enableFeedForward(run->feedForward);
+	CHECK(simulation_setAxisParameter(0, 100, 1));
+
+	uint32_t breaths = 0;
+	uint8_t lastState = TOSV_STATE_STOPPED;
+	while (breaths < BREATHS)
+	{
+		simulation_tick();
+
+		uint8_t state = simulation_getAxisParameter(0, 101);
+		if (state == TOSV_STATE_INHALATION_RISE)
+		{
+			if (lastState != TOSV_STATE_INHALATION_RISE)
+				run->riseError = 0;
+
+			int32_t error = simulation_getAxisParameter(0, 31) - simulation_getAxisParameter(0, 33);
+			run->riseError += (double)error * error;
+		}
+		else if (lastState == TOSV_STATE_INHALATION_RISE)
+		{
+			breaths++;
+		}
+		lastState = state;
+	}
+
+	// target pressure step in pressure mode
+	simulation_init();
+	CHECK(simulation_setAxisParameter(0, 15, 2));
+	enableFeedForward(run->feedForward);
+	CHECK(simulation_setAxisParameter(0, 31, 1000));
+	simulation_run(1000);
+
+	int32_t torque = simulation_getAxisParameter(0, 20);
+	CHECK(simulation_setAxisParameter(0, 31, 1500));
+	simulation_tick();
+	run->stepTorqueChange = simulation_getAxisParameter(0, 20) - torque;
+
+	return NULL;
+}
+
+int main()
+{
+	FeedForwardRun runs[] = { { .feedForward = false }, { .feedForward = true } };
+	pthread_t threads[2];
+
+	for (int i = 0; i < 2; i++)
+		pthread_create(&threads[i], NULL, runFeedForward, &runs[i]);
+
+	for (int i = 0; i < 2; i++)
+	{
+		pthread_join(threads[i], NULL);
+		printf("feed forward %d: inhalation rise squared error %.3e Pa^2, torque change on a 500 Pa step %d mA\n",
+				runs[i].feedForward, runs[i].riseError, runs[i].stepTorqueChange);
+	}
+
+	// the feed forward follows the ramp (the rest is the delay of the pressure measurement and the
+	// flow above the range of the flow sensor)
+	CHECK(runs[1].riseError < runs[0].riseError * 3 / 4);
+
+	// a step only changes the pressure part of the feed forward (no slope kick of 140 * 500 mA)
+	CHECK(runs[1].stepTorqueChange < runs[0].stepTorqueChange + (500 * FF_PRESSURE_GAIN) / 1024 + 100);
+
+	return TEST_RESULT();
+}
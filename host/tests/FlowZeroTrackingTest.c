@@ -0,0 +1,92 @@
+/*
+ * FlowZeroTrackingTest.c
+ *
+ *  The flow sensor zero offset is tracked in the exhalation pauses (axis parameters 123-126): a
+ *  sensor drift is followed, a steady leak at the patient is only absorbed slowly and up to the
+ *  drift limit.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <pthread.h>
+#include "Simulation.h"
+#include "Test.h"
+
+#define FLOW_OFFSET		150		// [ml/min]
+#define LEAK_RESISTANCE	60		// [Pa/(ml/s)] 1500 ml/min at PEEP
+#define MAX_STEP		4		// [ml/min] per breath
+#define MAX_DRIFT		200		// [ml/min]
+
+typedef struct
+{
+	bool tracking;
+	double flowOffset;			// [ml/min]
+	double leakResistance;		// [Pa/(ml/s)]
+	uint32_t time;				// [ms]
+	int32_t offset;
+	int32_t updates;
+} TrackingRun;
+
+/* ventilate a stiff lung with an offset on the flow sensor or a leak */
+void *trackOffset(void *argument)
+{
+	TrackingRun *run = argument;
+
+	simulation_init();
+	plantPatient.compliance = 0.2;
+
+	CHECK(simulation_setAxisParameter(0, 15, 2));				// digital hall
+	CHECK(simulation_setAxisParameter(0, 107, 3000));			// exhaled at the end of the pause
+	CHECK(simulation_setAxisParameter(0, 125, run->tracking));
+	CHECK(simulation_setAxisParameter(0, 100, 1));				// ventilator on
+
+	plantPatient.flowOffset = run->flowOffset;
+	plantPatient.leakResistance = run->leakResistance;
+	simulation_run(run->time);
+
+	run->updates = simulation_getAxisParameter(0, 124);
+	run->offset = simulation_getAxisParameter(0, 123);
+	return NULL;
+}
+
+/* each run in its own thread, so it starts with the initial firmware state */
+void runTracking(TrackingRun *run)
+{
+	pthread_t thread;
+	pthread_create(&thread, NULL, trackOffset, run);
+	pthread_join(thread, NULL);
+	printf("tracking %d, offset %.0f ml/min, leak resistance %.0f Pa/(ml/s), %d s: offset %d ml/min after %d updates\n",
+			run->tracking, run->flowOffset, run->leakResistance, run->time / 1000, run->offset, run->updates);
+}
+
+int main()
+{
+	// sensor drift
+	TrackingRun run = { .tracking = true, .flowOffset = FLOW_OFFSET, .time = 240000 };
+	runTracking(&run);
+	CHECK(run.updates > 0);
+	CHECK(run.offset > FLOW_OFFSET-10 && run.offset < FLOW_OFFSET+10);
+
+	// one step per breath
+	run.time = 35000;
+	runTracking(&run);
+	CHECK(run.updates > 0);
+	CHECK(run.offset <= run.updates * MAX_STEP);
+
+	// steady leak: slowly and only up to the drift limit
+	run = (TrackingRun){ .tracking = true, .leakResistance = LEAK_RESISTANCE, .time = 35000 };
+	runTracking(&run);
+	CHECK(run.updates > 0);
+	CHECK(run.offset <= run.updates * MAX_STEP);
+
+	run.time = 300000;
+	runTracking(&run);
+	CHECK(run.offset <= MAX_DRIFT);
+
+	run = (TrackingRun){ .tracking = false, .flowOffset = FLOW_OFFSET, .time = 60000 };
+	runTracking(&run);
+	CHECK(run.updates == 0);
+	CHECK(run.offset == 0);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,130 @@
+/*
+ * LungMechanicsTest.c
+ *
+ *  Estimation of resistance, compliance and total PEEP (axis parameters 154-158) against an
+ *  ideal RC lung and against the patient of the simulated ventilator
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include "Simulation.h"
+#include "LungMechanics.h"
+#include "TOSV.h"
+#include "Test.h"
+
+#define RESISTANCE		1.96	// [Pa/(ml/s)] 20 cmH2O/(l/s)
+#define COMPLIANCE		0.51	// [ml/Pa] 50 ml/cmH2O
+
+#define PEEP			1000	// [Pa]
+#define PIP				2500	// [Pa]
+#define BREATHS			8
+
+/* pressure profile of a TOSV breath at time t [ms] since breath start (rise, pause, fall, pause) */
+double getAirwayPressure(uint32_t t)
+{
+	if (t < 200)
+		return PEEP + (PIP-PEEP) * t / 200.0;
+	if (t < 1000)
+		return PIP;
+	if (t < 1200)
+		return PIP - (PIP-PEEP) * (t-1000) / 200.0;
+	return PEEP;
+}
+
+/* ideal RC lung, incomplete exhalation (time constant 1s, 800ms exhalation pause) */
+void checkIdealLung(double pressureNoise, double flowNoise)
+{
+	LungMechanics lung;
+	lungMechanics_reset(&lung);
+
+	uint32_t random = 1;
+	double volume = COMPLIANCE * PEEP;		// absolute lung volume [ml]
+	double totalPeep = 0;
+
+	for (int breath = 0; breath < BREATHS; breath++)
+	{
+		lungMechanics_update(&lung);
+
+		double breathStartVolume = volume;
+		totalPeep = volume / COMPLIANCE;
+
+		for (uint32_t t = 0; t < 2000; t++)
+		{
+			double pressure = getAirwayPressure(t);
+			double flow = (pressure - volume / COMPLIANCE) / RESISTANCE;	// [ml/s]
+			volume += flow / 1000;
+
+			double noise[2];
+			for (int i = 0; i < 2; i++)
+			{
+				random = random * 1664525u + 1013904223u;
+				noise[i] = ((random >> 8) / 16777216.0) - 0.5;
+			}
+			lungMechanics_addSample(&lung, lround(pressure + pressureNoise * noise[0]), lround(flow * 60 + flowNoise * noise[1]),
+					lround(volume - breathStartVolume));
+		}
+	}
+	CHECK(lungMechanics_update(&lung));
+
+	printf("ideal lung (noise %.0f Pa, %.0f ml/min): R %d (%.0f) Pa/(l/s), C %d (%.0f) ml/kPa, total PEEP %d (%.0f) Pa\n",
+			pressureNoise, flowNoise, lung.resistance, RESISTANCE * 1000, lung.compliance, COMPLIANCE * 1000, lung.totalPeep, totalPeep);
+	CHECK(fabs(lung.resistance - RESISTANCE * 1000) < 0.02 * RESISTANCE * 1000);
+	CHECK(fabs(lung.compliance - COMPLIANCE * 1000) < 0.02 * COMPLIANCE * 1000);
+	CHECK(fabs(lung.totalPeep - totalPeep) < 10);
+	CHECK(totalPeep > PEEP + 100);		// intrinsic PEEP
+}
+
+/* pressure control ventilation of the simulated patient */
+void *runVentilator(void *argument)
+{
+	simulation_init();
+	plantPatient.resistance = RESISTANCE;
+	plantPatient.compliance = COMPLIANCE;
+
+	CHECK(simulation_setAxisParameter(0, 15, 2));			// digital hall
+	CHECK(simulation_setAxisParameter(0, 104, 1000));		// inhalation rise
+	CHECK(simulation_setAxisParameter(0, 108, PIP));
+	CHECK(simulation_setAxisParameter(0, 109, PEEP));
+	CHECK(simulation_setAxisParameter(0, 100, 1));
+
+	// alveolar pressure at the start of the last breath
+	double breathStartPressure = 0;
+	uint8_t lastState = TOSV_STATE_STOPPED;
+	for (int i = 0; i < 30000; i++)
+	{
+		simulation_tick();
+
+		uint8_t state = simulation_getAxisParameter(0, 101);
+		if ((state == TOSV_STATE_INHALATION_RISE) && (lastState != TOSV_STATE_INHALATION_RISE))
+			breathStartPressure = plantPatientState.alveolarPressure;
+		lastState = state;
+	}
+
+	int32_t resistance = simulation_getAxisParameter(0, 154);
+	int32_t compliance = simulation_getAxisParameter(0, 155);
+	int32_t totalPeep = simulation_getAxisParameter(0, 156);
+	int32_t updates = simulation_getAxisParameter(0, 158);
+
+	printf("ventilator: R %d (%.0f) Pa/(l/s), C %d (%.0f) ml/kPa, total PEEP %d (%.0f) Pa after %d updates\n",
+			resistance, RESISTANCE * 1000, compliance, COMPLIANCE * 1000, totalPeep, breathStartPressure, updates);
+	CHECK(updates > 0);
+	CHECK(fabs(resistance - RESISTANCE * 1000) < 0.15 * RESISTANCE * 1000);
+	CHECK(fabs(compliance - COMPLIANCE * 1000) < 0.15 * COMPLIANCE * 1000);
+	CHECK(fabs(totalPeep - breathStartPressure) < 100);
+
+	return NULL;
+}
+
+int main()
+{
+	checkIdealLung(0, 0);
+	checkIdealLung(20, 200);
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, runVentilator, NULL);
+	pthread_join(thread, NULL);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,192 @@
+/*
+ * PIDTest.c
+ *
+ *  Properties of the PID engine and a pressure step of the simulated blower with the
+ *  P/I defaults and with the D part, setpoint weighting and output rate limit
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <pthread.h>
+#include "Simulation.h"
+#include "PID.h"
+#include "Test.h"
+
+#define PRESSURE_LOW		1000	// [Pa]
+#define PRESSURE_HIGH		1500	// [Pa]
+#define STEP_DURATION		1000	// [ms]
+
+void initRegulator(PIDControl *pid)
+{
+	pid->pParam = 1000;
+	pid->iParam = 3000;
+	pid->dParam = 0;
+	pid->pShift = 8;
+	pid->iShift = 16;
+	pid->dFilterShift = 3;
+	pid->setpointWeight = 256;
+	pid->trackingGain = 128;
+	pid->maxOutputStep = 0;
+	pid_reset(pid);
+}
+
+/* first order process (output -> actual), returns the overshoot above the target after a
+ * saturated start */
+int32_t runFirstOrderProcess(PIDControl *pid, int32_t target, int32_t maxOutput)
+{
+	int32_t actual = 0;
+	int32_t overshoot = 0;
+
+	for (int i = 0; i < 2000; i++)
+	{
+		int32_t output = pid_process(pid, target, actual, 0, maxOutput);
+		actual += (output - actual) / 50;
+		if (actual - target > overshoot)
+			overshoot = actual - target;
+	}
+	return overshoot;
+}
+
+void checkRegulator()
+{
+	PIDControl pid;
+
+	// bumpless handover: continue with the given output
+	initRegulator(&pid);
+	pid_handover(&pid, 1500, 1400, 3000);
+	int32_t output = pid_process(&pid, 1500, 1400, -10000, 10000);
+	CHECK(abs(output - 3000) <= 5);
+
+	// bumpless handover onto a negative output
+	initRegulator(&pid);
+	pid_handover(&pid, 1500, 1600, -3000);
+	output = pid_process(&pid, 1500, 1600, -10000, 10000);
+	CHECK(abs(output + 3000) <= 5);
+
+	// D part on the actual value: no kick on a setpoint step
+	initRegulator(&pid);
+	pid.dParam = 4000;
+	pid_handover(&pid, 1000, 1000, 0);
+	pid_process(&pid, 2000, 1000, -100000, 100000);
+	CHECK(pid.dPart == 0);
+
+	// setpoint weight scales the P part of a setpoint step
+	initRegulator(&pid);
+	pid.iParam = 0;
+	pid.setpointWeight = 128;
+	output = pid_process(&pid, 2000, 0, -100000, 100000);
+	CHECK(output == (1000 * 1000) >> 8);
+
+	// output rate limit
+	initRegulator(&pid);
+	pid.maxOutputStep = 100;
+	int32_t lastOutput = 0;
+	bool isLimited = true;
+	for (int i = 0; i < 50; i++)
+	{
+		output = pid_process(&pid, 5000, 0, -100000, 100000);
+		isLimited &= abs(output - lastOutput) <= 100;
+		lastOutput = output;
+	}
+	CHECK(isLimited);
+	CHECK(output == 5000);
+
+	// back calculation anti windup: a saturated start does not wind up the I part
+	initRegulator(&pid);
+	pid.trackingGain = 0;
+	int32_t overshootWithoutTracking = runFirstOrderProcess(&pid, 1000, 1200);
+	initRegulator(&pid);
+	int32_t overshootWithTracking = runFirstOrderProcess(&pid, 1000, 1200);
+	printf("saturated start: overshoot %d without, %d with back calculation\n", overshootWithoutTracking, overshootWithTracking);
+	CHECK(overshootWithTracking < overshootWithoutTracking / 2);
+
+	// back calculation at the negative limit: the I part stays within one I step of the limit
+	initRegulator(&pid);
+	pid.pParam = 0;
+	for (int i = 0; i < 1000; i++)
+		output = pid_process(&pid, 0, 1000, -500, 500);
+	CHECK(output == -500);
+	CHECK(pid_getIntegral(&pid) <= -500);
+	CHECK(pid_getIntegral(&pid) >= -500 - ((3000 * 1000) >> 16) - 1);
+}
+
+typedef struct
+{
+	int32_t dParam;
+	int32_t setpointWeight;
+	int32_t maxTorqueStep;
+	double squaredError;		// [Pa^2] summed over the step
+	int32_t overshoot;			// [Pa]
+	int32_t finalError;			// [Pa]
+	int32_t maxTorqueChange;	// [mA] per tick
+} PressureStep;
+
+/* pressure step of the blower into the closed patient circuit */
+void *runPressureStep(void *argument)
+{
+	PressureStep *step = argument;
+
+	simulation_init();
+	CHECK(simulation_setAxisParameter(0, 15, 2));				// digital hall
+	CHECK(simulation_setAxisParameter(0, 64, step->dParam));
+	CHECK(simulation_setAxisParameter(0, 66, step->setpointWeight));
+	CHECK(simulation_setAxisParameter(0, 68, step->maxTorqueStep));
+
+	CHECK(simulation_setAxisParameter(0, 31, PRESSURE_LOW));
+	simulation_run(STEP_DURATION);
+
+	CHECK(simulation_setAxisParameter(0, 31, PRESSURE_HIGH));
+	int32_t lastTorque = simulation_getAxisParameter(0, 20);
+	for (int i = 0; i < STEP_DURATION; i++)
+	{
+		simulation_tick();
+
+		int32_t error = PRESSURE_HIGH - simulation_getAxisParameter(0, 33);
+		step->squaredError += (double)error * error;
+		if (-error > step->overshoot)
+			step->overshoot = -error;
+		step->finalError = error;
+
+		int32_t torque = simulation_getAxisParameter(0, 20);
+		if (abs(torque - lastTorque) > step->maxTorqueChange)
+			step->maxTorqueChange = abs(torque - lastTorque);
+		lastTorque = torque;
+	}
+	return NULL;
+}
+
+void runPressureSteps(PressureStep *steps, int count)
+{
+	pthread_t threads[count];
+	for (int i = 0; i < count; i++)
+		pthread_create(&threads[i], NULL, runPressureStep, &steps[i]);
+
+	printf("   D weight  step |  squared error  overshoot  final error  max torque change\n");
+	for (int i = 0; i < count; i++)
+	{
+		pthread_join(threads[i], NULL);
+		printf("%4d %6d %5d | %14.3e %10d %12d %18d\n", steps[i].dParam, steps[i].setpointWeight, steps[i].maxTorqueStep,
+				steps[i].squaredError, steps[i].overshoot, steps[i].finalError, steps[i].maxTorqueChange);
+	}
+}
+
+int main()
+{
+	checkRegulator();
+
+	PressureStep steps[] =
+	{
+		{ .dParam = 0,   .setpointWeight = 256, .maxTorqueStep = 0 },	// P/I defaults
+		{ .dParam = 2000, .setpointWeight = 256, .maxTorqueStep = 0 },
+		{ .dParam = 0,   .setpointWeight = 192, .maxTorqueStep = 0 },
+		{ .dParam = 0,   .setpointWeight = 256, .maxTorqueStep = 50 },
+	};
+	runPressureSteps(steps, sizeof(steps)/sizeof(steps[0]));
+
+	for (uint32_t i = 0; i < sizeof(steps)/sizeof(steps[0]); i++)
+		CHECK(abs(steps[i].finalError) < 50);
+	CHECK(steps[2].overshoot < steps[0].overshoot);
+	CHECK(steps[3].maxTorqueChange <= 50+1);		// rounding of the torque target register
+
+	return TEST_RESULT();
+}
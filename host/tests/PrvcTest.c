@@ -0,0 +1,78 @@
+/*
+ * PrvcTest.c
+ *
+ *  Pressure regulated volume control: the adapted inspiratory pressure stays within PEEP and
+ *  LIMIT pressure when these are changed while running and restarts on a change of the mode
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <pthread.h>
+#include "Simulation.h"
+#include "TOSV.h"
+#include "Test.h"
+
+#define PIP				3000
+#define PEEP			1000
+#define TIDAL_VOLUME	600		// [ml] above the volume of the test pressure
+#define TEST_PRESSURE	1000	// [Pa] above PEEP for the first breath
+
+void *runPrvc(void *argument)
+{
+	(void)argument;
+
+	simulation_init();
+	CHECK(simulation_setAxisParameter(0, 15, 2));				// digital hall
+	CHECK(simulation_setAxisParameter(0, 108, PIP));
+	CHECK(simulation_setAxisParameter(0, 109, PEEP));
+	CHECK(simulation_setAxisParameter(0, 114, TIDAL_VOLUME));
+	CHECK(simulation_setAxisParameter(0, 99, 3));				// PRVC
+	CHECK(simulation_setAxisParameter(0, 100, 1));
+	CHECK(simulation_getAxisParameter(0, 169) == PEEP + TEST_PRESSURE);
+
+	// adapted upwards to the tidal volume
+	simulation_run(20000);
+	int32_t pressure = simulation_getAxisParameter(0, 169);
+	printf("PRVC: %d Pa after %d breaths\n", pressure, simulation_getAxisParameter(0, 173));
+	CHECK(simulation_getAxisParameter(0, 173) > 0);
+	CHECK(pressure > PEEP + TEST_PRESSURE);
+
+	// lower limit pressure while running
+	CHECK(simulation_setAxisParameter(0, 108, PEEP + 500));
+	CHECK(simulation_getAxisParameter(0, 169) == PEEP + 500);
+	int32_t peakTarget = 0;
+	for (int i = 0; i < 5000; i++)
+	{
+		simulation_tick();
+		if (simulation_getAxisParameter(0, 31) > peakTarget)
+			peakTarget = simulation_getAxisParameter(0, 31);
+	}
+	printf("PRVC: peak target pressure %d Pa with limit pressure %d Pa\n", peakTarget, PEEP + 500);
+	CHECK(peakTarget <= PEEP + 500);
+
+	// higher PEEP while running
+	CHECK(simulation_setAxisParameter(0, 108, PIP));
+	CHECK(simulation_setAxisParameter(0, 109, PEEP + 800));
+	CHECK(simulation_getAxisParameter(0, 169) >= PEEP + 800);
+	CHECK(simulation_setAxisParameter(0, 109, PEEP));
+
+	// mode changes while running restart the adaptation
+	CHECK(simulation_setAxisParameter(0, 99, 0));
+	CHECK(simulation_setAxisParameter(0, 99, 3));
+	CHECK(simulation_getAxisParameter(0, 169) == PEEP + TEST_PRESSURE);
+	CHECK(simulation_getAxisParameter(0, 173) == 0);
+	CHECK(!simulation_setAxisParameter(0, 99, 5));
+	CHECK(!simulation_setAxisParameter(0, 99, -1));
+	CHECK(simulation_getAxisParameter(0, 99) == 3);
+
+	return NULL;
+}
+
+int main()
+{
+	pthread_t thread;
+	pthread_create(&thread, NULL, runPrvc, NULL);
+	pthread_join(thread, NULL);
+
+	return TEST_RESULT();
+}
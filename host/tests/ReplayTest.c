@@ -0,0 +1,206 @@
+/*
+ * ReplayTest.c
+ *
+ *  Offline replay of a recording: a ventilation with sensor noise, flow sensor dropouts and TMCL
+ *  commands (including EEPROM store and restore) is recorded after the startup, the replay of the
+ *  downloaded stream on a fresh instance gives the same outputs in every tick
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <pthread.h>
+#include <time.h>
+#include "Simulation.h"
+#include "Replay.h"
+#include "BLDC.h"
+#include "TOSV.h"
+#include "Test.h"
+
+#define WARMUP_TIME			2000	// [ms] before the recording
+#define RECORD_TIME			3000	// [ms]
+#define STREAM_SIZE			65536
+
+typedef struct
+{
+	uint8_t stream[STREAM_SIZE];
+	uint32_t length;
+	uint32_t ticks;
+	uint64_t trace;				// hash of the outputs of every recorded tick
+	uint32_t commands;
+} ReplayRecording;
+
+static ReplayRecording recording;
+
+static uint64_t hash(uint64_t hash, int32_t value)
+{
+	return (hash ^ (uint32_t)value) * 0x100000001B3;	// FNV-1a
+}
+
+/* outputs of the tick read without TMCL commands, these would be part of the recording */
+static uint64_t hashOutputs(uint64_t trace)
+{
+	trace = hash(trace, tosvConfig[0].actualState);
+	trace = hash(trace, bldc_getTargetPressure(0));
+	trace = hash(trace, bldc_getActualPressure(0));
+	trace = hash(trace, bldc_getActualVolume(0));
+	trace = hash(trace, bldc_getTargetMotorCurrent(0));
+	trace = hash(trace, bldc_getPressurePParam(0));
+	trace = hash(trace, tmc4671Emulation[0].registers[TMC4671_PID_TORQUE_FLUX_TARGET]);
+	return trace;
+}
+
+static uint32_t command(uint8_t opcode, uint8_t type, int32_t value)
+{
+	CHECK(simulation_command(opcode, type, 0, &value) == REPLY_OK);
+	return value;
+}
+
+void *runRecording(void *argument)
+{
+	(void)argument;
+
+	simulation_init();
+	plantPatient.pressureNoise = 20;
+	plantPatient.flowNoise = 200;
+	CHECK(simulation_setAxisParameter(0, 15, 2));				// digital hall
+	CHECK(simulation_setAxisParameter(0, 108, 2500));
+	CHECK(simulation_setAxisParameter(0, 109, 800));
+
+	// pressure P in the EEPROM differs from the default
+	CHECK(simulation_setAxisParameter(0, 39, 350));
+	command(TMCL_STAP, 39, 0);
+
+	CHECK(simulation_setAxisParameter(0, 100, 1));
+	simulation_run(WARMUP_TIME);
+
+	command(TMCL_Recorder, 0, 0);
+	recording.trace = 0xCBF29CE484222325;
+	recording.commands = 0;
+	for (int i = 0; i < RECORD_TIME; i++)
+	{
+		// flow sensor dropouts
+		sm9333Emulation.present = (i % 700) >= 20;
+
+		switch(i)
+		{
+			case 500:
+				CHECK(simulation_setAxisParameter(0, 108, 2800));
+				recording.commands++;
+				break;
+			case 1100:
+				CHECK(simulation_setAxisParameter(0, 69, 1));
+				recording.commands++;
+				break;
+			case 1600:
+				CHECK(simulation_setAxisParameter(0, 39, 450));
+				recording.commands++;
+				break;
+			case 2300:
+				// restores pressure P 350 from the EEPROM
+				command(TMCL_RSAP, 39, 0);
+				recording.commands++;
+				break;
+		}
+
+		simulation_tick();
+		recording.trace = hashOutputs(recording.trace);
+	}
+	command(TMCL_Recorder, 1, 0);
+	CHECK(simulation_getAxisParameter(0, 39) == 350);
+	CHECK(command(TMCL_Recorder, 2, 0) == RECORDER_STATE_STOPPED);
+	recording.length = command(TMCL_Recorder, 3, 0);
+	recording.ticks = command(TMCL_Recorder, 4, 0);
+	CHECK(recording.length <= STREAM_SIZE);
+
+	// download as the host software does
+	for (uint32_t index = 0; index < recording.length; index += 4)
+	{
+		uint32_t data = command(TMCL_Recorder, 5, index);
+		for (uint32_t i = 0; (i < 4) && (index+i < STREAM_SIZE); i++)
+			recording.stream[index+i] = data >> (8 * (3-i));
+	}
+
+	return NULL;
+}
+
+void *runReplay(void *argument)
+{
+	(void)argument;
+
+	simulation_init();
+	CHECK(simulation_getAxisParameter(0, 39) != 350);
+	CHECK(replay_start(recording.stream, recording.length));
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	uint64_t trace = 0xCBF29CE484222325;
+	uint32_t commands = 0;
+	uint8_t result;
+	while ((result = replay_step()) != REPLAY_END)
+	{
+		if (result == REPLAY_ERROR)
+			break;
+		if (result == REPLAY_TICK)
+			trace = hashOutputs(trace);
+		else
+			commands++;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+	printf("recording: %u bytes, %u ticks, %u commands\n", recording.length, recording.ticks, recording.commands);
+	printf("replay: %u ticks, %u commands, trace %016llx %s, %.0fx real time\n", replay_getTicks(), commands,
+			(unsigned long long)trace, (trace == recording.trace) ? "(identical)" : "(differs)", replay_getTicks() / 1000.0 / seconds);
+
+	CHECK(result == REPLAY_END);
+	CHECK(replay_getTicks() == recording.ticks);
+	CHECK(replay_getTicks() == RECORD_TIME);
+	CHECK(commands == recording.commands);
+	CHECK(trace == recording.trace);
+
+	// the EEPROM of the recording has been restored
+	CHECK(simulation_getAxisParameter(0, 39) == 350);
+
+	return NULL;
+}
+
+void *runRejectedReplay(void *argument)
+{
+	(void)argument;
+
+	simulation_init();
+
+	// other stream version
+	recording.stream[1]++;
+	CHECK(!replay_start(recording.stream, recording.length));
+	recording.stream[1]--;
+
+	// truncated header
+	CHECK(!replay_start(recording.stream, 100));
+
+	// truncated tick
+	CHECK(replay_start(recording.stream, recording.length - 1));
+	uint8_t result;
+	while ((result = replay_step()) == REPLAY_TICK || (result == REPLAY_COMMAND));
+	CHECK(result == REPLAY_ERROR);
+
+	return NULL;
+}
+
+void run(void *(*function)(void *))
+{
+	pthread_t thread;
+	pthread_create(&thread, NULL, function, NULL);
+	pthread_join(thread, NULL);
+}
+
+int main()
+{
+	run(runRecording);
+	run(runReplay);
+	run(runRejectedReplay);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,86 @@
+/*
+ * RunnerTest.c
+ *
+ *  Parallel simulation instances: a sweep of pressure P gains and lung models gives the same
+ *  traces on concurrent threads as one instance after another
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Simulation.h"
+#include "Runner.h"
+#include "Test.h"
+#include "hal/system/SysTick.h"
+#include "hal/system/SystemInfo.h"
+
+#define GAINS			4
+#define LUNGS			3
+#define INSTANCES		(GAINS * LUNGS)
+#define RUN_TIME		5000	// [ms]
+#define THREADS			4
+
+static const int32_t pressureP[GAINS] = { 200, 300, 400, 500 };
+static const double lungResistance[LUNGS] = { 0.5, 0.98, 2.0 };		// [Pa/(ml/s)]
+static const double lungCompliance[LUNGS] = { 0.3, 0.51, 1.0 };		// [ml/Pa]
+
+typedef struct
+{
+	uint64_t trace;			// hash of the actual values of every tick
+	uint32_t timer;			// SysTick timer at the end of the run
+	uint32_t loops;			// counted velocity loops
+} RunnerResult;
+
+static uint64_t hash(uint64_t hash, int32_t value)
+{
+	return (hash ^ (uint32_t)value) * 0x100000001B3;	// FNV-1a
+}
+
+void runSweepInstance(uint32_t index, void *argument)
+{
+	RunnerResult *result = &((RunnerResult *)argument)[index];
+
+	simulation_init();
+	plantPatient.resistance = lungResistance[index % LUNGS];
+	plantPatient.compliance = lungCompliance[index % LUNGS];
+	CHECK(simulation_setAxisParameter(0, 15, 2));				// digital hall
+	CHECK(simulation_setAxisParameter(0, 39, pressureP[index / LUNGS]));
+	CHECK(simulation_setAxisParameter(0, 100, 1));
+
+	result->trace = 0xCBF29CE484222325;
+	for (int i = 0; i < RUN_TIME; i++)
+	{
+		simulation_tick();
+		result->trace = hash(result->trace, simulation_getAxisParameter(0, 33));
+		result->trace = hash(result->trace, simulation_getAxisParameter(0, 21));
+		result->trace = hash(result->trace, simulation_getAxisParameter(0, 110));
+	}
+	result->timer = systick_getTimer();
+	result->loops = systemInfo_getVelocityLoopCounter();
+}
+
+int main()
+{
+	RunnerResult serial[INSTANCES] = { 0 };
+	RunnerResult parallel[INSTANCES] = { 0 };
+
+	runner_run(runSweepInstance, serial, INSTANCES, 1);
+	runner_run(runSweepInstance, parallel, INSTANCES, THREADS);
+
+	for (int i = 0; i < INSTANCES; i++)
+	{
+		printf("pressure P %d, R %.2f Pa/(ml/s), C %.2f ml/Pa: trace %016llx %s\n", pressureP[i / LUNGS],
+				lungResistance[i % LUNGS], lungCompliance[i % LUNGS], (unsigned long long)serial[i].trace,
+				(serial[i].trace == parallel[i].trace) ? "" : "(differs on parallel run)");
+
+		CHECK(serial[i].trace == parallel[i].trace);
+		CHECK(serial[i].timer == RUN_TIME);
+		CHECK(parallel[i].timer == RUN_TIME);
+		CHECK(serial[i].loops == parallel[i].loops);
+
+		// the instances differ from each other
+		for (int j = 0; j < i; j++)
+			CHECK(serial[i].trace != serial[j].trace);
+	}
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,165 @@
+/*
+ * TriggerTest.c
+ *
+ *  ASB trigger against the efforts of the simulated patient: trigger delay from the effort onset,
+ *  missed efforts of a weak patient and auto triggers of a passive patient, for the flow criterion
+ *  alone and fused with the flow derivative and the blower load criteria
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Simulation.h"
+#include "Runner.h"
+#include "TOSV.h"
+#include "Test.h"
+
+#define RUN_TIME		60000	// [ms]
+#define SETTLE_TIME		10000	// [ms]
+#define EFFORT_RISE_TIME	300		// [ms]
+
+typedef struct
+{
+	const char *name;
+	double effortAmplitude;		// [Pa] 0: passive patient
+	int32_t flowThreshold;		// [ml/min]
+	int32_t slopeThreshold;		// [ml/min per ms] 0: off
+	int32_t torqueThreshold;	// [mA] 0: off
+} TriggerCase;
+
+typedef struct
+{
+	uint32_t efforts;			// efforts with onset in the exhalation
+	uint32_t triggers;			// triggered breaths on an effort
+	uint32_t missed;			// efforts without triggered breath
+	uint32_t autoTriggers;		// triggered breaths without effort
+	uint32_t delaySum;			// [ms] from the effort onset
+	uint32_t maxDelay;			// [ms]
+} TriggerResult;
+
+enum { STRONG, WEAK, PASSIVE, FUSED, WEAK_FUSED, PASSIVE_FUSED, CASES };
+
+static const TriggerCase cases[CASES] =
+{
+	[STRONG]        = { "strong efforts, flow",         400, 500, 0,  0 },
+	[WEAK]          = { "weak efforts, flow",           20,  500, 0,  0 },
+	[PASSIVE]       = { "passive patient, flow",        0,   500, 0,  0 },
+	[FUSED]         = { "strong efforts, fused",        400, 500, 12, 15 },
+	[WEAK_FUSED]    = { "weak efforts, fused",          20,  500, 12, 15 },
+	[PASSIVE_FUSED] = { "passive patient, fused",       0,   500, 12, 15 },
+};
+
+void runTrigger(uint32_t index, void *argument)
+{
+	const TriggerCase *test = &cases[index];
+	TriggerResult *result = &((TriggerResult *)argument)[index];
+
+	simulation_init();
+	plantPatient.effortAmplitude = test->effortAmplitude;
+	plantPatient.effortRiseTime = EFFORT_RISE_TIME;
+	plantPatient.effortPeriod = 4500;
+	plantPatient.effortVariation = 20;
+	CHECK(simulation_setAxisParameter(0, 15, 2));				// digital hall
+	CHECK(simulation_setAxisParameter(0, 108, 2500));
+	CHECK(simulation_setAxisParameter(0, 109, 800));
+	CHECK(simulation_setAxisParameter(0, 107, 3000));			// long exhalation pause for the efforts
+	CHECK(simulation_setAxisParameter(0, 120, 1));
+	CHECK(simulation_setAxisParameter(0, 121, test->flowThreshold));
+	CHECK(simulation_setAxisParameter(0, 127, test->slopeThreshold));
+	CHECK(simulation_setAxisParameter(0, 128, test->torqueThreshold));
+	CHECK(simulation_setAxisParameter(0, 100, 1));
+
+	// an effort onset in the exhalation should trigger a breath before the effort has ended
+	uint32_t efforts = 0;
+	bool isEffortPending = false;
+	for (uint32_t time = 1; time <= RUN_TIME; time++)
+	{
+		uint32_t triggers = simulation_getAxisParameter(0, 159);
+		simulation_tick();
+
+		bool isSettled = (time > SETTLE_TIME);
+		uint8_t state = simulation_getAxisParameter(0, 101);
+
+		if (plantPatientState.efforts != efforts)
+		{
+			efforts = plantPatientState.efforts;
+			if (isEffortPending && isSettled)
+				result->missed++;
+			isEffortPending = (state == TOSV_STATE_EXHALATION_FALL) || (state == TOSV_STATE_EXHALATION_PAUSE);
+			if (isEffortPending && isSettled)
+				result->efforts++;
+		}
+		if ((uint32_t)simulation_getAxisParameter(0, 159) > triggers)
+		{
+			if (isSettled && isEffortPending)
+			{
+				uint32_t delay = time - plantPatientState.effortStart;
+				result->triggers++;
+				result->delaySum += delay;
+				if (delay > result->maxDelay)
+					result->maxDelay = delay;
+			}
+			else if (isSettled)
+			{
+				result->autoTriggers++;
+			}
+			isEffortPending = false;
+		}
+		else if (isEffortPending && ((state == TOSV_STATE_INHALATION_RISE)
+				|| (time - plantPatientState.effortStart > EFFORT_RISE_TIME + plantPatient.effortRelaxTime)))
+		{
+			// ended or cut by the timed breath
+			if (isSettled)
+				result->missed++;
+			isEffortPending = false;
+		}
+	}
+}
+
+int main()
+{
+	TriggerResult results[CASES] = { 0 };
+
+	runner_run(runTrigger, results, CASES, 0);
+
+	for (int i = 0; i < CASES; i++)
+	{
+		TriggerResult *result = &results[i];
+		printf("%s: %u efforts, %u triggers, delay %u ms mean, %u ms max, %u missed, %u auto triggers\n", cases[i].name,
+				result->efforts, result->triggers, (result->triggers > 0) ? result->delaySum / result->triggers : 0,
+				result->maxDelay, result->missed, result->autoTriggers);
+	}
+
+	// every effort triggers on the flow alone, late in its rise
+	CHECK(results[STRONG].efforts >= 8);
+	CHECK(results[STRONG].triggers == results[STRONG].efforts);
+	CHECK(results[STRONG].missed == 0);
+	CHECK(results[STRONG].autoTriggers == 0);
+	CHECK(results[STRONG].maxDelay < 100);
+
+	// efforts below the flow threshold don't trigger
+	CHECK(results[WEAK].efforts >= 5);
+	CHECK(results[WEAK].triggers == 0);
+	CHECK(results[WEAK].missed == results[WEAK].efforts);
+	CHECK(results[WEAK].autoTriggers == 0);
+
+	// no triggers without efforts
+	CHECK(results[PASSIVE].triggers + results[PASSIVE].autoTriggers == 0);
+
+	// the flow derivative and the blower load trigger within a few tens of ms
+	CHECK(results[FUSED].efforts >= 8);
+	CHECK(results[FUSED].triggers == results[FUSED].efforts);
+	CHECK(results[FUSED].missed == 0);
+	CHECK(results[FUSED].autoTriggers == 0);
+	CHECK(results[FUSED].delaySum <= 30 * results[FUSED].triggers);
+	CHECK(results[FUSED].maxDelay < 40);
+
+	// and catch most of the weak efforts
+	CHECK(results[WEAK_FUSED].efforts >= 5);
+	CHECK(results[WEAK_FUSED].triggers * 4 >= results[WEAK_FUSED].efforts * 3);
+	CHECK(results[WEAK_FUSED].autoTriggers == 0);
+
+	// the blower accelerating to PEEP is no effort: no auto triggers of a passive patient
+	CHECK(results[PASSIVE_FUSED].triggers + results[PASSIVE_FUSED].autoTriggers == 0);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,109 @@
+/*
+ * TwoAxisTest.c
+ *
+ *  Two blowers on one controller (built with SIMULATION_MOTORS=2): axis 0 ventilates in pressure
+ *  control, axis 1 holds a constant pressure on its own sensor. The ventilator parts of the pressure
+ *  regulation (gain scheduling, learned and flow feed forward, flow pressure limit) stay on axis 0.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <pthread.h>
+#include "Simulation.h"
+#include "TOSV.h"
+#include "Test.h"
+
+#define PIP					2500
+#define PEEP				1000
+#define AXIS1_PRESSURE		1500
+#define FF_PRESSURE_GAIN	240		// [mA per 1024 Pa]
+#define FF_FLOW_GAIN		8		// [mA per 1024 ml/min]
+
+void *runTwoAxes(void *argument)
+{
+	(void)argument;
+
+	simulation_init();
+	for (int motor = 0; motor < NUMBER_OF_MOTORS; motor++)
+	{
+		CHECK(simulation_setAxisParameter(motor, 15, 2));				// digital hall
+
+		// gain set per TOSV state: pressure P 200 + 20 * state
+		for (int state = 0; state < 6; state++)
+		{
+			CHECK(simulation_setAxisParameter(motor, 76, state));
+			CHECK(simulation_setAxisParameter(motor, 77, 200 + 20*state));
+		}
+		CHECK(simulation_setAxisParameter(motor, 74, 1));
+
+		CHECK(simulation_setAxisParameter(motor, 69, 1));
+		CHECK(simulation_setAxisParameter(motor, 70, FF_PRESSURE_GAIN));
+		CHECK(simulation_setAxisParameter(motor, 72, FF_FLOW_GAIN));
+	}
+	int32_t axis1PressureP = simulation_getAxisParameter(1, 39);
+
+	CHECK(simulation_setAxisParameter(0, 108, PIP));
+	CHECK(simulation_setAxisParameter(0, 109, PEEP));
+	CHECK(simulation_setAxisParameter(0, 100, 1));
+	CHECK(simulation_setAxisParameter(1, 31, AXIS1_PRESSURE));
+
+	uint32_t breaths = 0;
+	int32_t maxPressure0 = 0;
+	int32_t minPressure1 = INT32_MAX;
+	int32_t maxPressure1 = 0;
+	bool isAxis0Scheduled = false;
+	bool isAxis1Scheduled = false;
+	bool isAxis1FlowFeedForward = false;
+	uint8_t lastState = TOSV_STATE_STOPPED;
+	for (int i = 0; i < 15000; i++)
+	{
+		simulation_tick();
+
+		uint8_t state = simulation_getAxisParameter(0, 101);
+		if ((state == TOSV_STATE_INHALATION_RISE) && (lastState != TOSV_STATE_INHALATION_RISE))
+			breaths++;
+		lastState = state;
+
+		// settled after the startup
+		if (i < 5000)
+			continue;
+
+		int32_t pressure0 = simulation_getAxisParameter(0, 33);
+		int32_t pressure1 = simulation_getAxisParameter(1, 33);
+		if (pressure0 > maxPressure0)
+			maxPressure0 = pressure0;
+		if (pressure1 < minPressure1)
+			minPressure1 = pressure1;
+		if (pressure1 > maxPressure1)
+			maxPressure1 = pressure1;
+
+		isAxis0Scheduled |= (simulation_getAxisParameter(0, 79) == 200 + 20*state);
+		isAxis1Scheduled |= (simulation_getAxisParameter(1, 79) != axis1PressureP);
+		isAxis1FlowFeedForward |= (simulation_getAxisParameter(1, 73) != (FF_PRESSURE_GAIN * AXIS1_PRESSURE) >> 10);
+	}
+
+	printf("axis 0: %d breaths, peak pressure %d Pa\n", breaths, maxPressure0);
+	printf("axis 1: pressure %d..%d Pa (target %d Pa)\n", minPressure1, maxPressure1, AXIS1_PRESSURE);
+
+	// axis 0 ventilates with its gain schedule
+	CHECK(breaths >= 3);
+	CHECK(abs(maxPressure0 - PIP) < 200);
+	CHECK(isAxis0Scheduled);
+
+	// axis 1 holds its pressure with fixed gains and the pressure part of the feed forward only
+	CHECK(abs(minPressure1 - AXIS1_PRESSURE) < 100);
+	CHECK(abs(maxPressure1 - AXIS1_PRESSURE) < 100);
+	CHECK(!isAxis1Scheduled);
+	CHECK(!isAxis1FlowFeedForward);
+
+	return NULL;
+}
+
+int main()
+{
+	pthread_t thread;
+	pthread_create(&thread, NULL, runTwoAxes, NULL);
+	pthread_join(thread, NULL);
+
+	return TEST_RESULT();
+}
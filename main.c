@@ -31,12 +31,13 @@ int main(void)
 	tmcm_initModuleConfig();
 	tmcm_initMotorConfig();
 
-	// initialize periphery
-	tmcm_initModuleSpecificIO();
-	tmcm_initModuleSpecificADC();
-
 	// initialize hal functionality
 	systick_init();
+	systemInfo_initCycleCounter();
+
+	// initialize periphery (ADC trigger is synchronized to the SysTick)
+	tmcm_initModuleSpecificIO();
+	tmcm_initModuleSpecificADC();
 
 	spi_init();
 	eeprom_initConfig();